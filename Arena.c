@@ -0,0 +1,122 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./Arena.h"
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "libhw1/CSE333.h"
+
+// The usual size of a chunk's data.  Allocations bigger than this get a
+// chunk of their own.
+#define ARENA_CHUNK_BYTES (64 * 1024)
+
+// Every allocation is rounded up to a multiple of this, which keeps them
+// all aligned for any type.
+#define ARENA_ALIGNMENT (alignof(max_align_t))
+
+// A chunk of memory that allocations are carved out of.  Its data
+// immediately follows the header.
+typedef struct chunk_st {
+  struct chunk_st* next;   // the next chunk in the arena, or NULL
+  size_t           bytes;  // the size of the chunk's data
+  alignas(max_align_t) unsigned char data[];
+} Chunk;
+
+struct arena_st {
+  Chunk* head;   // the first chunk, or NULL if there are none yet
+  Chunk* cur;    // the chunk being allocated from, or NULL if none yet
+  size_t used;   // how many bytes of "cur" have been allocated
+  size_t bytes;  // how many bytes the chunks take up, headers included
+};
+
+Arena* Arena_Allocate(void) {
+  Arena* arena = (Arena*) malloc(sizeof(Arena));
+  Verify333(arena != NULL);
+  arena->head = arena->cur = NULL;
+  arena->used = arena->bytes = 0;
+  return arena;
+}
+
+void Arena_Free(Arena* arena) {
+  Chunk* chunk = arena->head;
+  while (chunk != NULL) {
+    Chunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  free(arena);
+}
+
+void* Arena_Alloc(Arena* arena, size_t bytes) {
+  Chunk* chunk;
+  void* result;
+
+  bytes = (bytes + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+  if (arena->cur != NULL && bytes <= arena->cur->bytes - arena->used) {
+    // The common case: bump the pointer.
+    result = arena->cur->data + arena->used;
+    arena->used += bytes;
+    return result;
+  }
+
+  // Move on to the next chunk, if we kept one from before the last reset
+  // and it's big enough; otherwise, slot a new one in after the current
+  // one.  (Either way, whatever's left at the end of the current chunk
+  // goes unused until the next reset.)
+  chunk = (arena->cur != NULL) ? arena->cur->next : arena->head;
+  if (chunk == NULL || chunk->bytes < bytes) {
+    size_t chunk_bytes = (bytes > ARENA_CHUNK_BYTES)
+                         ? bytes : ARENA_CHUNK_BYTES;
+    Chunk* new_chunk = (Chunk*) malloc(sizeof(Chunk) + chunk_bytes);
+    Verify333(new_chunk != NULL);
+    new_chunk->bytes = chunk_bytes;
+    new_chunk->next = chunk;
+    arena->bytes += sizeof(Chunk) + chunk_bytes;
+    if (arena->cur != NULL) {
+      arena->cur->next = new_chunk;
+    } else {
+      arena->head = new_chunk;
+    }
+    chunk = new_chunk;
+  }
+  arena->cur = chunk;
+  arena->used = bytes;
+  return chunk->data;
+}
+
+void Arena_Reset(Arena* arena) {
+  Chunk* chunk = arena->head;
+
+  // Keep one ordinary-sized chunk, if there is one, and free the rest.
+  arena->head = NULL;
+  arena->bytes = 0;
+  while (chunk != NULL) {
+    Chunk* next = chunk->next;
+    if (arena->head == NULL && chunk->bytes == ARENA_CHUNK_BYTES) {
+      chunk->next = NULL;
+      arena->head = chunk;
+      arena->bytes = sizeof(Chunk) + chunk->bytes;
+    } else {
+      free(chunk);
+    }
+    chunk = next;
+  }
+  arena->cur = NULL;
+  arena->used = 0;
+}
+
+size_t Arena_Bytes(const Arena* arena) {
+  return arena->bytes;
+}
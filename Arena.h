@@ -0,0 +1,50 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW2_ARENA_H_
+#define HW2_ARENA_H_
+
+#include <stddef.h>  // for size_t
+
+// An Arena is a bump allocator, for lots of small allocations that all
+// die at the same time (such as everything parsed out of one file).
+// Allocating is usually just advancing a pointer, and there's no way to
+// free a single allocation: Arena_Reset() frees all of them at once.
+//
+// The Arena gets its memory from malloc() in large chunks.  It keeps one
+// ordinary-sized chunk across Arena_Reset(), so an Arena that's reused
+// for one small file after another rarely calls malloc(), and gives the
+// rest back; that way one big file doesn't pin its memory in every
+// Arena it ever passed through.
+//
+// An Arena isn't thread-safe; each thread should allocate from its own.
+typedef struct arena_st Arena;
+
+// Allocates and returns a new, empty Arena.  Never returns NULL.
+Arena* Arena_Allocate(void);
+
+// Frees "arena", and everything allocated from it.
+void Arena_Free(Arena* arena);
+
+// Returns "bytes" bytes of uninitialized memory from "arena", aligned
+// for any type.  Never returns NULL.  The memory stays valid until the
+// next Arena_Reset() or Arena_Free() of "arena".
+void* Arena_Alloc(Arena* arena, size_t bytes);
+
+// Frees everything allocated from "arena", keeping its first chunk for
+// the allocations that follow.
+void Arena_Reset(Arena* arena);
+
+// Returns how many bytes of memory "arena" currently holds, counting
+// chunk space that hasn't been allocated yet.
+size_t Arena_Bytes(const Arena* arena);
+
+#endif  // HW2_ARENA_H_
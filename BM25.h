@@ -0,0 +1,64 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_BM25_H_
+#define HW3_BM25_H_
+
+#include <cmath>  // for std::log().
+
+namespace hw3 {
+
+// Okapi BM25 scores a document d against a query as the sum, over the
+// query's words w, of
+//
+//   IDF(w) * tf(w, d) * (k1 + 1)
+//            / (tf(w, d) + k1 * (1 - b + b * |d| / avgdl))
+//
+// where tf(w, d) is the number of times w appears in d, |d| is the number
+// of words in d, and avgdl is the average of |d| over the index.  The
+// factor after IDF(w) is the "term frequency score"; it grows with
+// tf(w, d) but saturates at k1 + 1, and is discounted for long documents.
+//
+// WriteIndex() stores each word's largest term frequency score in its
+// posting list, computed with these constants, so changing them means
+// rewriting the index files.
+static constexpr double kBM25K1 = 1.2;
+static constexpr double kBM25B = 0.75;
+
+// The largest value BM25TermFrequencyScore() can take.
+static constexpr double kBM25MaxTermFrequencyScore = kBM25K1 + 1;
+
+// Returns the term frequency score of a word that appears "tf" times in
+// a document of "doc_length" words, in an index whose documents average
+// "avg_doc_length" words.
+inline double BM25TermFrequencyScore(double tf, double doc_length,
+                                     double avg_doc_length) {
+  double norm = 1 - kBM25B + kBM25B * doc_length / avg_doc_length;
+  return tf * (kBM25K1 + 1) / (tf + kBM25K1 * norm);
+}
+
+// Returns the inverse document frequency of a word that appears in
+// "doc_freq" of an index's "num_docs" documents.  This is the variant
+// that never goes negative, even for words in most of the documents.
+inline double BM25InverseDocFrequency(double doc_freq, double num_docs) {
+  return std::log(1 + (num_docs - doc_freq + 0.5) / (doc_freq + 0.5));
+}
+
+// Returns the average document length to score an index with, given its
+// document count and total length.  Empty indices get 1, so that scoring
+// never divides by zero.
+inline double BM25AverageDocLength(double num_docs, double total_words) {
+  return (num_docs > 0 && total_words > 0) ? total_words / num_docs : 1;
+}
+
+}  // namespace hw3
+
+#endif  // HW3_BM25_H_
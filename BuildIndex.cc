@@ -0,0 +1,118 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./BuildIndex.h"
+
+#include <unistd.h>  // for unlink().
+#include <string>    // for std::string, std::to_string().
+#include <vector>    // for std::vector.
+
+extern "C" {
+  #include "libhw2/CrawlFileTreeParallel.h"
+  #include "libhw2/DocTable.h"
+  #include "libhw2/MemIndex.h"
+}
+#include "./WriteIndex.h"
+#include "./WriteIndexRuns.h"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+namespace hw3 {
+
+// What the spill callback needs: where the runs go, and the names of the
+// ones written so far.
+struct SpillState {
+  string base_name;
+  vector<string> run_files;
+};
+
+// A CrawlSpillFn that writes "index" out as the next run file.
+static bool SpillRun(MemIndex* index, void* arg) {
+  SpillState* state = static_cast<SpillState*>(arg);
+  string run_file = state->base_name + ".run" +
+                    to_string(state->run_files.size());
+
+  // Note the run before writing it, so that it's cleaned up even if the
+  // write fails partway.
+  state->run_files.push_back(run_file);
+  return WriteIndexRun(index, run_file.c_str()) >= 0;
+}
+
+// A CrawlFilterFn that hands each file to the BuildIndexOptions' filter.
+static bool FilterFile(const char* file_path, const struct stat* st,
+                       void* arg) {
+  const BuildIndexOptions* options = static_cast<BuildIndexOptions*>(arg);
+  return options->filter(file_path, *st);
+}
+
+int BuildIndex(char* root_dir, int num_workers, size_t memory_budget,
+               const char* file_name) {
+  return BuildIndex(root_dir, num_workers, memory_budget,
+                    BuildIndexOptions(), file_name);
+}
+
+int BuildIndex(char* root_dir, int num_workers, size_t memory_budget,
+               const BuildIndexOptions& options, const char* file_name) {
+  SpillState state;
+  state.base_name = file_name;
+  CrawlOptions crawl_options = CrawlOptions();
+  crawl_options.memory_budget = memory_budget;
+  crawl_options.spill_fn = &SpillRun;
+  crawl_options.spill_arg = &state;
+  if (options.filter) {
+    crawl_options.filter_fn = &FilterFile;
+    crawl_options.filter_arg = const_cast<BuildIndexOptions*>(&options);
+  }
+  vector<char*> paths;
+  for (const string& path : options.paths) {
+    paths.push_back(const_cast<char*>(path.c_str()));
+  }
+  if (!paths.empty()) {
+    crawl_options.paths = paths.data();
+    crawl_options.num_paths = paths.size();
+  }
+  DocTable* dt;
+  MemIndex* mi;
+  if (!CrawlFileTreeParallelWithOptions(root_dir, num_workers,
+                                        &crawl_options, &dt, &mi)) {
+    for (const string& run_file : state.run_files) {
+      unlink(run_file.c_str());
+    }
+    return -1;
+  }
+
+  if (options.finish_doc_table) {
+    options.finish_doc_table(dt);
+  }
+
+  int result;
+  if (state.run_files.empty()) {
+    // It all fit.
+    result = WriteIndex(mi, dt, file_name);
+  } else {
+    // Spill whatever's left over, and merge all of the runs.
+    result = -1;
+    if (MemIndex_NumWords(mi) == 0 || SpillRun(mi, &state)) {
+      result = MergeIndexRuns(state.run_files, dt, file_name);
+    }
+  }
+
+  for (const string& run_file : state.run_files) {
+    unlink(run_file.c_str());
+  }
+  MemIndex_Free(mi);
+  DocTable_Free(dt);
+  return result;
+}
+
+}  // namespace hw3
@@ -0,0 +1,71 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_BUILDINDEX_H_
+#define HW3_BUILDINDEX_H_
+
+#include <stddef.h>    // for size_t.
+#include <sys/stat.h>  // for struct stat.
+#include <functional>  // for std::function.
+#include <string>      // for std::string.
+#include <vector>      // for std::vector.
+
+extern "C" {
+  #include "libhw2/DocTable.h"
+}
+
+namespace hw3 {
+
+// Crawls "root_dir" with "num_workers" tokenizing threads (see
+// CrawlFileTreeParallel()) and writes the resulting index to "file_name",
+// keeping the MemIndex within roughly "memory_budget" bytes.
+//
+// Each time the MemIndex outgrows the budget it's written out as a run
+// file (see WriteIndexRuns.h) next to "file_name", named "file_name.run0",
+// "file_name.run1", and so on, and the runs are merged into "file_name"
+// at the end.  The result is the same index file that WriteIndex() would
+// have written for the whole crawl.  If nothing was spilled, the MemIndex
+// is simply written with WriteIndex().  Either way, the run files are
+// removed before returning.
+//
+// The budget covers only the MemIndex: the DocTable, and a few dozen
+// bytes per distinct word during the merge, stay in memory regardless.
+// A budget of 0 means there's no limit.
+//
+// Returns the number of bytes written to "file_name", or a negative value
+// on failure.
+int BuildIndex(char* root_dir, int num_workers, size_t memory_budget,
+               const char* file_name);
+
+// Optional hooks into BuildIndex().
+struct BuildIndexOptions {
+  // If set, only the files that "filter" returns true for are indexed.
+  // It's called with each regular file of the crawl, in crawl order, as
+  // a CrawlFilterFn is (see CrawlFileTreeParallel.h).
+  std::function<bool(const char* file_path, const struct stat& st)> filter;
+
+  // If not empty, only these paths under the root directory are crawled,
+  // as for CrawlOptions' paths (see CrawlFileTreeParallel.h).
+  std::vector<std::string> paths;
+
+  // If set, called with the DocTable once the crawl is over, just before
+  // the index is written.  It may add documents to the DocTable, which
+  // the index then lists with no words.
+  std::function<void(DocTable* dt)> finish_doc_table;
+};
+
+// Like BuildIndex() above, with the hooks in "options".
+int BuildIndex(char* root_dir, int num_workers, size_t memory_budget,
+               const BuildIndexOptions& options, const char* file_name);
+
+}  // namespace hw3
+
+#endif  // HW3_BUILDINDEX_H_
@@ -23,6 +23,7 @@
 #include "libhw1/CSE333.h"
 #include "./DocTable.h"
 #include "./FileParser.h"
+#include "./WordPositionArray.h"
 
 //////////////////////////////////////////////////////////////////////////////
 // Internal helper functions and constants
@@ -52,11 +53,17 @@ int alphasort(const void* v1, const void* v2) {
 // to generate consistent DocTables and MemIndices, we do two passes over the
 // contents: the first to extract the data necessary for populating
 // entry_name_st and the second to actually handle the recursive call.
-static void HandleDir(char* dir_path, DIR* d,
+//
+// "arena" is scratch space for HandleFile(), shared by every file of the
+// crawl.
+static void HandleDir(char* dir_path, DIR* d, Arena* arena,
                       DocTable** doc_table, MemIndex** index);
 
 // Read and parse the specified file, then inject it into the MemIndex.
-static void HandleFile(char* file_path, DocTable** doc_table, MemIndex** index);
+// The file's word table is allocated from "arena", which is reset
+// afterwards.
+static void HandleFile(char* file_path, Arena* arena,
+                       DocTable** doc_table, MemIndex** index);
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -66,6 +73,7 @@ static void HandleFile(char* file_path, DocTable** doc_table, MemIndex** index);
 bool CrawlFileTree(char* root_dir, DocTable** doc_table, MemIndex** index) {
   struct stat root_stat;
   DIR *rd;
+  Arena* arena;
 
   // Verify we got some valid args.
   if (root_dir == NULL || doc_table == NULL || index == NULL) {
@@ -96,10 +104,13 @@ bool CrawlFileTree(char* root_dir, DocTable** doc_table, MemIndex** index) {
   *index = MemIndex_Allocate();
   Verify333(*index != NULL);
 
+  arena = Arena_Allocate();
+
   // Begin the recursive handling of the directory.
-  HandleDir(root_dir, rd, doc_table, index);
+  HandleDir(root_dir, rd, arena, doc_table, index);
 
   // All done.  Release and/or transfer ownership of resources.
+  Arena_Free(arena);
   Verify333(closedir(rd) == 0);
   return true;
 }
@@ -109,7 +120,8 @@ bool CrawlFileTree(char* root_dir, DocTable** doc_table, MemIndex** index) {
 // Internal helper functions
 //////////////////////////////////////////////////////////////////////////////
 
-static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
+static void HandleDir(char* dir_path, DIR* d, Arena* arena,
+                      DocTable** doc_table,
                       MemIndex** index) {
   // We make two passes through the directory.  The first gets the list of
   // all the metadata necessary to process its entries; the second iterates
@@ -204,11 +216,11 @@ static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
   // Second pass, processing the now-sorted directory metadata.
   for (i = 0; i < num_entries; i++) {
     if (!entries[i].is_dir) {
-      HandleFile(entries[i].path_name, doc_table, index);
+      HandleFile(entries[i].path_name, arena, doc_table, index);
     } else {
       DIR *sub_dir = opendir(entries[i].path_name);
       if (sub_dir != NULL) {
-        HandleDir(entries[i].path_name, sub_dir, doc_table, index);
+        HandleDir(entries[i].path_name, sub_dir, arena, doc_table, index);
         closedir(sub_dir);
       }
     }
@@ -219,20 +231,22 @@ static void HandleDir(char* dir_path, DIR* d, DocTable** doc_table,
   free(entries);
 }
 
-static void HandleFile(char* file_path, DocTable** doc_table,
-                        MemIndex** index) {
+static void HandleFile(char* file_path, Arena* arena,
+                       DocTable** doc_table, MemIndex** index) {
   int file_len = 0;
   HashTable* tab = NULL;
   DocID_t doc_id;
   HTIterator* it;
 
   // STEP 4.
-  // Invoke ParseIntoWordPositionsTable() to build the word hashtable out
+  // Invoke ParseIntoWordPositionArrays() to build the word hashtable out
   // of the file.
    char* file = ReadFileToString(file_path, &file_len);
-   tab = ParseIntoWordPositionsTable(file);
+   tab = ParseIntoWordPositionArrays(file, arena);
 
   if(tab == NULL){
+    // A file we gave up on part way through may have left words behind.
+    Arena_Reset(arena);
     return;
   }
 
@@ -241,28 +255,25 @@ static void HandleFile(char* file_path, DocTable** doc_table,
   doc_id = DocTable_Add(*doc_table, file_path);
 
     // STEP 6.
-    // Use HTIterator_Remove() to extract the next WordPositions structure out
-    // of the hashtable. Then, use MemIndex_AddPostingList() to add the word,
-    // document ID, and positions linked list into the inverted index.
+    // Use HTIterator_Remove() to extract the next WordPositionArray out of
+    // the hashtable. Then, use MemIndex_AddWordPositionArray() to copy the
+    // word, document ID, and positions into the inverted index.
     it = HTIterator_Allocate(tab);
     Verify333(it != NULL);
     while (HTIterator_IsValid(it)) {
-    WordPositions* wp;
     HTKeyValue_t kv;
 
-    // Since we've transferred ownership of the memory associated with both
-    // the "word" and "positions" field of this WordPositions structure, and
-    // since we've removed it from the table, we can now free the
-    // WordPositions structure!
+    // The WordPositionArray stays in the arena; the index copied what it
+    // needs.
     HTIterator_Remove(it, &kv);
-    wp = kv.value;
-    MemIndex_AddPostingList(*index, wp->word, doc_id, wp->positions);
-
-    free(wp);
+    MemIndex_AddWordPositionArray(*index, (WordPositionArray*) kv.value,
+                                  doc_id);
   }
   HTIterator_Free(it);
 
   // We're all done with the word hashtable for this file, since we've added
-  // all of its contents to the inverted index. Free the table and return.
-  FreeWordPositionsTable(tab);
+  // all of its contents to the inverted index. Free the table and throw
+  // away everything it held in one go.
+  FreeWordPositionArrays(tab);
+  Arena_Reset(arena);
 }
@@ -0,0 +1,518 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./CrawlFileTreeParallel.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "libhw1/CSE333.h"
+#include "./DocTable.h"
+#include "./FileParser.h"
+#include "./WordPositionArray.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Internal helper functions and constants
+//////////////////////////////////////////////////////////////////////////////
+#define MAX_PATHNAME_LENGTH 1024  // max len of a directory item's path + name
+
+// How many files, per worker thread, may be in flight (discovered by the
+// walker but not yet added to the index) at once.  This bounds how many
+// parsed-but-uncommitted word tables we hold in memory when the
+// committing thread falls behind the workers.
+#define JOBS_PER_WORKER 8
+
+struct entry_st {
+  char *path_name;
+  bool is_dir;
+  struct stat st;
+};
+
+// The life cycle of one file as it moves through the pipeline.
+typedef enum {
+  JOB_QUEUED,   // found by the walker; waiting for a worker
+  JOB_PARSING,  // claimed by a worker
+  JOB_PARSED    // parsed; waiting for the committer
+} JobState;
+
+typedef struct {
+  char      *file_path;  // owned by the job until it's committed
+  HashTable *tab;        // the file's WordPositionArray table, or NULL
+  JobState   state;
+  Arena     *arena;      // the slot's own; "tab" is allocated from it
+} CrawlJob;
+
+// The state shared by the walker, the workers, and the committer.
+//
+// Jobs are numbered in the order that the walker discovers files, which
+// is exactly CrawlFileTree()'s order.  They live in a ring of
+// "window" slots: job n is in jobs[n % window].  Every job numbered in
+// [num_committed, num_queued) is in the ring, and the workers claim them
+// in order, so num_committed <= num_claimed <= num_queued at all times.
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t  job_queued;    // signaled by the walker
+  pthread_cond_t  job_parsed;    // signaled by the workers
+  pthread_cond_t  job_committed; // signaled by the committer
+
+  CrawlJob *jobs;
+  int       window;
+  uint64_t  num_queued;
+  uint64_t  num_claimed;
+  uint64_t  num_committed;
+  bool      walk_done;
+  size_t    arena_bytes;  // how much memory the slots' arenas hold
+
+  char *root_dir;
+  DIR  *root;
+  const CrawlOptions *options;
+} CrawlPipeline;
+
+// Return the relative ordering of two entries, according to the signature
+// required by "man 3 qsort".  This must order entries exactly as
+// CrawlFileTree.c's comparator does.
+static int EntryCompare(const void* v1, const void* v2);
+
+// The walker thread's body.  Walks the tree rooted at "root_dir", in
+// CrawlFileTree()'s order, queueing each regular file as a job.  If the
+// options list paths, it walks just those instead.
+static void* WalkerMain(void* arg);
+
+// Queues "path", if it's a regular file the options' filter lets
+// through, or walks it, if it's a directory.
+static void WalkPath(CrawlPipeline* p, char* path);
+
+// Recursively descends into the passed-in directory, queueing the files
+// it contains.  This is HandleDir() from CrawlFileTree.c, except that
+// instead of handling each file it finds it hands it off to QueueFile(),
+// if the options' filter lets it through.
+static void WalkDir(CrawlPipeline* p, char* dir_path, DIR* d);
+
+// Appends a job for "file_path" to the ring, blocking while the ring is
+// full.  Takes ownership of "file_path".
+static void QueueFile(CrawlPipeline* p, char* file_path);
+
+// A worker thread's body.  Repeatedly claims the oldest unclaimed job and
+// reads and parses its file, until the walker is done and there are no
+// jobs left to claim.
+static void* WorkerMain(void* arg);
+
+// Copies the contents of a file's WordPositionArray table into the index
+// under a freshly-assigned docID, as HandleFile() does, then frees the
+// table and resets the arena it was allocated from.  Returns an estimate
+// of how many bytes of memory the index grew by.
+static size_t CommitFile(char* file_path, HashTable* tab, Arena* arena,
+                         DocTable* doc_table, MemIndex* index);
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Externally-exported functions
+//////////////////////////////////////////////////////////////////////////////
+
+bool CrawlFileTreeParallel(char* root_dir, int num_workers,
+                           DocTable** doc_table, MemIndex** index) {
+  CrawlOptions options = {0};
+  return CrawlFileTreeParallelWithOptions(root_dir, num_workers, &options,
+                                          doc_table, index);
+}
+
+bool CrawlFileTreeParallelWithOptions(char* root_dir, int num_workers,
+                                      const CrawlOptions* options,
+                                      DocTable** doc_table, MemIndex** index) {
+  struct stat root_stat;
+  CrawlPipeline p;
+  pthread_t walker;
+  pthread_t* workers;
+  size_t index_bytes = 0;
+  bool ok = true;
+  int i;
+
+  // Verify we got some valid args.
+  if (root_dir == NULL || options == NULL || doc_table == NULL
+      || index == NULL || num_workers <= 0
+      || (options->memory_budget > 0 && options->spill_fn == NULL)) {
+    return false;
+  }
+
+  // Verify that rootdir is a directory we can open.
+  if (stat((char*) root_dir, &root_stat) == -1) {
+    return false;
+  }
+  if (!S_ISDIR(root_stat.st_mode)) {
+    return false;
+  }
+  p.root = opendir(root_dir);
+  if (p.root == NULL) {
+    return false;
+  }
+
+  // Since we're able to open the directory, allocate our objects.
+  *doc_table = DocTable_Allocate();
+  Verify333(*doc_table != NULL);
+  *index = MemIndex_Allocate();
+  Verify333(*index != NULL);
+
+  // Set up the pipeline.
+  p.window = num_workers * JOBS_PER_WORKER;
+  p.jobs = (CrawlJob*) malloc(sizeof(CrawlJob) * p.window);
+  Verify333(p.jobs != NULL);
+  for (i = 0; i < p.window; i++) {
+    p.jobs[i].arena = Arena_Allocate();
+  }
+  p.num_queued = p.num_claimed = p.num_committed = 0;
+  p.walk_done = false;
+  p.arena_bytes = 0;
+  p.root_dir = root_dir;
+  p.options = options;
+  Verify333(pthread_mutex_init(&p.lock, NULL) == 0);
+  Verify333(pthread_cond_init(&p.job_queued, NULL) == 0);
+  Verify333(pthread_cond_init(&p.job_parsed, NULL) == 0);
+  Verify333(pthread_cond_init(&p.job_committed, NULL) == 0);
+
+  // Start the walker and the workers.
+  Verify333(pthread_create(&walker, NULL, &WalkerMain, &p) == 0);
+  workers = (pthread_t*) malloc(sizeof(pthread_t) * num_workers);
+  Verify333(workers != NULL);
+  for (i = 0; i < num_workers; i++) {
+    Verify333(pthread_create(&workers[i], NULL, &WorkerMain, &p) == 0);
+  }
+
+  // This thread is the committer: it waits for each job, in order, to be
+  // parsed, and then adds it to the index.  Because only this thread
+  // touches the DocTable and MemIndex, and it does so in crawl order,
+  // docIDs are assigned exactly as CrawlFileTree() assigns them.  It's
+  // also the thread that spills the MemIndex when it gets too big.
+  Verify333(pthread_mutex_lock(&p.lock) == 0);
+  while (true) {
+    CrawlJob* job;
+    char* file_path;
+    HashTable* tab;
+    Arena* arena;
+    size_t arena_bytes, held_bytes;
+
+    while (p.num_committed < p.num_queued
+           ? p.jobs[p.num_committed % p.window].state != JOB_PARSED
+           : !p.walk_done) {
+      Verify333(pthread_cond_wait(&p.job_parsed, &p.lock) == 0);
+    }
+    if (p.num_committed == p.num_queued) {
+      // The walk is over, and everything it found has been committed.
+      break;
+    }
+
+    // Commit the job without holding the lock, so that the walker and
+    // workers can keep going in the meantime.  Nobody else touches a
+    // parsed job, and its slot can't be reused until we release it.
+    job = &p.jobs[p.num_committed % p.window];
+    file_path = job->file_path;
+    tab = job->tab;
+    arena = job->arena;
+    arena_bytes = p.arena_bytes;
+    Verify333(pthread_mutex_unlock(&p.lock) == 0);
+
+    // The files parsed but not yet committed are held in memory as well,
+    // so their arenas count against the budget too.  But the ring's
+    // arenas don't shrink when the MemIndex is spilled, so they get at
+    // most half of the budget; otherwise a small budget would spill the
+    // MemIndex after every file.
+    held_bytes = Arena_Bytes(arena);
+    if (arena_bytes > options->memory_budget / 2) {
+      arena_bytes = options->memory_budget / 2;
+    }
+    if (ok) {
+      index_bytes += CommitFile(file_path, tab, arena, *doc_table, *index);
+      if (options->memory_budget > 0
+          && index_bytes + arena_bytes >= options->memory_budget) {
+        ok = options->spill_fn(*index, options->spill_arg);
+        MemIndex_Free(*index);
+        *index = MemIndex_Allocate();
+        Verify333(*index != NULL);
+        index_bytes = 0;
+      }
+    } else {
+      // The walker and workers don't know the crawl has failed, so keep
+      // draining their jobs until they're done.
+      if (tab != NULL) {
+        FreeWordPositionArrays(tab);
+      }
+      Arena_Reset(arena);
+    }
+    free(file_path);
+
+    Verify333(pthread_mutex_lock(&p.lock) == 0);
+    p.arena_bytes -= held_bytes - Arena_Bytes(arena);
+    p.num_committed++;
+    Verify333(pthread_cond_signal(&p.job_committed) == 0);
+  }
+  Verify333(pthread_mutex_unlock(&p.lock) == 0);
+
+  // All done.  Reap the threads and release our resources.
+  Verify333(pthread_join(walker, NULL) == 0);
+  for (i = 0; i < num_workers; i++) {
+    Verify333(pthread_join(workers[i], NULL) == 0);
+  }
+  free(workers);
+  for (i = 0; i < p.window; i++) {
+    Arena_Free(p.jobs[i].arena);
+  }
+  free(p.jobs);
+  Verify333(pthread_cond_destroy(&p.job_committed) == 0);
+  Verify333(pthread_cond_destroy(&p.job_parsed) == 0);
+  Verify333(pthread_cond_destroy(&p.job_queued) == 0);
+  Verify333(pthread_mutex_destroy(&p.lock) == 0);
+  Verify333(closedir(p.root) == 0);
+  if (!ok) {
+    DocTable_Free(*doc_table);
+    MemIndex_Free(*index);
+    *doc_table = NULL;
+    *index = NULL;
+  }
+  return ok;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Internal helper functions
+//////////////////////////////////////////////////////////////////////////////
+
+static int EntryCompare(const void* v1, const void* v2) {
+  struct entry_st* e1 = (struct entry_st*) v1,
+    *e2 = (struct entry_st*) v2;
+  return strncmp(e1->path_name, e2->path_name, MAX_PATHNAME_LENGTH);
+}
+
+static void* WalkerMain(void* arg) {
+  CrawlPipeline* p = (CrawlPipeline*) arg;
+  int i;
+
+  if (p->options->paths == NULL) {
+    WalkDir(p, p->root_dir, p->root);
+  } else {
+    for (i = 0; i < p->options->num_paths; i++) {
+      WalkPath(p, p->options->paths[i]);
+    }
+  }
+
+  // Let the workers and the committer know that no more jobs are coming.
+  Verify333(pthread_mutex_lock(&p->lock) == 0);
+  p->walk_done = true;
+  Verify333(pthread_cond_broadcast(&p->job_queued) == 0);
+  Verify333(pthread_cond_broadcast(&p->job_parsed) == 0);
+  Verify333(pthread_mutex_unlock(&p->lock) == 0);
+  return NULL;
+}
+
+static void WalkPath(CrawlPipeline* p, char* path) {
+  struct stat st;
+  DIR* d;
+  char* file_path;
+  int path_len;
+
+  if (stat(path, &st) != 0) {
+    return;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    d = opendir(path);
+    if (d != NULL) {
+      WalkDir(p, path, d);
+      closedir(d);
+    }
+  } else if (S_ISREG(st.st_mode)
+             && (p->options->filter_fn == NULL
+                 || p->options->filter_fn(path, &st,
+                                          p->options->filter_arg))) {
+    path_len = strlen(path) + 1;
+    file_path = (char*) malloc(path_len * sizeof(char));
+    Verify333(file_path != NULL);
+    snprintf(file_path, path_len, "%s", path);
+    QueueFile(p, file_path);
+  }
+}
+
+static void WalkDir(CrawlPipeline* p, char* dir_path, DIR* d) {
+  // As in HandleDir(), we make two passes through the directory: the first
+  // gathers and sorts its entries, and the second descends into them.
+  int entries_capacity = 16;
+  struct entry_st* entries = (struct entry_st*)
+      malloc(sizeof(struct entry_st) * entries_capacity);
+  Verify333(entries != NULL);
+
+  int i, num_entries = 0;
+  int path_name_len;
+  struct dirent* dirent;
+  struct stat st;
+
+  // First pass, to populate the "entries" list of item metadata.
+  while ((dirent = readdir(d)) != NULL) {
+    char* path_name;
+
+    if (strcmp(dirent->d_name, ".") == 0 || strcmp(dirent->d_name, "..") == 0) {
+      continue;
+    }
+
+    // Build the entry's full path name: dirpath + "/" + d_name + '\0'.
+    path_name_len = strlen(dir_path) + 1 + strlen(dirent->d_name) + 1;
+    path_name = (char*) malloc(path_name_len * sizeof(char));
+    Verify333(path_name != NULL);
+    if (dir_path[strlen(dir_path)-1] == '/') {
+      snprintf(path_name, path_name_len, "%s%s", dir_path, dirent->d_name);
+    } else {
+      snprintf(path_name, path_name_len, "%s/%s", dir_path, dirent->d_name);
+    }
+
+    // Keep only regular files and directories; CrawlFileTree() never
+    // produces a docID for anything else.
+    if (stat(path_name, &st) != 0
+        || (!S_ISREG(st.st_mode) && !S_ISDIR(st.st_mode))) {
+      free(path_name);
+      continue;
+    }
+
+    // Resize the entries array if it's too small.
+    if (num_entries == entries_capacity) {
+      entries_capacity *= 2;
+      entries = (struct entry_st*)
+        realloc(entries, sizeof(struct entry_st) * entries_capacity);
+      Verify333(entries != NULL);
+    }
+    entries[num_entries].path_name = path_name;
+    entries[num_entries].is_dir = S_ISDIR(st.st_mode);
+    entries[num_entries].st = st;
+    num_entries++;
+  }  // end iteration over directory contents ("first pass").
+
+  // Sort the directory's metadata alphabetically.
+  qsort(entries, num_entries, sizeof(struct entry_st), &EntryCompare);
+
+  // Second pass, processing the now-sorted directory metadata.  Queued
+  // files take ownership of their path names; we free the rest.
+  for (i = 0; i < num_entries; i++) {
+    if (!entries[i].is_dir) {
+      if (p->options->filter_fn == NULL
+          || p->options->filter_fn(entries[i].path_name, &entries[i].st,
+                                   p->options->filter_arg)) {
+        QueueFile(p, entries[i].path_name);
+      } else {
+        free(entries[i].path_name);
+      }
+    } else {
+      DIR *sub_dir = opendir(entries[i].path_name);
+      if (sub_dir != NULL) {
+        WalkDir(p, entries[i].path_name, sub_dir);
+        closedir(sub_dir);
+      }
+      free(entries[i].path_name);
+    }
+  }
+  free(entries);
+}
+
+static void QueueFile(CrawlPipeline* p, char* file_path) {
+  CrawlJob* job;
+
+  Verify333(pthread_mutex_lock(&p->lock) == 0);
+  while (p->num_queued - p->num_committed == (uint64_t) p->window) {
+    Verify333(pthread_cond_wait(&p->job_committed, &p->lock) == 0);
+  }
+  job = &p->jobs[p->num_queued % p->window];
+  job->file_path = file_path;
+  job->tab = NULL;
+  job->state = JOB_QUEUED;
+  p->num_queued++;
+  Verify333(pthread_cond_signal(&p->job_queued) == 0);
+  Verify333(pthread_mutex_unlock(&p->lock) == 0);
+}
+
+static void* WorkerMain(void* arg) {
+  CrawlPipeline* p = (CrawlPipeline*) arg;
+
+  Verify333(pthread_mutex_lock(&p->lock) == 0);
+  while (true) {
+    CrawlJob* job;
+    char* file_path;
+    char* file;
+    int file_len = 0;
+    size_t held_bytes;
+    HashTable* tab;
+    Arena* arena;
+
+    while (p->num_claimed == p->num_queued && !p->walk_done) {
+      Verify333(pthread_cond_wait(&p->job_queued, &p->lock) == 0);
+    }
+    if (p->num_claimed == p->num_queued) {
+      // The walk is over and there's nothing left to claim.
+      break;
+    }
+    job = &p->jobs[p->num_claimed % p->window];
+    job->state = JOB_PARSING;
+    file_path = job->file_path;
+    arena = job->arena;
+    held_bytes = Arena_Bytes(arena);
+    p->num_claimed++;
+    Verify333(pthread_mutex_unlock(&p->lock) == 0);
+
+    // Read and tokenize the file; this is the expensive part, and the
+    // part that runs concurrently.  ParseIntoWordPositionArrays() frees
+    // "file" for us, and returns NULL if there's nothing to index.  Until
+    // the job is committed, its slot's arena is ours alone.
+    file = ReadFileToString(file_path, &file_len);
+    tab = ParseIntoWordPositionArrays(file, arena);
+
+    Verify333(pthread_mutex_lock(&p->lock) == 0);
+    job->tab = tab;
+    job->state = JOB_PARSED;
+    p->arena_bytes += Arena_Bytes(arena) - held_bytes;
+    Verify333(pthread_cond_broadcast(&p->job_parsed) == 0);
+  }
+  Verify333(pthread_mutex_unlock(&p->lock) == 0);
+  return NULL;
+}
+
+static size_t CommitFile(char* file_path, HashTable* tab, Arena* arena,
+                         DocTable* doc_table, MemIndex* index) {
+  DocID_t doc_id;
+  HTIterator* it;
+  size_t bytes = 0;
+
+  // Files that couldn't be read or parsed don't get a docID.  They may
+  // still have left words in the arena.
+  if (tab == NULL) {
+    Arena_Reset(arena);
+    return 0;
+  }
+
+  doc_id = DocTable_Add(doc_table, file_path);
+
+  // Copy each WordPositionArray into the inverted index; they all stay in
+  // the arena, which we're about to reset.
+  it = HTIterator_Allocate(tab);
+  Verify333(it != NULL);
+  while (HTIterator_IsValid(it)) {
+    HTKeyValue_t kv;
+
+    HTIterator_Remove(it, &kv);
+    bytes += MemIndex_AddWordPositionArray(
+        index, (WordPositionArray*) kv.value, doc_id);
+  }
+  HTIterator_Free(it);
+
+  FreeWordPositionArrays(tab);
+  Arena_Reset(arena);
+  return bytes;
+}
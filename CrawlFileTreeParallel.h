@@ -0,0 +1,116 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW2_CRAWLFILETREEPARALLEL_H_
+#define HW2_CRAWLFILETREEPARALLEL_H_
+
+#include <stdbool.h>    // for bool
+#include <stddef.h>     // for size_t
+#include <sys/stat.h>   // for struct stat
+
+#include "./DocTable.h"
+#include "./MemIndex.h"
+
+// A multi-threaded version of CrawlFileTree().
+//
+// One thread walks the directory tree, in exactly the order that
+// CrawlFileTree() does, handing each regular file it finds to a pool of
+// worker threads.  The workers read and tokenize files concurrently
+// (ReadFileToString() and ParseIntoWordPositionArrays()), and the
+// calling thread adds the resulting word tables to the DocTable and
+// MemIndex strictly in crawl order.  As a result, the DocTable and
+// MemIndex produced -- including every docID -- are identical to those
+// produced by CrawlFileTree().
+//
+// Arguments:
+// - root_dir: the name of the directory which is the root of the crawl.
+// - num_workers: the number of tokenizing threads to run; must be > 0.
+// - doc_table: an output parameter through which a populated DocTable
+//   is returned.  The caller takes responsibility for eventually
+//   calling DocTable_Free() to free memory associated with it.
+// - index: an output parameter through which a populated MemIndex is
+//   returned.  The caller takes responsibility for eventually calling
+//   MemIndex_Free() to free memory associated with it.
+//
+// Returns:
+// - false: if any kind of failure occurred.  In this case, the values of
+//   "doc_table" and "index" are undefined.
+// - true: if the crawl succeeded.
+bool CrawlFileTreeParallel(char* root_dir, int num_workers,
+                           DocTable** doc_table, MemIndex** index);
+
+// Called by CrawlFileTreeParallelWithOptions() with a MemIndex that has
+// outgrown the budget, for it to write out (see WriteIndexRun()).  The
+// crawl frees the MemIndex afterwards.  "arg" is the options' spill_arg.
+// Returns false on failure.
+typedef bool (*CrawlSpillFn)(MemIndex* index, void* arg);
+
+// Called by CrawlFileTreeParallelWithOptions() with each regular file it
+// finds, in crawl order, and the results of stat()ing it.  Returns true
+// if the file should be indexed.  "arg" is the options' filter_arg.  It's
+// called on the thread that walks the tree, so it may take its time
+// without holding up the workers, but it mustn't touch the DocTable or
+// MemIndex.
+typedef bool (*CrawlFilterFn)(const char* file_path, const struct stat* st,
+                              void* arg);
+
+// What CrawlFileTreeParallelWithOptions() does beyond what
+// CrawlFileTreeParallel() does.  Zero-initialize it, and then fill in
+// the fields you want.
+typedef struct {
+  // If not 0, keep the MemIndex within roughly "memory_budget" bytes:
+  // whenever adding a file takes it past that, the MemIndex is handed to
+  // "spill_fn", and the crawl carries on with a new, empty one.  The
+  // parsed files waiting to be added count against the budget too, but
+  // never for more than half of it.  The
+  // DocTable isn't spilled, so docIDs are still assigned exactly as
+  // CrawlFileTree() assigns them, and each spilled MemIndex holds every
+  // word of the files added to it.
+  size_t       memory_budget;
+  CrawlSpillFn spill_fn;
+  void*        spill_arg;
+
+  // If not NULL, only the files that "filter_fn" accepts are indexed.
+  // The others get no docID, just like files that can't be read.
+  CrawlFilterFn filter_fn;
+  void*         filter_arg;
+
+  // If not NULL, only the "num_paths" paths in "paths" are crawled,
+  // rather than the whole of "root_dir" (which must still be a
+  // directory).  Each path that's a regular file is handled just as the
+  // walk would handle it, each that's a directory is walked as a
+  // subdirectory would be, and each that doesn't exist is skipped.  They
+  // are crawled in the order given, so to keep a file from being
+  // indexed twice, none should lie beneath another.
+  char* const* paths;
+  int          num_paths;
+} CrawlOptions;
+
+// Like CrawlFileTreeParallel(), but as modified by "options" (see
+// above).
+//
+// Arguments:
+// - root_dir, num_workers, doc_table: as for CrawlFileTreeParallel().
+// - options: what to do differently; must not be NULL.
+// - index: an output parameter through which the MemIndex of the files
+//   added since the last spill (perhaps none) is returned.  The caller
+//   takes responsibility for eventually calling MemIndex_Free() on it.
+//
+// Returns:
+// - false: if any kind of failure occurred, including "spill_fn"
+//   failing.  In this case, the values of "doc_table" and "index" are
+//   undefined, but there's nothing for the caller to free.
+// - true: if the crawl succeeded.
+bool CrawlFileTreeParallelWithOptions(char* root_dir, int num_workers,
+                                      const CrawlOptions* options,
+                                      DocTable** doc_table, MemIndex** index);
+
+#endif  // HW2_CRAWLFILETREEPARALLEL_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./DocIDTableView.h"
+
+#include <list>      // for std::list.
+#include <memory>    // for std::shared_ptr.
+
+#include "./LayoutStructs.h"
+
+using std::list;
+using std::shared_ptr;
+
+namespace hw3 {
+
+DocIDTableView::DocIDTableView(shared_ptr<const IndexFileSource> file,
+                               IndexFileOffset_t offset)
+  : HashTableView(file, offset) { }
+
+bool DocIDTableView::LookupDocID(
+     const DocID_t& doc_id, list<DocPositionOffset_t>* const ret_val) const {
+  // Find the bucket that this docID hashes into.
+  BucketRecord bucket;
+  if (!LookupBucket(doc_id, &bucket)) {
+    return false;
+  }
+
+  // Walk the bucket's chain, looking for our docID.
+  for (int i = 0; i < bucket.chain_num_elements; i++) {
+    IndexFileOffset_t element_pos;
+    DocIDElementHeader header;
+    if (!LookupElementPosition(bucket, i, &element_pos)
+        || !file_->ReadRecord(element_pos, &header)) {
+      return false;
+    }
+
+    if (header.doc_id == doc_id) {
+      // The positions immediately follow the element header.
+      list<DocPositionOffset_t> positions;
+      IndexFileOffset_t pos_offset = element_pos + sizeof(DocIDElementHeader);
+      for (int j = 0; j < header.num_positions; j++) {
+        DocIDElementPosition position;
+        if (!file_->ReadRecord(pos_offset, &position)) {
+          return false;
+        }
+        positions.push_back(position.position);
+        pos_offset += sizeof(DocIDElementPosition);
+      }
+      *ret_val = positions;
+      return true;
+    }
+  }
+
+  // We failed to find a matching docID, so return false.
+  return false;
+}
+
+list<DocIDElementHeader> DocIDTableView::GetDocIDList() const {
+  list<DocIDElementHeader> doc_id_list;
+
+  // Go through *all* of the buckets of this hashtable, extracting
+  // out the docids in each element and the number of word positions
+  // for the each docid.
+  for (int i = 0; i < header_.num_buckets; i++) {
+    BucketRecord bucket;
+    if (!file_->ReadRecord(offset_ + sizeof(BucketListHeader)
+                           + sizeof(BucketRecord) * i, &bucket)) {
+      return doc_id_list;
+    }
+
+    for (int j = 0; j < bucket.chain_num_elements; j++) {
+      IndexFileOffset_t element_pos;
+      DocIDElementHeader header;
+      if (!LookupElementPosition(bucket, j, &element_pos)
+          || !file_->ReadRecord(element_pos, &header)) {
+        return doc_id_list;
+      }
+      doc_id_list.push_back(header);
+    }
+  }
+
+  // Done!  Return the result list.
+  return doc_id_list;
+}
+
+}  // namespace hw3
@@ -0,0 +1,53 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_DOCIDTABLEVIEW_H_
+#define HW3_DOCIDTABLEVIEW_H_
+
+#include <list>    // for std::list.
+#include <memory>  // for std::shared_ptr.
+
+#include "./HashTableView.h"
+#include "./IndexFileSource.h"
+#include "./PostingsView.h"
+
+namespace hw3 {
+
+// A DocIDTableView is the shareable counterpart of DocIDTableReader:
+// it reads the embedded docid->positions table of a single word in a v1
+// index file.  DocIDTableViews are manufactured by
+// IndexTableView::LookupWord().
+class DocIDTableView : public HashTableView, public PostingsView {
+ public:
+  // PostingsView methods.  GetDocIDList() returns the documents in
+  // bucket order, which isn't docID order.
+  bool LookupDocID(const DocID_t& doc_id,
+                   std::list<DocPositionOffset_t>* const ret_val)
+      const override;
+  std::list<DocIDElementHeader> GetDocIDList() const override;
+  bool IsSortedByDocID() const override { return false; }
+  int num_docs() const override { return num_elements(); }
+
+ protected:
+  // Construct a view of the docID table stored at byte offset "offset"
+  // of "file".  Only IndexTableView should manufacture these.
+  DocIDTableView(std::shared_ptr<const IndexFileSource> file,
+                 IndexFileOffset_t offset);
+
+ private:
+  friend class IndexTableView;
+
+  DISALLOW_COPY_AND_ASSIGN(DocIDTableView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_DOCIDTABLEVIEW_H_
@@ -0,0 +1,60 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./DocStatsView.h"
+
+#include <memory>  // for std::shared_ptr.
+
+#include "./BM25.h"
+#include "./DocTableView.h"
+#include "./LayoutStructsV2.h"
+
+using std::shared_ptr;
+
+namespace hw3 {
+
+DocStatsView::DocStatsView(shared_ptr<const IndexFileSource> file)
+  : num_docs_(0), avg_doc_length_(BM25AverageDocLength(0, 0)),
+    first_doc_id_(0) {
+  IndexFileOffset_t offset;
+  int32_t bytes;
+  DocStatsHeader header;
+  if (!file->FindSection(kDocStatsSection, &offset, &bytes)
+      || bytes < static_cast<int32_t>(sizeof(DocStatsHeader))
+      || !file->ReadRecord(offset, &header)
+      || header.num_lengths < 0
+      || header.num_lengths > static_cast<int32_t>(
+             (bytes - sizeof(DocStatsHeader)) / sizeof(DocLengthRecord))) {
+    // No usable doc stats section, so all we can find out is how many
+    // documents there are.
+    num_docs_ = DocTableView(file).num_elements();
+    return;
+  }
+
+  num_docs_ = header.num_docs;
+  avg_doc_length_ = BM25AverageDocLength(header.num_docs, header.total_words);
+  first_doc_id_ = header.first_doc_id;
+
+  // The lengths are a packed array of big-endian uint32s, so they can be
+  // read in one go and then converted in place.
+  lengths_.resize(header.num_lengths);
+  if (header.num_lengths > 0
+      && !file->ReadBytes(offset + sizeof(DocStatsHeader), lengths_.data(),
+                          lengths_.size() * sizeof(DocLengthRecord))) {
+    lengths_.clear();
+    return;
+  }
+  for (uint32_t& length : lengths_) {
+    length = ntohl(length);
+  }
+}
+
+}  // namespace hw3
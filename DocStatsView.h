@@ -0,0 +1,75 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_DOCSTATSVIEW_H_
+#define HW3_DOCSTATSVIEW_H_
+
+#include <stdint.h>  // for uint32_t.
+#include <memory>    // for std::shared_ptr.
+#include <vector>    // for std::vector.
+
+#include "./IndexFileSource.h"
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A DocStatsView holds what BM25 scoring (see BM25.h) needs to know
+// about the documents of an index file: how many there are, and how long
+// each of them is.  A v2 file records this in its doc stats section,
+// which the view reads in full when it's constructed (four bytes per
+// document), so that queries never go back to the file for it.
+//
+// A v1 file, or a v2 file written before the doc stats section existed,
+// doesn't record document lengths.  Its view counts the documents in the
+// doctable instead, and treats every document as being of average
+// length, which leaves BM25 without its length normalization.
+class DocStatsView {
+ public:
+  // Construct a view of the document statistics of "file".
+  explicit DocStatsView(std::shared_ptr<const IndexFileSource> file);
+
+  // Returns the number of documents in the index file.
+  int num_docs() const { return num_docs_; }
+
+  // Returns the average document length, as computed by
+  // BM25AverageDocLength().
+  double avg_doc_length() const { return avg_doc_length_; }
+
+  // Returns the length of the document "doc_id", or avg_doc_length() if
+  // it isn't known.
+  double DocLength(DocID_t doc_id) const {
+    if (doc_id < first_doc_id_ || doc_id - first_doc_id_ >= lengths_.size()) {
+      return avg_doc_length_;
+    }
+    return lengths_[doc_id - first_doc_id_];
+  }
+
+  // Returns true if the file records the length of "doc_id", rather than
+  // DocLength() making it up.
+  bool HasDocLength(DocID_t doc_id) const {
+    return doc_id >= first_doc_id_ && doc_id - first_doc_id_ < lengths_.size();
+  }
+
+ private:
+  int num_docs_;
+  double avg_doc_length_;
+
+  // lengths_[i] is the length of document first_doc_id_ + i.
+  DocID_t first_doc_id_;
+  std::vector<uint32_t> lengths_;
+
+  DISALLOW_COPY_AND_ASSIGN(DocStatsView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_DOCSTATSVIEW_H_
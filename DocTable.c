@@ -16,6 +16,7 @@
 
 #include "libhw1/CSE333.h"
 #include "libhw1/HashTable.h"
+#include "./StringKey.h"
 
 #define HASHTABLE_INITIAL_NUM_BUCKETS 2
 
@@ -64,17 +65,35 @@ char* custom_strdup(const char* s) {
     return copy;
 }
 
+// StringKeyFn for the name_to_id table, whose elements (docIDs) are
+// keyed on their names in the id_to_name table "arg".
+static const char* DT_NameOf(HTValue_t value, void* arg) {
+  HTKeyValue_t kv;
+  Verify333(HashTable_Find((HashTable*) arg, *(DocID_t*) value, &kv));
+  return (const char*) kv.value;
+}
+
+// Looks up "doc_name" in the name_to_id table of "table", setting "kv" to
+// its element if it's there, and "free_key" to the key to insert it at if
+// not.  See StringKey.h.
+static bool DT_FindName(DocTable* table, const char* doc_name,
+                        HTKeyValue_t* kv, HTKey_t* free_key) {
+  return StringKey_Find(table->name_to_id, doc_name, &DT_NameOf,
+                        table->id_to_name, kv, free_key);
+}
+
 DocID_t DocTable_Add(DocTable* table, char* doc_name) {
   Verify333(table != NULL);
-  HTKey_t key = FNVHash64((unsigned char*)doc_name, strlen(doc_name));
+  HTKey_t key;
 
   HTKeyValue_t kv, old_kv;
 
   // STEP 2.
   // Check to see if the document already exists.  Then make a copy of the
-  // doc_name and allocate space for the new ID.
+  // doc_name and allocate space for the new ID.  A different name with
+  // the same hash doesn't count; if there is one, "key" skips past it.
 
-  if (HashTable_Find(table->name_to_id, key, &kv)) {
+  if (DT_FindName(table, doc_name, &kv, &key)) {
     return *(DocID_t*)kv.value;
   }
 
@@ -110,14 +129,14 @@ DocID_t DocTable_GetDocID(DocTable* table, char* doc_name) {
   Verify333(table != NULL);
   Verify333(doc_name != NULL);
 
-  HTKey_t key = FNVHash64((char*)doc_name, strlen(doc_name));
+  HTKey_t unused;
 
   HTKeyValue_t kv;
   //DocID_t res;
 
   // STEP 5.
   // Try to find the passed-in doc in name_to_id table.
-  if (HashTable_Find(table->name_to_id, key, &kv)) {
+  if (DT_FindName(table, doc_name, &kv, &unused)) {
       return *(DocID_t*)kv.value;
   }
   return INVALID_DOCID;
@@ -0,0 +1,87 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./DocTableView.h"
+
+#include <memory>    // for std::shared_ptr.
+#include <string>    // for std::string.
+#include <utility>   // for std::pair.
+#include <vector>    // for std::vector.
+
+#include "./LayoutStructs.h"
+
+using std::pair;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+DocTableView::DocTableView(shared_ptr<const IndexFileSource> file)
+  : HashTableView(file, file->doctable_offset()) { }
+
+bool DocTableView::LookupDocID(const DocID_t& doc_id,
+                               string* const ret_str) const {
+  // Find the bucket that this docID hashes into.
+  BucketRecord bucket;
+  if (!LookupBucket(doc_id, &bucket)) {
+    return false;
+  }
+
+  // Walk the bucket's chain, looking for our docID.
+  for (int i = 0; i < bucket.chain_num_elements; i++) {
+    IndexFileOffset_t element_pos;
+    DoctableElementHeader header;
+    if (!LookupElementPosition(bucket, i, &element_pos)
+        || !file_->ReadRecord(element_pos, &header)) {
+      return false;
+    }
+
+    if (header.doc_id == doc_id) {
+      // The filename immediately follows the element header.
+      return file_->ReadString(element_pos + sizeof(DoctableElementHeader),
+                               header.file_name_bytes, ret_str);
+    }
+  }
+
+  // We failed to find a matching docID, so return false.
+  return false;
+}
+
+vector<pair<DocID_t, string>> DocTableView::GetDocList() const {
+  vector<pair<DocID_t, string>> doc_list;
+
+  // Go through *all* of the buckets of this hashtable, extracting
+  // out each element's docID and filename.
+  for (int i = 0; i < header_.num_buckets; i++) {
+    BucketRecord bucket;
+    if (!file_->ReadRecord(offset_ + sizeof(BucketListHeader)
+                           + sizeof(BucketRecord) * i, &bucket)) {
+      return doc_list;
+    }
+
+    for (int j = 0; j < bucket.chain_num_elements; j++) {
+      IndexFileOffset_t element_pos;
+      DoctableElementHeader header;
+      string file_name;
+      if (!LookupElementPosition(bucket, j, &element_pos)
+          || !file_->ReadRecord(element_pos, &header)
+          || !file_->ReadString(element_pos + sizeof(DoctableElementHeader),
+                                header.file_name_bytes, &file_name)) {
+        return doc_list;
+      }
+      doc_list.emplace_back(static_cast<DocID_t>(header.doc_id), file_name);
+    }
+  }
+  return doc_list;
+}
+
+}  // namespace hw3
@@ -0,0 +1,56 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_DOCTABLEVIEW_H_
+#define HW3_DOCTABLEVIEW_H_
+
+#include <memory>   // for std::shared_ptr.
+#include <string>   // for std::string.
+#include <utility>  // for std::pair.
+#include <vector>   // for std::vector.
+
+#include "./HashTableView.h"
+#include "./IndexFileSource.h"
+
+namespace hw3 {
+
+// A DocTableView is the shareable counterpart of DocTableReader: it
+// looks up docid->filename mappings within the doctable of an
+// IndexFileSource.
+class DocTableView : public HashTableView {
+ public:
+  // Construct a view of the doctable of "file".
+  explicit DocTableView(std::shared_ptr<const IndexFileSource> file);
+
+  // Lookup a docid and get back a std::string containing the filename
+  // associated with the docid, if it exists.
+  //
+  // Arguments:
+  // - doc_id: the docID to look for within the doctable.
+  // - ret_str: the std::string containing the filename (an output param).
+  //   Has an unspecified value if the docID is not found.
+  //
+  // Returns:
+  // - true if the docID was found, false otherwise.
+  bool LookupDocID(const DocID_t& doc_id, std::string* const ret_str) const;
+
+  // Returns a (docID, filename) pair for every document in the doctable,
+  // in no particular order.  If the doctable can't be read in full, the
+  // result stops short.
+  std::vector<std::pair<DocID_t, std::string>> GetDocList() const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(DocTableView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_DOCTABLEVIEW_H_
@@ -0,0 +1,213 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./FastCRC32.h"
+
+#include <stddef.h>  // for size_t.
+#include <stdint.h>  // for uint32_t, etc.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FASTCRC32_X86_CLMUL 1
+#include <immintrin.h>
+#endif
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+namespace hw3 {
+
+// The (bit-reversed) CRC-32 polynomial.
+static constexpr uint32_t kPolynomial = 0xEDB88320;
+
+// The lookup tables for slicing-by-8.  tables[0] is the classic bytewise
+// table; tables[k][b] is the CRC contribution of byte "b" followed by k
+// zero bytes, which lets us look up eight bytes independently and xor the
+// results together.
+struct SliceTables {
+  uint32_t tables[8][256];
+
+  SliceTables() {
+    for (uint32_t b = 0; b < 256; b++) {
+      uint32_t crc = b;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) ? (crc >> 1) ^ kPolynomial : crc >> 1;
+      }
+      tables[0][b] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+      for (int b = 0; b < 256; b++) {
+        uint32_t prev = tables[k - 1][b];
+        tables[k][b] = (prev >> 8) ^ tables[0][prev & 0xFF];
+      }
+    }
+  }
+};
+
+// Returns the tables, building them on first use.  (C++ guarantees that
+// this is thread-safe.)
+static const SliceTables& GetSliceTables() {
+  static const SliceTables slice_tables;
+  return slice_tables;
+}
+
+// Folds "len" bytes into "crc", one byte at a time.
+static uint32_t FoldBytewise(uint32_t crc, const uint8_t* buf, size_t len) {
+  const uint32_t (*t)[256] = GetSliceTables().tables;
+  while (len-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *buf++) & 0xFF];
+  }
+  return crc;
+}
+
+// Folds "len" bytes into "crc", eight bytes at a time.
+static uint32_t FoldSliceBy8(uint32_t crc, const uint8_t* buf, size_t len) {
+  const uint32_t (*t)[256] = GetSliceTables().tables;
+
+  while (len >= 8) {
+    // The CRC is reflected, so the first four bytes (read little-endian)
+    // line up with the running CRC.
+    uint32_t lo = buf[0] | (buf[1] << 8) | (buf[2] << 16)
+      | (static_cast<uint32_t>(buf[3]) << 24);
+    lo ^= crc;
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF]
+      ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+      ^ t[3][buf[4]] ^ t[2][buf[5]] ^ t[1][buf[6]] ^ t[0][buf[7]];
+    buf += 8;
+    len -= 8;
+  }
+  return FoldBytewise(crc, buf, len);
+}
+
+#ifdef FASTCRC32_X86_CLMUL
+// Folds "len" bytes into "crc" using carry-less multiplication; "len" must
+// be a multiple of 16, and at least 64.
+//
+// This is the folding algorithm from Gopal et al., "Fast CRC Computation
+// for Generic Polynomials Using PCLMULQDQ Instruction" (Intel, 2009), as
+// used by zlib and the Linux kernel for this polynomial.  Four 128-bit
+// accumulators are folded forward 512 bits at a time, then into one
+// another, and the remaining 128 bits are reduced to 32 with a Barrett
+// reduction.  The constants are x^k mod P(x) for the various fold
+// distances, bit-reflected.
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t FoldCLMul(uint32_t crc, const uint8_t* buf, size_t len) {
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+  __m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+  x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+  x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+  x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+  buf += 64;
+  len -= 64;
+
+  // Fold 64 bytes at a time into the four accumulators.
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(buf + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(buf + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(buf + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(buf + 0x30)));
+    buf += 64;
+    len -= 64;
+  }
+
+  // Fold the four accumulators into one.
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  // Fold in any remaining 16-byte blocks.
+  while (len >= 16) {
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+    x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    buf += 16;
+    len -= 16;
+  }
+
+  // Fold 128 bits down to 64.
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // Barrett-reduce 64 bits down to the 32-bit CRC.
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return _mm_extract_epi32(x1, 1);
+}
+#endif  // FASTCRC32_X86_CLMUL
+
+FastCRC32::FastCRC32() : crc_(0xFFFFFFFF), finalized_(false) { }
+
+void FastCRC32::FoldByteIntoCRC(const uint8_t next_byte) {
+  Verify333(!finalized_);
+  crc_ = FoldBytewise(crc_, &next_byte, 1);
+}
+
+void FastCRC32::FoldBytes(const void* buf, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(buf);
+
+  Verify333(!finalized_);
+#ifdef FASTCRC32_X86_CLMUL
+  // The folding setup costs a few dozen instructions, so it only pays off
+  // on longer buffers.  The tail that doesn't fill a 16-byte block goes
+  // through the table-driven loop.
+  if (len >= 256 && __builtin_cpu_supports("pclmul")
+      && __builtin_cpu_supports("sse4.1")) {
+    size_t folded = len & ~static_cast<size_t>(15);
+    crc_ = FoldCLMul(crc_, bytes, folded);
+    bytes += folded;
+    len -= folded;
+  }
+#endif  // FASTCRC32_X86_CLMUL
+  crc_ = FoldSliceBy8(crc_, bytes, len);
+}
+
+uint32_t FastCRC32::GetFinalCRC() {
+  if (!finalized_) {
+    crc_ = ~crc_;
+    finalized_ = true;
+  }
+  return crc_;
+}
+
+}  // namespace hw3
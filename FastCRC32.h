@@ -0,0 +1,55 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_FASTCRC32_H_
+#define HW3_FASTCRC32_H_
+
+#include <stddef.h>  // for size_t.
+#include <stdint.h>  // for uint32_t, etc.
+
+#include "./Utils.h"  // for DISALLOW_COPY_AND_ASSIGN.
+
+namespace hw3 {
+
+// A FastCRC32 computes exactly the same checksum as the CRC32 class in
+// Utils.h (the standard, zlib-compatible CRC-32), so the two can be used
+// interchangeably to produce or check an index file's checksum.  It adds
+// FoldBytes(), which folds a whole buffer at once; that's far faster than
+// a FoldByteIntoCRC() call per byte.
+//
+// FoldBytes() uses carry-less multiplication (PCLMULQDQ) to fold 64 bytes
+// per step on CPUs that support it, and a table-driven "slicing-by-8"
+// loop, which processes 8 bytes per step, everywhere else.  The choice is
+// made at runtime.
+class FastCRC32 {
+ public:
+  FastCRC32();
+
+  // Fold the next byte into the checksum.
+  void FoldByteIntoCRC(const uint8_t next_byte);
+
+  // Fold the next "len" bytes at "buf" into the checksum.
+  void FoldBytes(const void* buf, size_t len);
+
+  // Return the final checksum.  No more bytes may be folded in after this.
+  uint32_t GetFinalCRC();
+
+ private:
+  // The running checksum; inverted once it's finalized.
+  uint32_t crc_;
+  bool finalized_;
+
+  DISALLOW_COPY_AND_ASSIGN(FastCRC32);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_FASTCRC32_H_
@@ -18,7 +18,8 @@
 extern "C" {
   #include "libhw1/CSE333.h"
 }
-#include "./Utils.h"    // for class CRC32.
+#include "./FastCRC32.h"
+#include "./LayoutStructsV2.h"  // for kMagicNumberV2.
 #include <iostream>
 
 using std::string;
@@ -51,8 +52,10 @@ FileIndexReader::FileIndexReader(const string& file_name,
   header_.ToHostFormat();
 
   // STEP 3.
-  // Verify that the magic number is correct.  Crash if not.
-  Verify333(header_.magic_number == kMagicNumber);
+  // Verify that the magic number is one we know.  Crash if not.  A v2
+  // file's header, length and checksum mean the same thing as a v1 file's.
+  Verify333(header_.magic_number == kMagicNumber
+            || header_.magic_number == kMagicNumberV2);
 
   // Make sure the index file's length lines up with the header fields.
   struct stat f_stat;
@@ -65,8 +68,8 @@ FileIndexReader::FileIndexReader(const string& file_name,
     // Use fread() and pass the bytes you read into the crcobj.
     // Note you don't need to do any host/network order conversion,
     // since we're doing this byte-by-byte.
-    CRC32 crc_obj;
-    static constexpr int kBufSize = 512;
+    FastCRC32 crc_obj;
+    static constexpr int kBufSize = 64 * 1024;
     uint8_t buf[kBufSize];
     int left_to_read = header_.doctable_bytes + header_.index_bytes;
     while (left_to_read > 0) {
@@ -84,9 +87,7 @@ FileIndexReader::FileIndexReader(const string& file_name,
         Verify333(false);
       }
 
-      for(int i = 0; i < bytes_read; i++) {
-        crc_obj.FoldByteIntoCRC(buf[i]);
-      }
+      crc_obj.FoldBytes(buf, bytes_read);
       left_to_read -= bytes_read;
     }
     Verify333(crc_obj.GetFinalCRC() == header_.checksum);
@@ -111,6 +112,14 @@ DocTableReader* FileIndexReader::NewDocTableReader() const {
 }
 
 IndexTableReader* FileIndexReader::NewIndexTableReader() const {
+  // IndexTableReader only understands the v1 word->postings table.  A v2
+  // file is perfectly valid, so rather than crash on it, return nullptr;
+  // callers must check, and read v2 files through IndexTableView (see
+  // QueryProcessor) instead.
+  if (header_.magic_number != kMagicNumber) {
+    return nullptr;
+  }
+
   // The index (word-->docid table) mapping starts at offset
   // (sizeof(IndexFileHeader) + doctable_size_) in the index file.  Be
   // sure to dup the (FILE*) rather than sharing it across objects,
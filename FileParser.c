@@ -23,10 +23,19 @@
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FILEPARSER_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
 #include "libhw1/CSE333.h"
+#include "./Arena.h"
 #include "./MemIndex.h"
+#include "./StringKey.h"
+#include "./WordPositionArray.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -34,6 +43,9 @@
 
 #define ASCII_UPPER_BOUND 0x7F
 
+// How many positions a WordPositionArray has room for at first.
+#define INITIAL_POSITIONS_CAPACITY 4
+
 // Frees a WordPositions.positions's payload, which is just a
 // DocPositionOffset_t.
 static void NoOpFree(LLPayload_t payload) { }
@@ -46,13 +58,65 @@ static void FreeWordPositions(HTValue_t payload) {
   free(pos);
 }
 
-// Add a normalized word and its byte offset into the WordPositions HashTable.
-static void AddWordPosition(HashTable* tab, char* word,
+// StringKeyFn for the WordPositions HashTable, whose elements are keyed
+// on their word.
+static const char* WordPositionsWord(HTValue_t payload, void* arg) {
+  return ((WordPositions*) payload)->word;
+}
+
+// Frees a WordPositionArray, which is nothing: it lives in an Arena.
+static void NoOpFreeValue(HTValue_t payload) { }
+
+// StringKeyFn for the WordPositionArray HashTable.
+static const char* WordPositionArrayWord(HTValue_t payload, void* arg) {
+  return ((WordPositionArray*) payload)->word;
+}
+
+// Where InsertContent() puts a file's words: a HashTable of WordPositions,
+// or, if "arena" isn't NULL, a HashTable of WordPositionArrays allocated
+// from "arena".
+typedef struct {
+  HashTable* tab;
+  Arena*     arena;
+} WordSink;
+
+// Add a normalized word and its byte offset into the sink's HashTable.
+static void AddWordPosition(WordSink* sink, char* word,
                             DocPositionOffset_t pos);
 
-// Parse the passed-in string into normalized words and insert into a HashTable
-// of WordPositions structures.
-static void InsertContent(HashTable* tab, char* content);
+// The halves of AddWordPosition(), for each kind of sink.
+static void AddToWordPositions(HashTable* tab, char* word,
+                               DocPositionOffset_t pos);
+static void AddToWordPositionArrays(HashTable* tab, Arena* arena,
+                                    char* word, DocPositionOffset_t pos);
+
+// ParseIntoWordPositionsTable() and ParseIntoWordPositionArrays(), which
+// differ only in the sink they parse into.
+static HashTable* ParseIntoTable(char* file_contents, Arena* arena);
+
+// Parse the passed-in string, which is "len" bytes long, into normalized
+// words and insert them into the sink.
+// This also checks that the string is ASCII text: it returns false, having
+// possibly inserted some of the words, if it finds a byte > 0x7F.
+//
+// There are several implementations of this; InsertContent() picks the
+// fastest one the CPU we're running on supports.  They all produce exactly
+// the same table, and leave exactly the same bytes in "content".
+static bool InsertContent(WordSink* sink, char* content, int len);
+
+// The portable implementation of InsertContent(), which steps through the
+// string one byte at a time.  It scans content[from, len), and "word_start"
+// tracks the start of the word we're in the middle of (or is NULL) between
+// calls, so the vectorized implementations use it for their leftover bytes.
+static bool InsertContentScalar(WordSink* sink, char* content,
+                                int from, int len, char** word_start);
+
+#ifdef FILEPARSER_X86_SIMD
+// The vectorized implementations of InsertContent(), which classify 16
+// (SSE2) or 32 (AVX2) bytes at a time.
+static bool InsertContentSSE2(WordSink* sink, char* content, int len);
+static bool InsertContentAVX2(WordSink* sink, char* content, int len);
+#endif  // FILEPARSER_X86_SIMD
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -147,8 +211,30 @@ char* ReadFileToString(const char* file_name, int* size) {
 }
 
 HashTable* ParseIntoWordPositionsTable(char* file_contents) {
-  HashTable* tab;
-  int i, file_len;
+  return ParseIntoTable(file_contents, NULL);
+}
+
+HashTable* ParseIntoWordPositionArrays(char* file_contents, Arena* arena) {
+  Verify333(arena != NULL);
+  return ParseIntoTable(file_contents, arena);
+}
+
+void FreeWordPositionsTable(HashTable *table) {
+  HashTable_Free(table, &FreeWordPositions);
+}
+
+void FreeWordPositionArrays(HashTable* table) {
+  HashTable_Free(table, &NoOpFreeValue);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions
+
+static HashTable* ParseIntoTable(char* file_contents, Arena* arena) {
+  WordSink sink;
+  ValueFreeFnPtr free_fn = (arena != NULL) ? &NoOpFreeValue
+                                           : &FreeWordPositions;
+  int file_len;
 
   if (file_contents == NULL) {
     return NULL;
@@ -156,65 +242,65 @@ HashTable* ParseIntoWordPositionsTable(char* file_contents) {
 
   file_len = strlen(file_contents);
   if (file_len == 0) {
+    free(file_contents);
     return NULL;
   }
 
-  // Verify that the file contains only ASCII text.  We won't try to index any
-  // files that contain non-ASCII text; unfortunately, this means we aren't
-  // Unicode friendly.
-  for (i = 0; i < file_len; i++) {
-    if (file_contents[i] == '\0' ||
-        (unsigned char) file_contents[i] > ASCII_UPPER_BOUND) {
-      free(file_contents);
-      return NULL;
-    }
-  }
-
   // Great!  Let's split the file up into words.  We'll allocate the hash
   // table that will store the WordPositions structures associated with each
   // word.  Since our hash table dynamically grows, we'll start with a small
   // number of buckets.
-  tab = HashTable_Allocate(32);
-  Verify333(tab != NULL);
+  sink.tab = HashTable_Allocate(32);
+  Verify333(sink.tab != NULL);
+  sink.arena = arena;
 
   // Loop through the file, splitting it into words and inserting a record for
-  // each word.
-  InsertContent(tab, file_contents);
+  // each word.  We won't index any files that contain non-ASCII text;
+  // unfortunately, this means we aren't Unicode friendly.  The check happens
+  // as part of the same pass, so if it fails we throw away whatever we'd
+  // inserted so far.
+  if (!InsertContent(&sink, file_contents, file_len)) {
+    HashTable_Free(sink.tab, free_fn);
+    free(file_contents);
+    return NULL;
+  }
 
   // If we found no words, return NULL instead of a zero-sized hashtable.
-  if (HashTable_NumElements(tab) == 0) {
-    HashTable_Free(tab, &FreeWordPositions);
-    tab = NULL;
+  if (HashTable_NumElements(sink.tab) == 0) {
+    HashTable_Free(sink.tab, free_fn);
+    sink.tab = NULL;
   }
 
   // Now that we've finished parsing the document, we can free up the
   // filecontents buffer and return our built-up table.
   free(file_contents);
-  return tab;
+  return sink.tab;
 }
 
-void FreeWordPositionsTable(HashTable *table) {
-  HashTable_Free(table, &FreeWordPositions);
+static bool InsertContent(WordSink* sink, char* content, int len) {
+#ifdef FILEPARSER_X86_SIMD
+  // SSE2 is part of the x86-64 baseline, but AVX2 isn't, so check for it.
+  // (This just reads a word that libgcc fills in at startup, so it's cheap
+  // enough to do per file, and there's no lazily-initialized state to race
+  // on when several threads parse files at once.)
+  if (__builtin_cpu_supports("avx2")) {
+    return InsertContentAVX2(sink, content, len);
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return InsertContentSSE2(sink, content, len);
+  }
+#endif  // FILEPARSER_X86_SIMD
+  char* word_start = NULL;
+  return InsertContentScalar(sink, content, 0, len, &word_start);
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// Internal helper functions
-
-static void InsertContent(HashTable* tab, char* content) {
-  char* cur_ptr = content;
-  char* word_start = content;
-  //char* word_start = NULL;
-
-  // STEP 6.
-  // This is the interesting part of Part A!
-  //
-  // "content" contains a C string with the full contents of the file.  You
-  // need to implement a loop that steps through the file content one character
-  // at a time, testing to see whether a character is an alphabetic character.
-  // If a character is alphabetic, it's part of a word.  If a character is not
-  // alphabetic, it's part of the boundary between words.  You can use
-  // string.h's "isalpha()" macro to test whether a character is alphabetic or
-  // not (see also "man isalpha").
+static bool InsertContentScalar(WordSink* sink, char* content,
+                                int from, int len, char** word_start) {
+  // "content" contains a C string with the full contents of the file.  We
+  // step through it one character at a time, testing to see whether each
+  // character is alphabetic.  If a character is alphabetic, it's part of a
+  // word.  If a character is not alphabetic, it's part of the boundary
+  // between words.
   //
   // For example, here's a string with its words underlined with "=" and
   // boundary characters underlined with "+":
@@ -222,61 +308,155 @@ static void InsertContent(HashTable* tab, char* content) {
   // The  Fox  Can't   CATCH the  Chicken.
   // ===++===++===+=+++=====+===++=======+
   //
-  // Any time you detect the start of a word, you should use the "wordstart"
-  // pointer to remember where the word started.  You should also use the
-  // "tolower()" macro to convert alphabetic characters to lowercase (ie,
-  // *curptr = tolower(*curptr)).  Finally, as a hint, you can overwrite
-  // boundary characters with '\0' (null terminators) in the buffer to create
-  // valid C strings out of each parsed word.
-  //
-  // Each time you find a word that you want to record in the hashtable, call
-  // AddWordPosition() helper with appropriate arguments, e.g.,
-  // AddWordPosition(tab, wordstart, pos);
-
-  while (*cur_ptr != '\0') {
-    if (isalpha((unsigned char)*cur_ptr)) {
-      if (word_start == NULL) {
-        word_start = cur_ptr;
+  // We convert alphabetic characters to lowercase in place, and overwrite the
+  // first boundary character after each word with '\0' to make the word a
+  // valid C string that we can hand to AddWordPosition().
+  char* cur_ptr;
+  char* end_ptr = content + len;
+
+  for (cur_ptr = content + from; cur_ptr < end_ptr; cur_ptr++) {
+    if ((unsigned char) *cur_ptr > ASCII_UPPER_BOUND) {
+      return false;
+    }
+    if (isalpha((unsigned char) *cur_ptr)) {
+      if (*word_start == NULL) {
+        *word_start = cur_ptr;
       }
-      *cur_ptr = tolower((unsigned char)*cur_ptr);
+      *cur_ptr = tolower((unsigned char) *cur_ptr);
+    } else if (*word_start != NULL) {
+      *cur_ptr = '\0';
+      AddWordPosition(sink, *word_start, (int) (*word_start - content));
+      *word_start = NULL;
+    }
+  }
+
+  // A word that runs to the end of the file is already terminated by the
+  // string's own '\0'.
+  if (*word_start != NULL) {
+    AddWordPosition(sink, *word_start, (int) (*word_start - content));
+    *word_start = NULL;
+  }
+  return true;
+}
+
+#ifdef FILEPARSER_X86_SIMD
+// The vectorized implementations work on a block of bytes at a time:
+//
+// 1. Any byte with its high bit set is non-ASCII, so a nonzero movemask
+//    of the raw bytes means we reject the file.
+// 2. A byte is alphabetic iff (byte | 0x20) is in ['a', 'z'].  There are
+//    no unsigned byte compares, so we bias by 0x1F to move ['a', 'z'] to
+//    [-128, -103] and do a signed compare against -102.
+// 3. Lowercasing is or'ing 0x20 into the alphabetic bytes only.
+// 4. From the resulting "alpha" bitmask, the bits where it differs from
+//    the previous byte's bit are the word boundaries.  We only drop out of
+//    the vector code to visit those, in order.
+
+// Visits the word boundaries within the block of bytes starting at
+// content[base].  Bit i of "alpha" is set if content[base + i] is
+// alphabetic, and bit i of "edges" is set if that differs from the byte
+// before it.  "word_start" is as for InsertContentScalar().
+static void HandleWordEdges(WordSink* sink, char* content, int base,
+                            uint32_t alpha, uint32_t edges,
+                            char** word_start) {
+  while (edges != 0) {
+    int i = __builtin_ctz(edges);
+
+    if (alpha & (1U << i)) {
+      // A word starts here.
+      *word_start = content + base + i;
     } else {
-      if (word_start != NULL) {
-        *cur_ptr = '\0';
-        AddWordPosition(tab, word_start, (int)(word_start - content));
-        word_start = NULL;
-      }
+      // The word we were in ends just before here.
+      content[base + i] = '\0';
+      AddWordPosition(sink, *word_start, (int) (*word_start - content));
+      *word_start = NULL;
     }
-    cur_ptr++;
+    edges &= edges - 1;
   }
+}
 
-  if (word_start != NULL) {
-    //*cur_ptr = '\0';
-    AddWordPosition(tab, word_start, (int)(word_start - content));
+__attribute__((target("sse2")))
+static bool InsertContentSSE2(WordSink* sink, char* content, int len) {
+  const __m128i bias = _mm_set1_epi8(0x80 - 'a');
+  const __m128i limit = _mm_set1_epi8((char) (-128 + 26));
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  char* word_start = NULL;
+  int base;
+
+  for (base = 0; base + 16 <= len; base += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i*) (content + base));
+    __m128i is_alpha;
+    uint32_t alpha, prev;
+
+    if (_mm_movemask_epi8(bytes) != 0) {
+      return false;
+    }
+    is_alpha = _mm_cmplt_epi8(
+        _mm_add_epi8(_mm_or_si128(bytes, case_bit), bias), limit);
+    _mm_storeu_si128((__m128i*) (content + base),
+        _mm_or_si128(bytes, _mm_and_si128(is_alpha, case_bit)));
+
+    alpha = (uint32_t) _mm_movemask_epi8(is_alpha);
+    prev = (alpha << 1) | (word_start != NULL);
+    HandleWordEdges(sink, content, base, alpha, (alpha ^ prev) & 0xFFFF,
+                    &word_start);
   }
+  return InsertContentScalar(sink, content, base, len, &word_start);
 }
 
-static void AddWordPosition(HashTable* tab, char* word,
+__attribute__((target("avx2")))
+static bool InsertContentAVX2(WordSink* sink, char* content, int len) {
+  const __m256i bias = _mm256_set1_epi8(0x80 - 'a');
+  const __m256i limit = _mm256_set1_epi8((char) (-128 + 26));
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  char* word_start = NULL;
+  int base;
+
+  for (base = 0; base + 32 <= len; base += 32) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i*) (content + base));
+    __m256i is_alpha;
+    uint32_t alpha, prev;
+
+    if (_mm256_movemask_epi8(bytes) != 0) {
+      return false;
+    }
+    is_alpha = _mm256_cmpgt_epi8(
+        limit, _mm256_add_epi8(_mm256_or_si256(bytes, case_bit), bias));
+    _mm256_storeu_si256((__m256i*) (content + base),
+        _mm256_or_si256(bytes, _mm256_and_si256(is_alpha, case_bit)));
+
+    alpha = (uint32_t) _mm256_movemask_epi8(is_alpha);
+    prev = (alpha << 1) | (word_start != NULL);
+    HandleWordEdges(sink, content, base, alpha, alpha ^ prev, &word_start);
+  }
+  return InsertContentScalar(sink, content, base, len, &word_start);
+}
+#endif  // FILEPARSER_X86_SIMD
+
+static void AddWordPosition(WordSink* sink, char* word,
                             DocPositionOffset_t pos) {
+  if (sink->arena != NULL) {
+    AddToWordPositionArrays(sink->tab, sink->arena, word, pos);
+  } else {
+    AddToWordPositions(sink->tab, word, pos);
+  }
+}
+
+static void AddToWordPositions(HashTable* tab, char* word,
+                               DocPositionOffset_t pos) {
   HTKey_t hash_key;
   HTKeyValue_t kv;
   WordPositions *wp;
 
-  // Hash the string.
-  hash_key = FNVHash64((unsigned char*) word, strlen(word));
-
   // Have we already encountered this word within this file?  If so, it's
-  // already in the hashtable.
-  if (HashTable_Find(tab, hash_key, &kv)) {
+  // already in the hashtable.  If not, "hash_key" is where it goes, which
+  // skips past any other words with the same hash.
+  if (StringKey_Find(tab, word, &WordPositionsWord, NULL, &kv, &hash_key)) {
     // Yes; we just need to add a position in using LinkedList_Append(). Note
     // how we're casting the DocPositionOffset_t position variable to an
     // LLPayload_t to store it in the linked list payload without needing to
     // malloc space for it.  Ugly, but it works!
     wp = (WordPositions*) kv.value;
-
-    // Ensure we don't have hash collisions (two different words that hash to
-    // the same key, which is very unlikely).
-    Verify333(strcmp(wp->word, word) == 0);
-
     LinkedList_Append(wp->positions, (LLPayload_t) (int64_t) pos);
   } else {
     // STEP 7.
@@ -303,4 +483,42 @@ static void AddWordPosition(HashTable* tab, char* word,
       kv.value = wp;
       HashTable_Insert(tab, kv, &kv);
     }
-}
\ No newline at end of file
+}
+
+static void AddToWordPositionArrays(HashTable* tab, Arena* arena,
+                                    char* word, DocPositionOffset_t pos) {
+  HTKey_t hash_key;
+  HTKeyValue_t kv;
+  WordPositionArray* wpa;
+
+  if (StringKey_Find(tab, word, &WordPositionArrayWord, NULL, &kv,
+                     &hash_key)) {
+    wpa = (WordPositionArray*) kv.value;
+    if (wpa->num_positions == wpa->capacity) {
+      // Double the array.  The old one stays in the arena, unused, so at
+      // most half of a word's share of the arena is wasted this way.
+      DocPositionOffset_t* positions = (DocPositionOffset_t*)
+          Arena_Alloc(arena, 2 * wpa->capacity * sizeof(DocPositionOffset_t));
+      memcpy(positions, wpa->positions,
+             wpa->num_positions * sizeof(DocPositionOffset_t));
+      wpa->positions = positions;
+      wpa->capacity *= 2;
+    }
+  } else {
+    // The first time we've seen this word, so copy it into the arena with
+    // a small array for its positions.
+    size_t word_bytes = strlen(word) + 1;
+    wpa = (WordPositionArray*) Arena_Alloc(arena, sizeof(WordPositionArray));
+    wpa->word = (char*) Arena_Alloc(arena, word_bytes);
+    memcpy(wpa->word, word, word_bytes);
+    wpa->capacity = INITIAL_POSITIONS_CAPACITY;
+    wpa->positions = (DocPositionOffset_t*) Arena_Alloc(
+        arena, wpa->capacity * sizeof(DocPositionOffset_t));
+    wpa->num_positions = 0;
+
+    kv.key = hash_key;
+    kv.value = wpa;
+    HashTable_Insert(tab, kv, &kv);
+  }
+  wpa->positions[wpa->num_positions++] = pos;
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "CSE333.h"
+#include "HashTable.h"
+#include "FlatHashTable_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+//
+// See FlatHashTable_priv.h for an overview of the table's layout.  Keys
+// are HTKey_t's, which callers usually (but not always: DocTable uses
+// sequential docIDs) derive from FNVHash64(); we mix them once more so
+// that both kinds of key spread evenly over the slots and the control
+// bytes.
+
+// Scrambles the bits of a key.  (This is the 64-bit finalizer from
+// Austin Appleby's MurmurHash3.)
+static uint64_t MixKey(HTKey_t key) {
+  uint64_t h = key;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Returns the control byte for a full slot holding a key that mixes to
+// "hash": its top 7 bits, which leaves the control byte's high bit clear.
+static int8_t CtrlForHash(uint64_t hash) {
+  return (int8_t) (hash >> 57);
+}
+
+static bool IsFull(int8_t ctrl) {
+  return ctrl >= 0;
+}
+
+// Returns the slot that "key" lives in, or -1 if it isn't in the table.
+static int FindSlot(HashTable *table, HTKey_t key);
+
+// Allocates "capacity" fresh, empty slots for "table" and re-inserts its
+// elements into them, discarding any tombstones along the way.
+static void Rehash(HashTable *table, int capacity);
+
+// Makes sure there's room to insert one more element, growing (or just
+// rehashing, if it's mostly tombstones) the table if its load factor
+// would otherwise exceed 7/8.
+static void MaybeResize(HashTable *table);
+
+// Empties out slot "slot", which must be full.
+static void ClearSlot(HashTable *table, int slot);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HashTable implementation.
+
+HTKey_t FNVHash64(unsigned char *buffer, int len) {
+  // This must stay identical to HashTable.c's FNVHash64(): the hw3 index
+  // readers recompute it to find words on disk.
+  //
+  // This code is adapted from code by Landon Curt Noll
+  // and Bonelli Nicola:
+  //     http://code.google.com/p/nicola-bonelli-repo/
+  static const uint64_t FNV1_64_INIT = 0xcbf29ce484222325ULL;
+  static const uint64_t FNV_64_PRIME = 0x100000001b3ULL;
+  unsigned char *bp = (unsigned char *) buffer;
+  unsigned char *be = bp + len;
+  uint64_t hval = FNV1_64_INIT;
+
+  // FNV-1a hash each octet of the buffer.
+  while (bp < be) {
+    // XOR the bottom with the current octet.
+    hval ^= (uint64_t) * bp++;
+    // Multiply by the 64 bit FNV magic prime mod 2^64.
+    hval *= FNV_64_PRIME;
+  }
+  return hval;
+}
+
+HashTable* HashTable_Allocate(int num_buckets) {
+  HashTable *ht;
+  int capacity;
+
+  Verify333(num_buckets > 0);
+
+  // HashTable.c treats num_buckets as a number of chains; we treat it as
+  // a hint of how many elements the caller expects, and size the slot
+  // array so that many fit without a resize.
+  capacity = FHT_MIN_CAPACITY;
+  while ((int64_t) capacity * 7 < (int64_t) num_buckets * 8) {
+    capacity *= 2;
+  }
+
+  // Allocate the hash table record, and then its slots.
+  ht = (HashTable *) malloc(sizeof(HashTable));
+  Verify333(ht != NULL);
+  ht->capacity = 0;
+  ht->num_elements = 0;
+  ht->num_deleted = 0;
+  ht->ctrl = NULL;
+  ht->slots = NULL;
+  Rehash(ht, capacity);
+
+  return ht;
+}
+
+void HashTable_Free(HashTable *table,
+                    ValueFreeFnPtr value_free_function) {
+  int i;
+
+  Verify333(table != NULL);
+
+  // Free each element's value using the caller's free function.  The
+  // key/value pairs themselves live inline in the slot array.
+  for (i = 0; i < table->capacity; i++) {
+    if (IsFull(table->ctrl[i])) {
+      value_free_function(table->slots[i].value);
+    }
+  }
+
+  // Free the slot and control arrays, then the table record itself.
+  free(table->ctrl);
+  free(table->slots);
+  free(table);
+}
+
+int HashTable_NumElements(HashTable *table) {
+  Verify333(table != NULL);
+  return table->num_elements;
+}
+
+bool HashTable_Insert(HashTable *table, HTKeyValue_t newkeyvalue,
+                      HTKeyValue_t *oldkeyvalue) {
+  uint64_t hash;
+  int8_t ctrl;
+  int mask, slot, first_deleted;
+
+  Verify333(table != NULL);
+  MaybeResize(table);
+
+  hash = MixKey(newkeyvalue.key);
+  ctrl = CtrlForHash(hash);
+  mask = table->capacity - 1;
+  first_deleted = -1;
+
+  // Probe until we either find the key or hit an empty slot.  The load
+  // factor is capped at 7/8, so there's always an empty slot to stop at.
+  for (slot = hash & mask; ; slot = (slot + 1) & mask) {
+    int8_t cur = table->ctrl[slot];
+
+    if (cur == FHT_CTRL_EMPTY) {
+      break;
+    }
+    if (cur == FHT_CTRL_DELETED) {
+      // Remember the first tombstone; we'll reuse it if the key turns
+      // out not to be in the table.
+      if (first_deleted == -1) {
+        first_deleted = slot;
+      }
+      continue;
+    }
+    if (cur == ctrl && table->slots[slot].key == newkeyvalue.key) {
+      // The key is already present; replace its value.
+      *oldkeyvalue = table->slots[slot];
+      table->slots[slot].value = newkeyvalue.value;
+      return true;
+    }
+  }
+
+  // The key isn't present; add it.
+  if (first_deleted != -1) {
+    slot = first_deleted;
+    table->num_deleted--;
+  }
+  table->ctrl[slot] = ctrl;
+  table->slots[slot] = newkeyvalue;
+  table->num_elements++;
+  return false;
+}
+
+bool HashTable_Find(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue) {
+  int slot;
+
+  Verify333(table != NULL);
+
+  slot = FindSlot(table, key);
+  if (slot == -1) {
+    return false;
+  }
+  *keyvalue = table->slots[slot];
+  return true;
+}
+
+bool HashTable_Remove(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue) {
+  int slot;
+
+  Verify333(table != NULL);
+
+  slot = FindSlot(table, key);
+  if (slot == -1) {
+    return false;
+  }
+  *keyvalue = table->slots[slot];
+  ClearSlot(table, slot);
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// HTIterator implementation.
+
+HTIterator* HTIterator_Allocate(HashTable *table) {
+  HTIterator *iter;
+
+  Verify333(table != NULL);
+
+  iter = (HTIterator *) malloc(sizeof(HTIterator));
+  Verify333(iter != NULL);
+
+  // Point the iterator at the first full slot, if there is one; if the
+  // table is empty the iterator is immediately invalid.
+  iter->ht = table;
+  for (iter->slot = 0; iter->slot < table->capacity; iter->slot++) {
+    if (IsFull(table->ctrl[iter->slot])) {
+      break;
+    }
+  }
+  return iter;
+}
+
+void HTIterator_Free(HTIterator *iter) {
+  Verify333(iter != NULL);
+  free(iter);
+}
+
+bool HTIterator_IsValid(HTIterator *iter) {
+  Verify333(iter != NULL);
+
+  return iter->slot < iter->ht->capacity
+    && IsFull(iter->ht->ctrl[iter->slot]);
+}
+
+bool HTIterator_Next(HTIterator *iter) {
+  Verify333(iter != NULL);
+
+  if (iter->slot >= iter->ht->capacity) {
+    return false;
+  }
+
+  // Advance to the next full slot, or off the end of the table.
+  for (iter->slot++; iter->slot < iter->ht->capacity; iter->slot++) {
+    if (IsFull(iter->ht->ctrl[iter->slot])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue) {
+  Verify333(iter != NULL);
+
+  if (!HTIterator_IsValid(iter)) {
+    return false;
+  }
+
+  *keyvalue = iter->ht->slots[iter->slot];
+  return true;
+}
+
+bool HTIterator_Remove(HTIterator *iter, HTKeyValue_t *keyvalue) {
+  Verify333(iter != NULL);
+
+  if (!HTIterator_IsValid(iter)) {
+    return false;
+  }
+
+  // Removing an element never moves any other element, so we can clear
+  // the current slot in place and then advance past it.
+  *keyvalue = iter->ht->slots[iter->slot];
+  ClearSlot(iter->ht, iter->slot);
+  HTIterator_Next(iter);
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper function definitions.
+
+static int FindSlot(HashTable *table, HTKey_t key) {
+  uint64_t hash = MixKey(key);
+  int8_t ctrl = CtrlForHash(hash);
+  int mask = table->capacity - 1;
+  int slot;
+
+  for (slot = hash & mask; ; slot = (slot + 1) & mask) {
+    int8_t cur = table->ctrl[slot];
+
+    if (cur == FHT_CTRL_EMPTY) {
+      return -1;
+    }
+    if (cur == ctrl && table->slots[slot].key == key) {
+      return slot;
+    }
+  }
+}
+
+static void Rehash(HashTable *table, int capacity) {
+  int8_t *old_ctrl = table->ctrl;
+  HTKeyValue_t *old_slots = table->slots;
+  int old_capacity = table->capacity;
+  int mask = capacity - 1;
+  int i;
+
+  Verify333(capacity >= FHT_MIN_CAPACITY);
+  Verify333((capacity & mask) == 0);  // a power of two
+
+  table->ctrl = (int8_t *) malloc(capacity * sizeof(int8_t));
+  Verify333(table->ctrl != NULL);
+  memset(table->ctrl, FHT_CTRL_EMPTY, capacity * sizeof(int8_t));
+  table->slots = (HTKeyValue_t *) malloc(capacity * sizeof(HTKeyValue_t));
+  Verify333(table->slots != NULL);
+  table->capacity = capacity;
+  table->num_deleted = 0;
+
+  // Move the old elements over.  Keys are known to be distinct, so each
+  // one just goes in the first empty slot of its probe sequence.
+  for (i = 0; i < old_capacity; i++) {
+    uint64_t hash;
+    int slot;
+
+    if (!IsFull(old_ctrl[i])) {
+      continue;
+    }
+    hash = MixKey(old_slots[i].key);
+    for (slot = hash & mask; table->ctrl[slot] != FHT_CTRL_EMPTY;
+         slot = (slot + 1) & mask) { }
+    table->ctrl[slot] = CtrlForHash(hash);
+    table->slots[slot] = old_slots[i];
+  }
+
+  free(old_ctrl);
+  free(old_slots);
+}
+
+static void MaybeResize(HashTable *table) {
+  int capacity;
+
+  // Nothing to do if the load factor (counting tombstones, which also
+  // lengthen probe sequences) stays at or below 7/8.
+  if ((int64_t) (table->num_elements + table->num_deleted + 1) * 8
+      <= (int64_t) table->capacity * 7) {
+    return;
+  }
+
+  // Pick a capacity that leaves the table at most half full.  If most of
+  // the load was tombstones, that's the current capacity, and we just
+  // rehash in place to sweep them out.
+  capacity = table->capacity;
+  while ((int64_t) (table->num_elements + 1) * 2 > capacity) {
+    capacity *= 2;
+  }
+  Rehash(table, capacity);
+}
+
+static void ClearSlot(HashTable *table, int slot) {
+  int mask = table->capacity - 1;
+
+  // If the next slot is empty, no probe sequence can run through this
+  // one, so it can go straight back to being empty.  Otherwise leave a
+  // tombstone so that lookups keep probing past it.
+  if (table->ctrl[(slot + 1) & mask] == FHT_CTRL_EMPTY) {
+    table->ctrl[slot] = FHT_CTRL_EMPTY;
+  } else {
+    table->ctrl[slot] = FHT_CTRL_DELETED;
+    table->num_deleted++;
+  }
+  table->num_elements--;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_FLATHASHTABLE_PRIV_H_
+#define HW1_FLATHASHTABLE_PRIV_H_
+
+#include <stdint.h>  // for int8_t
+
+#include "./HashTable.h"  // for HTKeyValue_t, etc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal structures for the open-addressing implementation of the
+// HashTable API (FlatHashTable.c).  This file is only meant to be
+// included by FlatHashTable.c and by white-box tests of it.
+//
+// FlatHashTable.c is a drop-in replacement for HashTable.c: it exports
+// the same HashTable_* and HTIterator_* functions (see HashTable.h), so
+// exactly one of the two should be linked into libhw1.a.  Since client
+// code only uses the public API, MemIndex, DocTable and FileParser
+// switch to it without any source changes.
+//
+// Rather than an array of LinkedList chains, the table is a single
+// contiguous array of HTKeyValue_t "slots", probed linearly, plus a
+// parallel array of one-byte "control" entries.  A control byte is
+// either FHT_CTRL_EMPTY, FHT_CTRL_DELETED, or (for a full slot) the top
+// 7 bits of the mixed key.  Probes compare control bytes first, so most
+// mismatching slots are rejected without touching the slot array.
+
+// The control byte values for slots that don't hold an element.  Both
+// have their high bit set, which a full slot's control byte never does.
+#define FHT_CTRL_EMPTY   ((int8_t) -128)  // 0x80
+#define FHT_CTRL_DELETED ((int8_t) -2)    // 0xFE
+
+// The smallest number of slots we'll allocate.  Must be a power of two.
+#define FHT_MIN_CAPACITY 16
+
+// This is the struct that we use to represent a hash table.
+struct ht {
+  int           capacity;      // # of slots; always a power of two
+  int           num_elements;  // # of full slots
+  int           num_deleted;   // # of tombstoned (FHT_CTRL_DELETED) slots
+  int8_t       *ctrl;          // array of "capacity" control bytes
+  HTKeyValue_t *slots;         // array of "capacity" key/value pairs
+};
+
+// This is the struct that we use to represent an iterator.  An iterator
+// is just the index of a full slot, or "capacity" once it has walked
+// off the end of the table.
+struct ht_it {
+  HashTable *ht;    // the HT we're pointing into
+  int        slot;  // the slot we're looking at
+};
+
+#endif  // HW1_FLATHASHTABLE_PRIV_H_
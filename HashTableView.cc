@@ -0,0 +1,77 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./HashTableView.h"
+
+#include <stdint.h>  // for uint32_t, etc.
+#include <memory>    // for std::shared_ptr.
+
+#include "./LayoutStructs.h"
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::shared_ptr;
+
+namespace hw3 {
+
+HashTableView::HashTableView(shared_ptr<const IndexFileSource> file,
+                             IndexFileOffset_t offset)
+  : file_(file), offset_(offset) {
+  // Cache the bucket list header.  Unlike HashTableReader, we treat a
+  // header that isn't inside the file as corruption rather than
+  // limping along with an uninitialized bucket count.
+  Verify333(file_ != nullptr);
+  Verify333(file_->ReadRecord(offset_, &header_));
+  Verify333(header_.num_buckets > 0);
+}
+
+int HashTableView::num_elements() const {
+  // Add up the lengths of all of the buckets' chains.
+  int num_elements = 0;
+  for (int i = 0; i < header_.num_buckets; i++) {
+    BucketRecord bucket;
+    if (!file_->ReadRecord(offset_ + sizeof(BucketListHeader)
+                           + sizeof(BucketRecord) * i, &bucket)) {
+      break;
+    }
+    num_elements += bucket.chain_num_elements;
+  }
+  return num_elements;
+}
+
+bool HashTableView::LookupBucket(HTKey_t hash_key,
+                                 BucketRecord* const bucket) const {
+  // Figure out which bucket the hash value is in.  We assume
+  // hash values are mapped to buckets using the modulo (%) operator.
+  int bucket_num = hash_key % header_.num_buckets;
+
+  // The bucket records immediately follow the bucket list header.
+  IndexFileOffset_t bucket_rec_offset =
+      offset_ + sizeof(BucketListHeader) + sizeof(BucketRecord) * bucket_num;
+  return file_->ReadRecord(bucket_rec_offset, bucket);
+}
+
+bool HashTableView::LookupElementPosition(
+    const BucketRecord& bucket, int index,
+    IndexFileOffset_t* const element_pos) const {
+  ElementPositionRecord element_rec;
+  if (!file_->ReadRecord(bucket.position
+                         + sizeof(ElementPositionRecord) * index,
+                         &element_rec)) {
+    return false;
+  }
+  *element_pos = element_rec.position;
+  return true;
+}
+
+}  // namespace hw3
@@ -0,0 +1,76 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_HASHTABLEVIEW_H_
+#define HW3_HASHTABLEVIEW_H_
+
+#include <memory>  // for std::shared_ptr.
+
+extern "C" {
+  #include "libhw1/HashTable.h"  // for HTKey_t.
+}
+#include "./IndexFileSource.h"
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A HashTableView is the shareable counterpart of HashTableReader: it
+// knows how to walk one of the on-disk hash tables stored within an
+// index file.  Instead of owning a (FILE*), a view reads through an
+// IndexFileSource (either a memory mapping or a pread()'able
+// descriptor) that it shares with every other view of the same index
+// file.  Since neither the view nor the source mutates any state after
+// construction, all of the lookup methods are const and safe to call
+// concurrently from multiple threads.
+//
+// Like HashTableReader, this is a base class for the table-specific
+// views (DocTableView, IndexTableView, and DocIDTableView).
+class HashTableView {
+ public:
+  virtual ~HashTableView() { }
+
+  // Returns the number of elements in the hash table.  This only reads
+  // the bucket records, not the elements themselves.
+  int num_elements() const;
+
+ protected:
+  // Construct a new HashTableView over the hash table stored at byte
+  // offset "offset" of the index file "file".
+  HashTableView(std::shared_ptr<const IndexFileSource> file,
+                IndexFileOffset_t offset);
+
+  // Fetches the BucketRecord for the bucket that "hash_key" falls into.
+  // Returns false if the record can't be read.
+  bool LookupBucket(HTKey_t hash_key, BucketRecord* const bucket) const;
+
+  // Fetches the byte offset of the "index"'th element of the chain
+  // described by "bucket".  Returns false if the ElementPositionRecord
+  // can't be read.
+  bool LookupElementPosition(const BucketRecord& bucket, int index,
+                             IndexFileOffset_t* const element_pos) const;
+
+  // The index file we're viewing.
+  std::shared_ptr<const IndexFileSource> file_;
+
+  // The byte offset within the file that this hash table starts at.
+  IndexFileOffset_t offset_;
+
+  // A cached, host-format copy of the hash table's header.
+  BucketListHeader header_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HashTableView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_HASHTABLEVIEW_H_
@@ -9,7 +9,10 @@
  * author.
  */
 
+#include <unistd.h>
 #include <boost/algorithm/string.hpp>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -23,12 +26,15 @@
 #include "./HttpUtils.h"
 #include "./HttpServer.h"
 #include "./libhw3/QueryProcessor.h"
+#include "./libhw3/QueryWorkerPool.h"
+#include "./libhw3/ReloadingQueryProcessor.h"
 
 using std::cerr;
 using std::cout;
 using std::endl;
 using std::list;
 using std::map;
+using std::shared_ptr;
 using std::string;
 using std::stringstream;
 using std::unique_ptr;
@@ -57,9 +63,25 @@ static const char* kThreegleStr =
   "</form>\n"
   "</center><p>\n";
 
+// The number of query results shown on each page of results.
+static const int kResultsPerPage = 20;
+
 // static
 const int HttpServer::kNumThreads = 100;
 
+// An HttpServerTask that also carries a pointer to the server's
+// ReloadingQueryProcessor.  It's built once in Run() and shared by every
+// worker thread.  Each query gets the latest QueryProcessor from it,
+// whose ProcessQuery() is const and only reads from the memory-mapped
+// indices, so no further locking is needed.
+class QueryServerTask : public HttpServerTask {
+ public:
+  explicit QueryServerTask(ThreadPool::thread_task_fn f)
+    : HttpServerTask(f), query_processor(nullptr) { }
+
+  hw3::ReloadingQueryProcessor* query_processor;
+};
+
 // This is the function that threads are dispatched into
 // in order to process new client connections.
 static void HttpServer_ThrFn(ThreadPool::Task* t);
@@ -67,7 +89,7 @@ static void HttpServer_ThrFn(ThreadPool::Task* t);
 // Given a request, produce a response.
 static HttpResponse ProcessRequest(const HttpRequest& req,
                             const string& base_dir,
-                            const list<string>& indices);
+                            hw3::ReloadingQueryProcessor* qp);
 
 // Process a file request.
 static HttpResponse ProcessFileRequest(const string& uri,
@@ -75,7 +97,12 @@ static HttpResponse ProcessFileRequest(const string& uri,
 
 // Process a query request.
 static HttpResponse ProcessQueryRequest(const string& uri,
-                                 const list<string>& indices);
+                                 hw3::ReloadingQueryProcessor* qp);
+
+// Append a link to page "page" of the results for "query" to "ret",
+// asking for an exact count of the results if "exact_count" is true.
+static void AppendPageLink(const string& query, int page, bool exact_count,
+                           const string& text, HttpResponse* ret);
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -90,14 +117,27 @@ bool HttpServer::Run(void) {
     return false;
   }
 
+  // Open the indices once, up front, rather than once per query.  We
+  // skip checksum validation to keep startup fast, just as the
+  // per-request QueryProcessors used to.  Queries against several
+  // indices fan out across a pool of one thread per CPU, which all of
+  // the connection threads share.  Indices kept up to date by
+  // updateindex are searched along with their deltas, and reloaded when
+  // it publishes a new one.
+  cout << "  loading indices..." << endl;
+  long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);  // NOLINT(runtime/int)
+  hw3::QueryWorkerPool query_pool(num_cpus > 0 ? num_cpus : 1);
+  hw3::ReloadingQueryProcessor qp(indices_, false, true, &query_pool);
+
   // Spin, accepting connections and dispatching them.  Use a
   // threadpool to dispatch connections into their own thread.
   cout << "  accepting connections..." << endl << endl;
   ThreadPool tp(kNumThreads);
   while (1) {
-    HttpServerTask* hst = new HttpServerTask(HttpServer_ThrFn);
+    QueryServerTask* hst = new QueryServerTask(HttpServer_ThrFn);
     hst->base_dir = static_file_dir_path_;
     hst->indices = &indices_;
+    hst->query_processor = &qp;
     if (!socket_.Accept(&hst->client_fd,
                     &hst->c_addr,
                     &hst->c_port,
@@ -115,9 +155,9 @@ bool HttpServer::Run(void) {
 }
 
 static void HttpServer_ThrFn(ThreadPool::Task* t) {
-  // Cast back our HttpServerTask structure with all of our new
+  // Cast back our QueryServerTask structure with all of our new
   // client's information in it.
-  unique_ptr<HttpServerTask> hst(static_cast<HttpServerTask*>(t));
+  unique_ptr<QueryServerTask> hst(static_cast<QueryServerTask*>(t));
   cout << "  client " << hst->c_dns << ":" << hst->c_port << " "
        << "(IP address " << hst->c_addr << ")" << " connected." << endl;
 
@@ -142,7 +182,8 @@ static void HttpServer_ThrFn(ThreadPool::Task* t) {
       done = true;
     }
 
-    HttpResponse rep = ProcessRequest(req, hst->base_dir, *hst->indices);
+    HttpResponse rep = ProcessRequest(req, hst->base_dir,
+                                      hst->query_processor);
     
     if (!hc.WriteResponse(rep)) {
       close(hst->client_fd);
@@ -153,14 +194,14 @@ static void HttpServer_ThrFn(ThreadPool::Task* t) {
 
 static HttpResponse ProcessRequest(const HttpRequest& req,
                             const string& base_dir,
-                            const list<string>& indices) {
+                            hw3::ReloadingQueryProcessor* qp) {
   // Is the user asking for a static file?
   if (req.uri().substr(0, 8) == "/static/") {
     return ProcessFileRequest(req.uri(), base_dir);
   }
 
   // The user must be asking for a query.
-  return ProcessQueryRequest(req.uri(), indices);
+  return ProcessQueryRequest(req.uri(), qp);
 }
 
 static HttpResponse ProcessFileRequest(const string& uri,
@@ -244,7 +285,7 @@ static HttpResponse ProcessFileRequest(const string& uri,
 }
 
 static HttpResponse ProcessQueryRequest(const string& uri,
-                                 const list<string>& indices) {
+                                 hw3::ReloadingQueryProcessor* qp) {
   // The response we're building up.
   HttpResponse ret;
 
@@ -261,8 +302,8 @@ static HttpResponse ProcessQueryRequest(const string& uri,
   //    search terms from a typed-in search query.  convert them
   //    to lower case.
   //
-  // 4. Initialize and use hw3::QueryProcessor to process queries with the
-  //    search indices.
+  // 4. Use the server's shared hw3::ReloadingQueryProcessor to process
+  //    queries against the search indices.
   //
   // 5. With your results, try figuring out how to hyperlink results to file
   //    contents, like in solution_binaries/http333d. (Hint: Look into HTML
@@ -275,16 +316,39 @@ static HttpResponse ProcessQueryRequest(const string& uri,
   p.Parse(uri);
   std::string query = p.args()["terms"];
   boost::trim(query);
-  boost::to_lower(query);
 
  if (!query.empty()) {
     std::vector<std::string> qvec;
     boost::split(qvec, query, boost::is_any_of(" "), boost::token_compress_on);
 
-    hw3::QueryProcessor qp(indices, false);
-    std::vector<hw3::QueryProcessor::QueryResult> qr = qp.ProcessQuery(qvec);
+    // Figure out which page of results was asked for.  Anything that
+    // isn't a page number gets the first page.
+    int page = atoi(p.args()["page"].c_str());
+    if (page < 1 || page > INT_MAX / kResultsPerPage) {
+      page = 1;
+    }
+
+    // Only the results on this page are fetched (and have their
+    // document names looked up), plus one more, which tells us whether
+    // there's a next page.  Counting every match would rule out the
+    // query processor's pruning (see QueryProcessor.h), so it's only
+    // done when the URL asks for it with "count=exact".  Only queries
+    // need the indices, so only they check whether the indices have been
+    // updated.
+    bool exact_count = (p.args()["count"] == "exact");
+    shared_ptr<const hw3::QueryProcessor> current = qp->Get();
+    int num_results = 0;
+    std::vector<hw3::QueryProcessor::QueryResult> qr =
+        current->ProcessQuery(qvec, kResultsPerPage + 1,
+                              (page - 1) * kResultsPerPage,
+                              exact_count ? &num_results : nullptr);
+    bool has_next = static_cast<int>(qr.size()) > kResultsPerPage;
+    if (has_next) {
+      qr.pop_back();
+    }
+    int first = (page - 1) * kResultsPerPage + 1;
 
-  if (qr.empty()) {
+  if (exact_count ? num_results == 0 : qr.empty() && page == 1) {
       // no matched documents found
       ret.AppendToBody("<p><br>\r\n");
       ret.AppendToBody("No results found for <b>");
@@ -292,15 +356,24 @@ static HttpResponse ProcessQueryRequest(const string& uri,
       ret.AppendToBody("</b>\r\n");
       ret.AppendToBody("<p>\r\n");
     } else {
-      // display the number of results found
+      // display the number of results found, if we counted them, and
+      // which of them are on this page
       std::stringstream ss;
       ret.AppendToBody("<p><br>\r\n");
-      ss << qr.size();
+      if (exact_count) {
+        ss << num_results;
+        ss << ((num_results == 1) ? " result " : " results ");
+        ss << "found for <b>" << EscapeHtml(query) << "</b>\r\n";
+        if (num_results > kResultsPerPage && !qr.empty()) {
+          ss << " (showing " << first << "-" << first + qr.size() - 1 << ")";
+        }
+      } else if (qr.empty()) {
+        ss << "No more results for <b>" << EscapeHtml(query) << "</b>\r\n";
+      } else {
+        ss << "Results " << first << "-" << first + qr.size() - 1
+           << " for <b>" << EscapeHtml(query) << "</b>\r\n";
+      }
       ret.AppendToBody(ss.str());
-      ret.AppendToBody((qr.size() == 1) ? " result " : " results ");
-      ret.AppendToBody("found for <b>");
-      ret.AppendToBody(EscapeHtml(query));
-      ret.AppendToBody("</b>\r\n");
       ret.AppendToBody("<p>\r\n\r\n");
 
       // display each matched document with hyperlink
@@ -321,6 +394,20 @@ static HttpResponse ProcessQueryRequest(const string& uri,
         ret.AppendToBody("]<br>\r\n");
       }
       ret.AppendToBody("</ul>\r\n");
+
+      // link to the neighboring pages
+      bool has_prev = page > 1;
+      if (has_prev || has_next) {
+        ret.AppendToBody("<center>\r\n");
+        if (has_prev) {
+          AppendPageLink(query, page - 1, exact_count, "&laquo; Previous",
+                         &ret);
+        }
+        if (has_next) {
+          AppendPageLink(query, page + 1, exact_count, "Next &raquo;", &ret);
+        }
+        ret.AppendToBody("</center>\r\n");
+      }
   }
  }
  
@@ -335,4 +422,28 @@ static HttpResponse ProcessQueryRequest(const string& uri,
 
   return ret;
 }
-}  // namespace hw4
\ No newline at end of file
+
+static void AppendPageLink(const string& query, int page, bool exact_count,
+                           const string& text, HttpResponse* ret) {
+  // URI-encode the query, so that URLParser gives it back to us intact.
+  stringstream ss;
+  ss << "/query?terms=";
+  for (unsigned char c : query) {
+    if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      ss << c;
+    } else if (c == ' ') {
+      ss << '+';
+    } else {
+      static const char* kHexDigits = "0123456789ABCDEF";
+      ss << '%' << kHexDigits[c >> 4] << kHexDigits[c & 0xF];
+    }
+  }
+  ss << "&amp;page=" << page;
+  if (exact_count) {
+    ss << "&amp;count=exact";
+  }
+
+  ret->AppendToBody(" <a href=\"" + ss.str() + "\">" + text + "</a>\r\n");
+}
+
+}  // namespace hw4
@@ -0,0 +1,731 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./IncrementalIndex.h"
+
+#include <errno.h>        // for errno, EINTR.
+#include <fcntl.h>        // for open().
+#include <inttypes.h>     // for PRIu64, SCNu64, etc.
+#include <stdint.h>       // for uint32_t, int64_t, etc.
+#include <stdio.h>        // for FILE, fopen(), getline(), rename(), etc.
+#include <pthread.h>      // for pthread_mutex_lock(), etc.
+#include <stdlib.h>       // for free(), strtol().
+#include <string.h>       // for strncmp().
+#include <sys/stat.h>     // for stat().
+#include <unistd.h>       // for read(), close(), unlink().
+#include <algorithm>      // for std::find(), std::max(), etc.
+#include <list>           // for std::list.
+#include <string>         // for std::string, std::to_string().
+#include <unordered_map>  // for std::unordered_map.
+#include <unordered_set>  // for std::unordered_set.
+#include <vector>         // for std::vector.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw2/DocTable.h"
+  #include "libhw2/MemIndex.h"
+}
+#include "./BuildIndex.h"
+#include "./DocTableView.h"
+#include "./FastCRC32.h"
+#include "./IndexFileSource.h"
+#include "./IndexMerger.h"
+#include "./WriteIndex.h"
+
+using std::find;
+using std::list;
+using std::max;
+using std::max_element;
+using std::sort;
+using std::string;
+using std::to_string;
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+namespace hw3 {
+
+// The first line of a manifest file.  The second is the root directory,
+// the third and fourth list the live and retired batch segments:
+//
+//   batches N...
+//   retired N...
+//
+// and the rest are entries, one per file:
+//
+//   segment doc_id inode mtime_ns size crc path
+//
+// where "segment" is "b" for the base, "d" for the delta, or a batch
+// segment's number, and the path runs to the end of the line.  A version
+// 1 manifest has no batch segments, and so no third or fourth line.
+static constexpr char kManifestMagic[] = "cse333-manifest 2";
+static constexpr char kManifestMagicV1[] = "cse333-manifest 1";
+static constexpr int kBaseSegment = -1;
+static constexpr int kDeltaSegment = 0;
+
+// What an update learns about the tree as the crawl walks it.
+struct IncrementalIndex::UpdateState {
+  int segment;                  // the segment being built
+  bool whole_tree;              // whether the crawl covers the whole tree
+  vector<string> scope;         // if not, the paths it covers
+  unordered_set<string> seen;   // every file the walk found
+  vector<string> indexed;       // the ones it handed to the crawl
+  int num_deleted;              // how many files have gone
+  bool manifest_changed;        // whether any entry has changed
+};
+
+// Reads the header of the manifest "f" into "root_dir", "batches", and
+// "retired", using "line" and "capacity" as getline()'s buffer.  Returns
+// false if it's malformed.
+static bool ReadManifestHeader(FILE* f, char** line, size_t* capacity,
+                               string* root_dir, vector<int>* batches,
+                               vector<int>* retired);
+
+// Sets "crc" to the CRC32 of the contents of "file_name".  Returns false
+// if it can't be read.
+static bool FileCRC(const char* file_name, uint32_t* crc);
+
+// Replaces the delta "delta_file", if there is one, with an empty index.
+// Returns false on error.
+static bool ClearDelta(const string& delta_file);
+
+// Replaces the file name's ".idx" suffix, if it has one, with "suffix".
+static string ReplaceSuffix(const string& file_name, const string& suffix) {
+  static const string kIdx = ".idx";
+  if (file_name.size() >= kIdx.size()
+      && file_name.compare(file_name.size() - kIdx.size(), kIdx.size(),
+                           kIdx) == 0) {
+    return file_name.substr(0, file_name.size() - kIdx.size()) + suffix;
+  }
+  return file_name + suffix;
+}
+
+// Returns the name of the batch segment "batch" of the index "file_name".
+static string BatchFileName(const string& file_name, int batch) {
+  return ReplaceSuffix(file_name, ".batch." + to_string(batch) + ".idx");
+}
+
+string ManifestFileName(const string& file_name) {
+  return ReplaceSuffix(file_name, ".manifest");
+}
+
+string DeltaFileName(const string& file_name) {
+  return ReplaceSuffix(file_name, ".delta.idx");
+}
+
+list<string> IndexSegments(const string& file_name) {
+  list<string> segments;
+  vector<int> batches, retired;
+  FILE* f = fopen(ManifestFileName(file_name).c_str(), "r");
+  if (f != nullptr) {
+    char* line = nullptr;
+    size_t capacity = 0;
+    string root_dir;
+    if (!ReadManifestHeader(f, &line, &capacity, &root_dir, &batches,
+                            &retired)) {
+      batches.clear();
+    }
+    free(line);
+    fclose(f);
+  }
+
+  vector<string> candidates;
+  for (int batch : batches) {
+    candidates.push_back(BatchFileName(file_name, batch));
+  }
+  candidates.push_back(DeltaFileName(file_name));
+  for (const string& candidate : candidates) {
+    struct stat st;
+    if (stat(candidate.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      segments.push_back(candidate);
+    }
+  }
+  segments.push_back(file_name);
+  return segments;
+}
+
+int UpdateIndex(char* root_dir, int num_workers, size_t memory_budget,
+                bool full_rebuild, const char* file_name) {
+  IncrementalIndex index(root_dir, num_workers, memory_budget, file_name);
+  return index.Update(full_rebuild);
+}
+
+IncrementalIndex::IncrementalIndex(char* root_dir, int num_workers,
+                                   size_t memory_budget,
+                                   const char* file_name)
+  : root_dir_(root_dir), num_workers_(num_workers),
+    memory_budget_(memory_budget), file_name_(file_name),
+    manifest_file_(ManifestFileName(file_name)),
+    delta_file_(DeltaFileName(file_name)), have_manifest_(false) {
+  Verify333(pthread_mutex_init(&lock_, nullptr) == 0);
+}
+
+IncrementalIndex::~IncrementalIndex() {
+  pthread_mutex_destroy(&lock_);
+}
+
+int IncrementalIndex::Update(bool full_rebuild) {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  int result = UpdateLocked(full_rebuild);
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  return result;
+}
+
+int IncrementalIndex::UpdateLocked(bool full_rebuild) {
+  // Even a full rebuild needs the manifest's list of batch segments, to
+  // retire them.  Only update the index incrementally if we know what's
+  // in it.
+  if (!have_manifest_) {
+    have_manifest_ = ReadManifest();
+  }
+  struct stat st;
+  const bool incremental = !full_rebuild && have_manifest_
+      && stat(file_name_.c_str(), &st) == 0;
+  if (!incremental) {
+    manifest_.clear();
+  }
+
+  UpdateState state;
+  state.segment = incremental ? kDeltaSegment : kBaseSegment;
+  state.whole_tree = true;
+  state.num_deleted = 0;
+  state.manifest_changed = false;
+  BuildIndexOptions options;
+  options.filter = [this, &state](const char* file_path,
+                                  const struct stat& st) {
+    return FilterFile(&state, file_path, st);
+  };
+  if (incremental) {
+    options.finish_doc_table = [this, &state](DocTable* dt) {
+      AddTombstones(&state, dt);
+    };
+  }
+
+  // Build the new index file under a temporary name, so that the old one
+  // stays usable until the new one is complete.
+  const string target = incremental ? delta_file_ : file_name_;
+  const string new_file = ReplaceSuffix(target, ".new.idx");
+  int result = BuildIndex(root_dir_, num_workers_, memory_budget_, options,
+                          new_file.c_str());
+  if (result < 0) {
+    return result;
+  }
+
+  if (incremental) {
+    // If nothing was indexed, nothing has gone, and there are no batch
+    // segments to fold in, there's no need for a new delta, although the
+    // manifest may have new modification times.
+    if (state.indexed.empty() && state.num_deleted == 0
+        && batches_.empty()) {
+      unlink(new_file.c_str());
+      return (!state.manifest_changed || WriteManifest()) ? 0 : -1;
+    }
+
+    // The new files shadow their copies in the batch segments and the old
+    // delta, if there are any.
+    vector<string> inputs = {new_file};
+    for (int batch : batches_) {
+      inputs.push_back(SegmentFileName(batch));
+    }
+    if (stat(delta_file_.c_str(), &st) == 0) {
+      inputs.push_back(delta_file_);
+    }
+    if (inputs.size() > 1) {
+      const string merged_file = ReplaceSuffix(target, ".merged.idx");
+      result = MergeIndexFiles(inputs, merged_file.c_str(), true);
+      unlink(new_file.c_str());
+      if (result < 0) {
+        return result;
+      }
+      if (rename(merged_file.c_str(), delta_file_.c_str()) != 0) {
+        unlink(merged_file.c_str());
+        return -1;
+      }
+    } else if (rename(new_file.c_str(), delta_file_.c_str()) != 0) {
+      unlink(new_file.c_str());
+      return -1;
+    }
+    for (auto& kv : manifest_) {
+      if (kv.second.segment != kBaseSegment) {
+        kv.second.segment = kDeltaSegment;
+      }
+    }
+    RetireBatches(batches_);
+    SetDocIDs(delta_file_, kDeltaSegment);
+  } else {
+    if (rename(new_file.c_str(), file_name_.c_str()) != 0) {
+      unlink(new_file.c_str());
+      return -1;
+    }
+
+    // The new base holds everything, so an old delta or batch segment
+    // would only hide newer copies of its files.
+    if (!ClearDelta(delta_file_)) {
+      return -1;
+    }
+    RetireBatches(batches_);
+    SetDocIDs(file_name_, kBaseSegment);
+    have_manifest_ = true;
+  }
+
+  if (!WriteManifest()) {
+    return -1;
+  }
+  return result;
+}
+
+int IncrementalIndex::UpdatePaths(const vector<string>& paths) {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  if (!have_manifest_) {
+    have_manifest_ = ReadManifest();
+  }
+  struct stat st;
+  int result = (have_manifest_ && stat(file_name_.c_str(), &st) == 0)
+      ? UpdatePathsLocked(paths) : UpdateLocked(false);
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  return result;
+}
+
+int IncrementalIndex::UpdatePathsLocked(const vector<string>& paths) {
+  // Crawl each path once: drop any that lie beneath another, since
+  // crawling the directory above crawls them too.
+  unordered_set<string> path_set(paths.begin(), paths.end());
+  UpdateState state;
+  for (const string& path : path_set) {
+    bool covered = false;
+    for (size_t slash = path.find('/'); !covered && slash != string::npos;
+         slash = path.find('/', slash + 1)) {
+      covered = slash > 0 && slash + 1 < path.size()
+          && (path_set.count(path.substr(0, slash)) > 0
+              || path_set.count(path.substr(0, slash + 1)) > 0);
+    }
+    if (!covered) {
+      state.scope.push_back(path);
+    }
+  }
+  if (state.scope.empty()) {
+    return 0;
+  }
+  sort(state.scope.begin(), state.scope.end());
+
+  // Number the batch after every segment that might still be open.
+  const int batch = 1 + max(
+      batches_.empty() ? 0 : *max_element(batches_.begin(), batches_.end()),
+      retired_.empty() ? 0 : *max_element(retired_.begin(), retired_.end()));
+  state.segment = batch;
+  state.whole_tree = false;
+  state.num_deleted = 0;
+  state.manifest_changed = false;
+  BuildIndexOptions options;
+  options.paths = state.scope;
+  options.filter = [this, &state](const char* file_path,
+                                  const struct stat& st) {
+    return FilterFile(&state, file_path, st);
+  };
+  options.finish_doc_table = [this, &state](DocTable* dt) {
+    AddTombstones(&state, dt);
+  };
+  const string batch_file = SegmentFileName(batch);
+  const string new_file = ReplaceSuffix(batch_file, ".new.idx");
+  int result = BuildIndex(root_dir_, num_workers_, memory_budget_, options,
+                          new_file.c_str());
+  if (result < 0) {
+    return result;
+  }
+
+  if (state.indexed.empty() && state.num_deleted == 0) {
+    unlink(new_file.c_str());
+    return (!state.manifest_changed || WriteManifest()) ? 0 : -1;
+  }
+  if (rename(new_file.c_str(), batch_file.c_str()) != 0) {
+    unlink(new_file.c_str());
+    return -1;
+  }
+  batches_.insert(batches_.begin(), batch);
+  SetDocIDs(batch_file, batch);
+  if (!WriteManifest()) {
+    return -1;
+  }
+  return result;
+}
+
+int IncrementalIndex::num_batches() {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  int result = batches_.size();
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  return result;
+}
+
+int IncrementalIndex::Compact() {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  const vector<int> batches = batches_;
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  if (batches.empty()) {
+    return 0;
+  }
+
+  // Merge without holding the lock: the batch segments never change once
+  // written, and only Update() and Compact() replace the delta.
+  vector<string> inputs;
+  for (int batch : batches) {
+    inputs.push_back(SegmentFileName(batch));
+  }
+  struct stat st;
+  if (stat(delta_file_.c_str(), &st) == 0) {
+    inputs.push_back(delta_file_);
+  }
+  const string merged_file = ReplaceSuffix(delta_file_, ".compact.idx");
+  int result = MergeIndexFiles(inputs, merged_file.c_str(), true);
+  if (result < 0) {
+    return result;
+  }
+
+  // Newer batch segments may have been published meanwhile.  They still
+  // shadow the new delta, and their files' entries stay theirs.
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  bool ok = rename(merged_file.c_str(), delta_file_.c_str()) == 0;
+  if (ok) {
+    for (auto& kv : manifest_) {
+      if (find(batches.begin(), batches.end(), kv.second.segment)
+          != batches.end()) {
+        kv.second.segment = kDeltaSegment;
+      }
+    }
+    SetDocIDs(delta_file_, kDeltaSegment);
+    RetireBatches(batches);
+    ok = WriteManifest();
+  } else {
+    unlink(merged_file.c_str());
+  }
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  return ok ? result : -1;
+}
+
+bool IncrementalIndex::FilterFile(UpdateState* state, const char* file_path,
+                                  const struct stat& st) {
+  Entry entry;
+  entry.segment = state->segment;
+  entry.doc_id = INVALID_DOCID;
+  entry.inode = st.st_ino;
+  entry.mtime_ns = st.st_mtim.tv_sec * INT64_C(1000000000)
+                   + st.st_mtim.tv_nsec;
+  entry.size = st.st_size;
+  entry.crc = 0;
+
+  string path(file_path);
+  state->seen.insert(path);
+  auto it = manifest_.find(path);
+  if (it != manifest_.end()) {
+    Entry& old_entry = it->second;
+    if (old_entry.inode == entry.inode && old_entry.mtime_ns == entry.mtime_ns
+        && old_entry.size == entry.size) {
+      // It hasn't been touched.
+      return false;
+    }
+    if (FileCRC(file_path, &entry.crc) && entry.crc == old_entry.crc
+        && entry.size == old_entry.size) {
+      // It's been touched, but its contents are the same.
+      old_entry.inode = entry.inode;
+      old_entry.mtime_ns = entry.mtime_ns;
+      state->manifest_changed = true;
+      return false;
+    }
+  } else {
+    // A file we can't read gets a CRC of 0, and then the crawl will fail
+    // to read it too, and give it no docID.
+    FileCRC(file_path, &entry.crc);
+  }
+
+  if (path.find('\n') == string::npos) {
+    manifest_[path] = entry;
+    state->manifest_changed = true;
+  }
+  state->indexed.push_back(path);
+  return true;
+}
+
+void IncrementalIndex::AddTombstones(UpdateState* state, DocTable* dt) {
+  // A file that's gone needs a tombstone to hide its copy in an older
+  // segment.  When only some paths were crawled, only the files at or
+  // beneath them can have gone.
+  auto bury = [this, state, dt](Manifest::iterator it) {
+    if (state->seen.count(it->first) > 0) {
+      return ++it;
+    }
+    DocTable_Add(dt, const_cast<char*>(it->first.c_str()));
+    state->num_deleted++;
+    state->manifest_changed = true;
+    return manifest_.erase(it);
+  };
+  if (state->whole_tree) {
+    for (auto it = manifest_.begin(); it != manifest_.end(); ) {
+      it = bury(it);
+    }
+  } else {
+    for (const string& path : state->scope) {
+      auto it = manifest_.find(path);
+      if (it != manifest_.end()) {
+        bury(it);
+      }
+      const string prefix = (path.back() == '/') ? path : path + '/';
+      it = manifest_.lower_bound(prefix);
+      while (it != manifest_.end()
+             && it->first.compare(0, prefix.size(), prefix) == 0) {
+        it = bury(it);
+      }
+    }
+  }
+
+  // So does a file that's changed, if the crawl couldn't index its new
+  // contents.
+  for (const string& path : state->indexed) {
+    char* doc_name = const_cast<char*>(path.c_str());
+    if (DocTable_GetDocID(dt, doc_name) == INVALID_DOCID) {
+      DocTable_Add(dt, doc_name);
+    }
+  }
+}
+
+void IncrementalIndex::SetDocIDs(const string& file_name, int segment) {
+  // We just wrote the file, so there's no need to validate it.
+  DocTableView doc_table(OpenIndexFileSource(file_name, false, true));
+  unordered_map<string, DocID_t> doc_ids;
+  for (const auto& doc : doc_table.GetDocList()) {
+    doc_ids[doc.second] = doc.first;
+  }
+  for (auto& kv : manifest_) {
+    if (kv.second.segment != segment) {
+      continue;
+    }
+    auto it = doc_ids.find(kv.first);
+    kv.second.doc_id = (it == doc_ids.end()) ? INVALID_DOCID : it->second;
+  }
+}
+
+void IncrementalIndex::RetireBatches(const vector<int>& batches) {
+  for (int batch : retired_) {
+    unlink(SegmentFileName(batch).c_str());
+  }
+  retired_ = batches;
+  for (int batch : retired_) {
+    batches_.erase(find(batches_.begin(), batches_.end(), batch));
+  }
+}
+
+string IncrementalIndex::SegmentFileName(int segment) const {
+  if (segment == kBaseSegment) {
+    return file_name_;
+  }
+  if (segment == kDeltaSegment) {
+    return delta_file_;
+  }
+  return BatchFileName(file_name_, segment);
+}
+
+bool IncrementalIndex::ReadManifest() {
+  FILE* f = fopen(manifest_file_.c_str(), "r");
+  if (f == nullptr) {
+    return false;
+  }
+
+  char* line = nullptr;
+  size_t capacity = 0;
+  string root_dir;
+  bool ok = ReadManifestHeader(f, &line, &capacity, &root_dir, &batches_,
+                                &retired_)
+      && root_dir == root_dir_;
+  ssize_t len;
+  while (ok && (len = getline(&line, &capacity, f)) != -1) {
+    if (len > 0 && line[len - 1] == '\n') {
+      line[--len] = '\0';
+    }
+    Entry entry;
+    char segment[16];
+    int path_offset = -1;
+    ok = sscanf(line, "%15s %" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64
+                " %" SCNu32 "%n",
+                segment, &entry.doc_id, &entry.inode, &entry.mtime_ns,
+                &entry.size, &entry.crc, &path_offset) == 6
+        && path_offset > 0 && path_offset + 1 < len
+        && line[path_offset] == ' ';
+    if (ok) {
+      if (strcmp(segment, "b") == 0) {
+        entry.segment = kBaseSegment;
+      } else if (strcmp(segment, "d") == 0) {
+        entry.segment = kDeltaSegment;
+      } else {
+        entry.segment = atoi(segment);
+        ok = find(batches_.begin(), batches_.end(), entry.segment)
+            != batches_.end();
+      }
+    }
+    if (ok) {
+      // The path is everything after the space, spaces and all.
+      path_offset++;
+      manifest_[string(line + path_offset, len - path_offset)] = entry;
+    }
+  }
+  ok = ok && !ferror(f);
+  free(line);
+  fclose(f);
+  if (!ok) {
+    manifest_.clear();
+  }
+  return ok;
+}
+
+bool IncrementalIndex::WriteManifest() {
+  // Write the new manifest beside the old one, and then replace it.
+  const string new_file = manifest_file_ + ".new";
+  FILE* f = fopen(new_file.c_str(), "w");
+  if (f == nullptr) {
+    return false;
+  }
+  fprintf(f, "%s\n%s\nbatches", kManifestMagic, root_dir_);
+  for (int batch : batches_) {
+    fprintf(f, " %d", batch);
+  }
+  fprintf(f, "\nretired");
+  for (int batch : retired_) {
+    fprintf(f, " %d", batch);
+  }
+  fprintf(f, "\n");
+  for (const auto& kv : manifest_) {
+    const Entry& entry = kv.second;
+    if (entry.segment == kBaseSegment) {
+      fprintf(f, "b");
+    } else if (entry.segment == kDeltaSegment) {
+      fprintf(f, "d");
+    } else {
+      fprintf(f, "%d", entry.segment);
+    }
+    fprintf(f, " %" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64 " %" PRIu32
+            " %s\n",
+            static_cast<uint64_t>(entry.doc_id), entry.inode,
+            entry.mtime_ns, entry.size, entry.crc, kv.first.c_str());
+  }
+  bool ok = !ferror(f);
+  if (fclose(f) != 0 || !ok || rename(new_file.c_str(),
+                                      manifest_file_.c_str()) != 0) {
+    unlink(new_file.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Parses the numbers that follow "keyword" on the manifest line "line"
+// into "numbers".  Returns false if the line isn't of that form.
+static bool ParseNumberList(const char* line, const char* keyword,
+                            vector<int>* numbers) {
+  size_t keyword_len = strlen(keyword);
+  if (strncmp(line, keyword, keyword_len) != 0) {
+    return false;
+  }
+  const char* next = line + keyword_len;
+  numbers->clear();
+  while (*next == ' ') {
+    char* end;
+    long number = strtol(next + 1, &end, 10);  // NOLINT(runtime/int)
+    if (end == next + 1 || number <= 0) {
+      return false;
+    }
+    numbers->push_back(number);
+    next = end;
+  }
+  return *next == '\0';
+}
+
+static bool ReadManifestHeader(FILE* f, char** line, size_t* capacity,
+                               string* root_dir, vector<int>* batches,
+                               vector<int>* retired) {
+  batches->clear();
+  retired->clear();
+  int num_lines = 2;
+  for (int line_num = 0; line_num < num_lines; line_num++) {
+    ssize_t len = getline(line, capacity, f);
+    if (len == -1) {
+      return false;
+    }
+    if (len > 0 && (*line)[len - 1] == '\n') {
+      (*line)[--len] = '\0';
+    }
+    bool ok;
+    if (line_num == 0) {
+      // A version 1 manifest has no batch segments.
+      ok = string(*line, len) == kManifestMagicV1;
+      if (!ok && string(*line, len) == kManifestMagic) {
+        ok = true;
+        num_lines = 4;
+      }
+    } else if (line_num == 1) {
+      *root_dir = string(*line, len);
+      ok = true;
+    } else {
+      ok = ParseNumberList(*line, (line_num == 2) ? "batches" : "retired",
+                           (line_num == 2) ? batches : retired);
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ClearDelta(const string& delta_file) {
+  // The delta is emptied rather than removed, so that a server reloading
+  // the index (see ReloadingQueryProcessor.h) can't find it gone between
+  // listing the segments and opening them.
+  struct stat st;
+  if (stat(delta_file.c_str(), &st) != 0) {
+    return true;
+  }
+  const string new_file = ReplaceSuffix(delta_file, ".new.idx");
+  DocTable* dt = DocTable_Allocate();
+  MemIndex* mi = MemIndex_Allocate();
+  int result = WriteIndex(mi, dt, new_file.c_str());
+  MemIndex_Free(mi);
+  DocTable_Free(dt);
+  if (result < 0) {
+    return false;
+  }
+  if (rename(new_file.c_str(), delta_file.c_str()) != 0) {
+    unlink(new_file.c_str());
+    return false;
+  }
+  return true;
+}
+
+static bool FileCRC(const char* file_name, uint32_t* crc) {
+  int fd = open(file_name, O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  FastCRC32 crc_obj;
+  static constexpr int kBufSize = 64 * 1024;
+  uint8_t buf[kBufSize];
+  while (true) {
+    ssize_t bytes_read = read(fd, buf, kBufSize);
+    if (bytes_read == -1 && errno == EINTR) {
+      continue;
+    }
+    if (bytes_read <= 0) {
+      close(fd);
+      if (bytes_read == -1) {
+        return false;
+      }
+      *crc = crc_obj.GetFinalCRC();
+      return true;
+    }
+    crc_obj.FoldBytes(buf, bytes_read);
+  }
+}
+
+}  // namespace hw3
@@ -0,0 +1,196 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_INCREMENTALINDEX_H_
+#define HW3_INCREMENTALINDEX_H_
+
+#include <pthread.h>   // for pthread_mutex_t.
+#include <stddef.h>    // for size_t.
+#include <stdint.h>    // for uint32_t, int64_t, etc.
+#include <sys/stat.h>  // for struct stat.
+#include <list>        // for std::list.
+#include <map>         // for std::map.
+#include <string>      // for std::string.
+#include <vector>      // for std::vector.
+
+extern "C" {
+  #include "libhw2/DocTable.h"
+}
+#include "./Utils.h"
+
+namespace hw3 {
+
+// An index of a directory tree can be kept up to date without
+// re-crawling the whole tree each time.  The index is then made of these
+// files, named after the base index file "foo.idx":
+//
+// - foo.idx, the base index, written by a full build.
+// - foo.manifest, which records every file the index has seen (its
+//   path, inode, modification time, size, and CRC32), which part of the
+//   index holds it, and its docID there, along with which batch segments
+//   (see below) are live.
+// - foo.delta.idx, the delta index, which holds every file that's new or
+//   changed since the base was built, plus a "tombstone" for each file
+//   that's been deleted or can no longer be indexed: a document with no
+//   words, which shadows the base's copy.
+// - foo.batch.N.idx, the batch segments, each of which holds the files
+//   that one batch of changes touched (see IncrementalIndex::UpdatePaths())
+//   and their tombstones, shadowing the delta and any older batches, until
+//   a compaction merges them into the delta.
+//
+// A QueryProcessor given the segments newest first (see IndexSegments())
+// therefore sees the tree as it was at the last update: each segment owns
+// every document it lists (see QueryProcessor.h), and the base answers
+// for the rest.
+
+// Returns the names of foo.manifest and foo.delta.idx, for the base index
+// file "file_name" (foo.idx).  A name that doesn't end in ".idx" just has
+// ".manifest" or ".delta.idx" appended.
+std::string ManifestFileName(const std::string& file_name);
+std::string DeltaFileName(const std::string& file_name);
+
+// An IncrementalIndex updates the index "file_name" of "root_dir", and
+// keeps the manifest in memory between updates, so that a long-running
+// updater (see IndexWatcher.h) needn't read it back each time.
+//
+// Only one IncrementalIndex should update an index at a time.  Each file
+// is replaced by renaming a complete new copy over it, so a failure never
+// leaves one half written.  A segment that an update or
+// compaction folds away isn't removed until the one after, so that a
+// ReloadingQueryProcessor that has just listed it can still open it.
+class IncrementalIndex {
+ public:
+  // "num_workers" and "memory_budget" are as for BuildIndex().
+  IncrementalIndex(char* root_dir, int num_workers, size_t memory_budget,
+                   const char* file_name);
+
+  ~IncrementalIndex();
+
+  // Brings the whole index up to date.
+  //
+  // If there's no manifest for it, or the manifest is of a different
+  // directory, or "full_rebuild" is true, this builds the base index from
+  // scratch, as BuildIndex() does, and empties any delta.
+  //
+  // Otherwise, it walks the tree comparing each file's inode,
+  // modification time, and size against the manifest.  Only files that
+  // are new, or whose contents have changed (a file whose metadata
+  // changed but whose CRC32 and size didn't is just noted in the
+  // manifest), are read and parsed.  They're indexed, along with
+  // tombstones for the files that have gone, and merged over the batch
+  // segments and the previous delta (see MergeIndexFiles()) to make the
+  // new delta.  The base is left alone.
+  //
+  // The delta grows with every update; a full rebuild folds it back into
+  // the base.  Paths that contain a newline can't be recorded in the
+  // manifest, so they're parsed again on every update.  Mustn't be called
+  // while a Compact() is in progress.
+  //
+  // Returns the number of bytes written to the index file that was
+  // rewritten (0 if nothing had changed), or a negative value on failure.
+  int Update(bool full_rebuild);
+
+  // Like Update(), but only looks at "paths", the files and directories
+  // beneath "root_dir" that may have changed, and publishes what changed
+  // as a new batch segment rather than rewriting the delta.  A path that
+  // names a directory stands for everything beneath it, and one that no
+  // longer exists stands for files that have gone.  If there's no
+  // manifest (or base index) yet, this is just Update(false).
+  int UpdatePaths(const std::vector<std::string>& paths);
+
+  // Returns how many batch segments are live.
+  int num_batches();
+
+  // Merges the live batch segments into the delta, and retires them.
+  // The merge doesn't hold up UpdatePaths(), so it may be run on a thread
+  // of its own; only one may run at a time, though.  Returns the number
+  // of bytes written to the delta (0 if there was nothing to merge), or a
+  // negative value on failure.
+  int Compact();
+
+ private:
+  // What the manifest records about one file.
+  struct Entry {
+    int      segment;   // the segment that holds it
+    DocID_t  doc_id;    // its docID there, or INVALID_DOCID if it has none
+    uint64_t inode;
+    int64_t  mtime_ns;  // its modification time, in ns since the epoch
+    int64_t  size;
+    uint32_t crc;       // the CRC32 of its contents
+  };
+  // Ordered, so that the files beneath a directory are easy to find.
+  typedef std::map<std::string, Entry> Manifest;
+
+  // What an update learns about the tree as the crawl walks it.
+  struct UpdateState;
+
+  // Update() and UpdatePaths(), called with "lock_" held.
+  int UpdateLocked(bool full_rebuild);
+  int UpdatePathsLocked(const std::vector<std::string>& paths);
+
+  // The crawl's filter (see BuildIndexOptions): decides, from the
+  // manifest, whether "file_path" needs to be indexed into the segment
+  // that "state" is building, and updates its entry.
+  bool FilterFile(UpdateState* state, const char* file_path,
+                  const struct stat& st);
+
+  // Adds a tombstone to "dt" for each manifest entry that "state" says
+  // has gone, or that the crawl couldn't index, and drops the former
+  // from the manifest.  Only the entries "state" covers are considered.
+  void AddTombstones(UpdateState* state, DocTable* dt);
+
+  // Sets the docIDs of the manifest entries of "segment" to those that
+  // the index file "file_name" gives their paths.
+  void SetDocIDs(const std::string& file_name, int segment);
+
+  // Reads and writes the manifest.  Return false on failure, or, when
+  // reading, if the manifest is of another directory; either way, the
+  // batch segments it lists are noted.
+  bool ReadManifest();
+  bool WriteManifest();
+
+  // Removes the segments retired earlier, and retires the live batch
+  // segments in "batches".
+  void RetireBatches(const std::vector<int>& batches);
+
+  // Returns the file name of the segment "segment".
+  std::string SegmentFileName(int segment) const;
+
+  char* const root_dir_;
+  const int num_workers_;
+  const size_t memory_budget_;
+  const std::string file_name_;
+  const std::string manifest_file_;
+  const std::string delta_file_;
+
+  pthread_mutex_t lock_;         // guards everything below
+  bool have_manifest_;           // whether "manifest_" is loaded
+  Manifest manifest_;
+  std::vector<int> batches_;     // the live batch segments, newest first
+  std::vector<int> retired_;     // those retired, but not yet removed
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementalIndex);
+};
+
+// Brings the index "file_name" of "root_dir" up to date, as
+// IncrementalIndex::Update() does.
+int UpdateIndex(char* root_dir, int num_workers, size_t memory_budget,
+                bool full_rebuild, const char* file_name);
+
+// Returns the index files that make up the index "file_name", in the
+// order a QueryProcessor should be given them: the live batch segments,
+// newest first, then the delta, if there is one, and then "file_name"
+// itself.
+std::list<std::string> IndexSegments(const std::string& file_name);
+
+}  // namespace hw3
+
+#endif  // HW3_INCREMENTALINDEX_H_
@@ -0,0 +1,138 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./IndexFileSource.h"
+
+#include <algorithm>  // for std::min().
+#include <memory>     // for std::shared_ptr.
+#include <string>     // for std::string.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+#include "./FastCRC32.h"
+#include "./MappedIndexFile.h"
+#include "./PreadIndexFile.h"
+
+using std::make_shared;
+using std::min;
+using std::shared_ptr;
+using std::string;
+
+namespace hw3 {
+
+bool IndexFileSource::ReadString(IndexFileOffset_t offset, size_t len,
+                                 string* const ret_str) const {
+  ret_str->resize(len);
+  if (len == 0) {
+    return true;
+  }
+  return ReadBytes(offset, &(*ret_str)[0], len);
+}
+
+void IndexFileSource::ReadAndValidateHeader(size_t file_length,
+                                            bool validate) {
+  // Read the header, convert it to host format, and verify that the
+  // magic number is one we know.
+  Verify333(ReadRecord(0, &header_));
+  Verify333(header_.magic_number == kMagicNumber
+            || header_.magic_number == kMagicNumberV2);
+
+  // Make sure the index file's length lines up with the header fields.
+  Verify333(file_length == sizeof(IndexFileHeader) + header_.doctable_bytes
+                           + header_.index_bytes);
+
+  if (validate) {
+    // Re-calculate the checksum over the doctable and index, and make
+    // sure it matches that in the header.
+    FastCRC32 crc_obj;
+    static constexpr int kBufSize = 64 * 1024;
+    uint8_t buf[kBufSize];
+    IndexFileOffset_t offset = sizeof(IndexFileHeader);
+    int left_to_read = header_.doctable_bytes + header_.index_bytes;
+    while (left_to_read > 0) {
+      int bytes_reading = min(kBufSize, left_to_read);
+      Verify333(ReadBytes(offset, buf, bytes_reading));
+      crc_obj.FoldBytes(buf, bytes_reading);
+      offset += bytes_reading;
+      left_to_read -= bytes_reading;
+    }
+    Verify333(crc_obj.GetFinalCRC() == header_.checksum);
+  }
+
+  if (format_version() == 2) {
+    ReadSectionDirectory();
+  }
+}
+
+void IndexFileSource::ReadSectionDirectory() {
+  // The footer is the last thing in the index region, and the records
+  // immediately precede it.
+  IndexFileOffset_t region_end = index_offset() + header_.index_bytes;
+  SectionDirectoryFooter footer;
+  Verify333(header_.index_bytes
+            >= static_cast<int32_t>(sizeof(SectionDirectoryFooter)));
+  Verify333(ReadRecord(region_end - sizeof(SectionDirectoryFooter), &footer));
+  Verify333(footer.num_sections >= 0);
+  Verify333(footer.num_sections
+            <= static_cast<int32_t>((header_.index_bytes
+                                     - sizeof(SectionDirectoryFooter))
+                                    / sizeof(SectionRecord)));
+
+  IndexFileOffset_t record_pos = region_end - sizeof(SectionDirectoryFooter)
+    - footer.num_sections * sizeof(SectionRecord);
+  for (int i = 0; i < footer.num_sections; i++) {
+    SectionRecord record;
+    Verify333(ReadRecord(record_pos, &record));
+
+    // Every section must lie within the index region, before the
+    // directory.
+    Verify333(record.position >= index_offset());
+    Verify333(record.bytes >= 0);
+    Verify333(record.bytes <= record_pos - record.position);
+    sections_.push_back(record);
+    record_pos += sizeof(SectionRecord);
+  }
+}
+
+bool IndexFileSource::FindSection(int32_t section_id,
+                                  IndexFileOffset_t* const offset,
+                                  int32_t* const bytes) const {
+  for (const SectionRecord& record : sections_) {
+    if (record.section_id == section_id) {
+      *offset = record.position;
+      *bytes = record.bytes;
+      return true;
+    }
+  }
+  return false;
+}
+
+IndexFileOffset_t IndexFileSource::word_table_offset() const {
+  if (format_version() == 1) {
+    return index_offset();
+  }
+
+  IndexFileOffset_t offset;
+  int32_t bytes;
+  Verify333(FindSection(kWordTableSection, &offset, &bytes));
+  return offset;
+}
+
+shared_ptr<const IndexFileSource>
+OpenIndexFileSource(const string& file_name, bool validate, bool use_mmap) {
+  if (use_mmap) {
+    return make_shared<const MappedIndexFile>(file_name, validate);
+  }
+  return make_shared<const PreadIndexFile>(file_name, validate);
+}
+
+}  // namespace hw3
@@ -0,0 +1,147 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_INDEXFILESOURCE_H_
+#define HW3_INDEXFILESOURCE_H_
+
+#include <stdint.h>  // for uint8_t, etc.
+#include <cstddef>   // for size_t.
+#include <memory>    // for std::shared_ptr.
+#include <string>    // for std::string.
+#include <vector>    // for std::vector.
+
+#include "./LayoutStructs.h"
+#include "./LayoutStructsV2.h"
+#include "./Utils.h"  // for DISALLOW_COPY_AND_ASSIGN().
+
+namespace hw3 {
+
+// An IndexFileSource provides positional, read-only access to the bytes
+// of a single index file.  It is the abstraction that the HashTableView
+// family of classes is built on.
+//
+// Every read names its own offset, so a source carries no file position
+// or other mutable state after construction; all of its methods may be
+// called concurrently from any number of threads.  This is what lets a
+// single set of views serve a whole thread pool without dup()'ing
+// descriptors.
+//
+// There are two implementations: MappedIndexFile, which maps the file
+// into memory, and PreadIndexFile, which issues one pread() per read.
+//
+// Both versions of the file format are supported (see LayoutStructsV2.h);
+// format_version() says which one the file is in.
+class IndexFileSource {
+ public:
+  virtual ~IndexFileSource() { }
+
+  // Accessors.
+  const std::string& file_name() const { return file_name_; }
+  IndexFileOffset_t doctable_size() const { return header_.doctable_bytes; }
+  IndexFileOffset_t index_size() const { return header_.index_bytes; }
+
+  // The byte offsets of the docid->name table and of the word->postings
+  // table within the file.
+  IndexFileOffset_t doctable_offset() const {
+    return sizeof(IndexFileHeader);
+  }
+  IndexFileOffset_t index_offset() const {
+    return sizeof(IndexFileHeader) + header_.doctable_bytes;
+  }
+
+  // Returns 1 or 2, depending on the format the file is in.
+  int format_version() const {
+    return header_.magic_number == kMagicNumberV2 ? 2 : 1;
+  }
+
+  // Looks up a section of a v2 index region in its directory.  Returns
+  // false if the file is a v1 file or has no such section; otherwise
+  // returns the section's byte offset and length through the output
+  // parameters.
+  bool FindSection(int32_t section_id, IndexFileOffset_t* const offset,
+                   int32_t* const bytes) const;
+
+  // The byte offset of the word->postings hash table: the start of the
+  // index region in a v1 file, or its kWordTableSection in a v2 file.
+  IndexFileOffset_t word_table_offset() const;
+
+  // Copies the "len" bytes starting at byte "offset" of the file into
+  // "buf".  Returns false if that range doesn't lie within the file or
+  // can't be read.
+  virtual bool ReadBytes(IndexFileOffset_t offset, void* buf,
+                         size_t len) const = 0;
+
+  // If the file is resident in memory, returns a pointer to the "len"
+  // bytes starting at byte "offset" of the file, which stays valid for
+  // the lifetime of the source.  Otherwise, or if that range doesn't lie
+  // within the file, returns nullptr, and the caller should ReadBytes()
+  // instead.
+  virtual const uint8_t* BytesAt(IndexFileOffset_t offset,
+                                 size_t len) const {
+    return nullptr;
+  }
+
+  // Reads "len" bytes starting at byte "offset" into "ret_str".
+  // Returns false if that range doesn't lie within the file or can't be
+  // read.
+  virtual bool ReadString(IndexFileOffset_t offset, size_t len,
+                          std::string* const ret_str) const;
+
+  // Reads one of the on-disk structures from LayoutStructs.h at byte
+  // "offset" and converts it to host format.  Returns false if the
+  // structure doesn't lie within the file or can't be read.
+  template <typename T>
+  bool ReadRecord(IndexFileOffset_t offset, T* const rec) const {
+    if (!ReadBytes(offset, rec, sizeof(T))) {
+      return false;
+    }
+    rec->ToHostFormat();
+    return true;
+  }
+
+ protected:
+  explicit IndexFileSource(const std::string& file_name)
+    : file_name_(file_name) { }
+
+  // Reads and checks the index file header against the file's length
+  // and, if "validate" is true, re-calculates the checksum.  For a v2
+  // file, also reads the section directory.  Crashes (via Verify333) if
+  // the file is malformed.  Subclasses must call this at the end of their
+  // constructor, once ReadBytes() works.
+  void ReadAndValidateHeader(size_t file_length, bool validate);
+
+  // The name of the index file.
+  std::string file_name_;
+
+  // A host-format copy of the index file header.
+  IndexFileHeader header_;
+
+  // Host-format copies of a v2 file's section directory entries.
+  std::vector<SectionRecord> sections_;
+
+ private:
+  // Reads a v2 file's section directory into "sections_".
+  void ReadSectionDirectory();
+
+  DISALLOW_COPY_AND_ASSIGN(IndexFileSource);
+};
+
+// Opens "file_name" as an IndexFileSource, memory-mapping it if
+// "use_mmap" is true and reading it with pread() otherwise.  See the
+// MappedIndexFile and PreadIndexFile constructors for the meaning of
+// "validate".
+std::shared_ptr<const IndexFileSource>
+OpenIndexFileSource(const std::string& file_name, bool validate,
+                    bool use_mmap);
+
+}  // namespace hw3
+
+#endif  // HW3_INDEXFILESOURCE_H_
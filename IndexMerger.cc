@@ -0,0 +1,405 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./IndexMerger.h"
+
+#include <stdint.h>       // for uint8_t, uint32_t, etc.
+#include <algorithm>      // for std::sort().
+#include <iostream>       // for std::cerr.
+#include <limits>         // for std::numeric_limits.
+#include <memory>         // for std::shared_ptr, std::unique_ptr.
+#include <string>         // for std::string.
+#include <unordered_map>  // for std::unordered_map.
+#include <unordered_set>  // for std::unordered_set.
+#include <utility>        // for std::pair.
+#include <vector>         // for std::vector.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+  #include "libhw2/DocTable.h"
+}
+#include "./DocStatsView.h"
+#include "./DocTableView.h"
+#include "./IndexFileSource.h"
+#include "./IndexTableView.h"
+#include "./LayoutStructsV2.h"
+#include "./PostingsView.h"
+#include "./TermDictView.h"
+#include "./WriteIndexRuns.h"
+
+using std::cerr;
+using std::endl;
+using std::pair;
+using std::shared_ptr;
+using std::sort;
+using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+namespace hw3 {
+
+// How many words IndexPostingsStream reads from a term dictionary at a
+// time.
+static constexpr size_t kTermsPerPage = 4096;
+
+// What an input file's documents are renumbered to: INVALID_DOCID if
+// the file's doctable doesn't have it, and kDuplicateDoc if it's dropped
+// from the merge, because an earlier file has a document of the same
+// name or because it's a tombstone that's no longer needed.
+static constexpr DocID_t kDuplicateDoc = std::numeric_limits<DocID_t>::max();
+class DocMap {
+ public:
+  DocMap() : first_doc_id_(0), sparse_(false) { }
+
+  // Empties the map, and readies it for the docIDs of "docs", which are
+  // sorted.  They're usually dense, so they're mapped through a vector
+  // indexed by docID; only if they're spread over a range much bigger
+  // than their number is it worth a hash map instead.
+  void Reset(const vector<pair<DocID_t, string>>& docs);
+
+  // Returns what "doc_id" is mapped to.
+  DocID_t Get(DocID_t doc_id) const;
+
+  // Maps "doc_id", one of the docIDs the map was Reset() for, to
+  // "new_doc_id".  Returns false if it's already mapped.
+  bool Set(DocID_t doc_id, DocID_t new_doc_id);
+
+ private:
+  // doc_ids_[i] is what first_doc_id_ + i maps to, unless sparse_.
+  DocID_t first_doc_id_;
+  vector<DocID_t> doc_ids_;
+  bool sparse_;
+  unordered_map<DocID_t, DocID_t> sparse_doc_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(DocMap);
+};
+
+// An input file's documents, sorted by docID, and their lengths.
+struct InputDocs {
+  vector<pair<DocID_t, string>> docs;
+  vector<uint32_t> lengths;  // lengths[i] is the length of docs[i]
+};
+
+// An IndexPostingsStream reads the words of an index file in sorted
+// order, renumbering their documents through a DocMap.
+class IndexPostingsStream : public PostingsStream {
+ public:
+  // Streams the words of "file", whose documents are renumbered by
+  // "doc_map".  If "with_positions" is false, GetDocs() returns each
+  // document's number of positions but not the positions themselves.
+  IndexPostingsStream(shared_ptr<const IndexFileSource> file,
+                      const DocMap* doc_map, bool with_positions)
+    : dict_(file), table_(file), doc_map_(doc_map),
+      with_positions_(with_positions), next_term_(0), more_terms_(true),
+      failed_(false) { }
+
+  // PostingsStream methods.  A word whose documents are all duplicates is
+  // skipped.
+  bool Next() override;
+  const string& word() const override { return word_; }
+  bool GetDocs(vector<PostingsDoc>* docs) const override;
+  bool failed() const override { return failed_; }
+
+ private:
+  // Reads the current word's postings into docs_ and positions_.  Returns
+  // false if they're malformed.
+  bool ReadPostings(IndexFileOffset_t element_pos);
+
+  TermDictView dict_;
+  IndexTableView table_;
+  const DocMap* doc_map_;
+  bool with_positions_;
+
+  // The words we've read from dict_ so far that we haven't streamed yet.
+  vector<TermDictView::Term> terms_;
+  size_t next_term_;
+  bool more_terms_;  // whether the dictionary has words past terms_
+
+  // The current word.  The positions of docs_[i] start
+  // positions_offsets_[i] bytes into positions_; GetDocs() fills in the
+  // pointers, since positions_ may move as it grows.
+  string word_;
+  vector<PostingsDoc> docs_;
+  vector<uint8_t> positions_;
+  vector<size_t> positions_offsets_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexPostingsStream);
+};
+
+// Reads the documents of "file" and their lengths into "input".  The
+// lengths come from the file's doc stats section, or, if it doesn't have
+// one, from counting its postings.  Returns false on error.
+static bool ReadDocuments(shared_ptr<const IndexFileSource> file,
+                          InputDocs* input);
+
+// Adds the documents of "input" that aren't in "dt" (or "dropped_names")
+// yet to "dt", setting "doc_map" to how they're renumbered and appending
+// their lengths to "lengths".  Unless "keep_tombstones" is true,
+// tombstones (documents with no postings, and so a length of 0) are
+// dropped instead, and their names added to "dropped_names" so that they
+// still hide later copies.
+static void AddDocuments(const InputDocs& input, bool keep_tombstones,
+                         DocTable* dt, unordered_set<string>* dropped_names,
+                         DocMap* doc_map, vector<uint32_t>* lengths);
+
+int MergeIndexFiles(const vector<string>& index_files, const char* file_name,
+                    bool keep_tombstones) {
+  // Build the merged DocTable, renumbering each file's documents as we
+  // go.
+  vector<shared_ptr<const IndexFileSource>> files;
+  vector<DocMap> doc_maps(index_files.size());
+  vector<uint32_t> lengths;
+  unordered_set<string> dropped_names;
+  DocTable* dt = DocTable_Allocate();
+  Verify333(dt != nullptr);
+  bool ok = true;
+  for (size_t i = 0; ok && i < index_files.size(); i++) {
+    files.push_back(OpenIndexFileSource(index_files[i], true, true));
+    InputDocs input;
+    ok = ReadDocuments(files[i], &input);
+    if (ok) {
+      AddDocuments(input, keep_tombstones, dt, &dropped_names, &doc_maps[i],
+                   &lengths);
+    }
+  }
+  if (!ok) {
+    cerr << "Error: Failed to read index files." << endl;
+    DocTable_Free(dt);
+    return -1;
+  }
+
+  // The new docIDs of each file follow on from the last one's, so the
+  // files' postings can be merged in file order.
+  int result = WriteMergedIndex(
+      dt, 1, lengths,
+      [&](vector<unique_ptr<PostingsStream>>* streams) {
+        for (size_t i = 0; i < files.size(); i++) {
+          streams->emplace_back(
+              new IndexPostingsStream(files[i], &doc_maps[i], true));
+        }
+        return true;
+      },
+      file_name);
+  DocTable_Free(dt);
+  return result;
+}
+
+static bool ReadDocuments(shared_ptr<const IndexFileSource> file,
+                          InputDocs* input) {
+  // The doctable's docIDs come back in no particular order, but the new
+  // docIDs should follow the old ones.
+  input->docs = DocTableView(file).GetDocList();
+  sort(input->docs.begin(), input->docs.end());
+  for (size_t i = 1; i < input->docs.size(); i++) {
+    if (input->docs[i].first == input->docs[i - 1].first) {
+      // The doctable is malformed: it has the docID twice.
+      return false;
+    }
+  }
+  input->lengths.assign(input->docs.size(), 0);
+
+  // Take the lengths from the doc stats section if it has all of them.
+  DocStatsView stats(file);
+  bool have_lengths = true;
+  for (size_t i = 0; have_lengths && i < input->docs.size(); i++) {
+    have_lengths = stats.HasDocLength(input->docs[i].first);
+    if (have_lengths) {
+      input->lengths[i] =
+          static_cast<uint32_t>(stats.DocLength(input->docs[i].first));
+    }
+  }
+  if (have_lengths) {
+    return true;
+  }
+
+  // Otherwise, count them.  A document's length is the number of
+  // positions recorded for it, as WriteIndex() counts it.  Number the
+  // documents by their place in "docs", plus one, so that the stream
+  // tells us where each one's length goes.
+  input->lengths.assign(input->docs.size(), 0);
+  DocMap positions_map;
+  positions_map.Reset(input->docs);
+  for (size_t i = 0; i < input->docs.size(); i++) {
+    positions_map.Set(input->docs[i].first, i + 1);
+  }
+  IndexPostingsStream stream(file, &positions_map, false);
+  vector<PostingsDoc> docs;
+  while (stream.Next()) {
+    docs.clear();
+    if (!stream.GetDocs(&docs)) {
+      return false;
+    }
+    for (const PostingsDoc& doc : docs) {
+      input->lengths[doc.doc_id - 1] += doc.num_positions;
+    }
+  }
+  return !stream.failed();
+}
+
+static void AddDocuments(const InputDocs& input, bool keep_tombstones,
+                         DocTable* dt, unordered_set<string>* dropped_names,
+                         DocMap* doc_map, vector<uint32_t>* lengths) {
+  doc_map->Reset(input.docs);
+  for (size_t i = 0; i < input.docs.size(); i++) {
+    const string& name = input.docs[i].second;
+    char* doc_name = const_cast<char*>(name.c_str());
+    DocID_t new_doc_id;
+    if (DocTable_GetDocID(dt, doc_name) != INVALID_DOCID
+        || dropped_names->count(name) > 0) {
+      new_doc_id = kDuplicateDoc;
+    } else if (!keep_tombstones && input.lengths[i] == 0) {
+      dropped_names->insert(name);
+      new_doc_id = kDuplicateDoc;
+    } else {
+      new_doc_id = DocTable_Add(dt, doc_name);
+      Verify333(new_doc_id == lengths->size() + 1);
+      lengths->push_back(input.lengths[i]);
+    }
+    Verify333(doc_map->Set(input.docs[i].first, new_doc_id));
+  }
+}
+
+void DocMap::Reset(const vector<pair<DocID_t, string>>& docs) {
+  doc_ids_.clear();
+  sparse_doc_ids_.clear();
+  first_doc_id_ = docs.empty() ? 0 : docs.front().first;
+  DocID_t range = docs.empty() ? 0 : docs.back().first - first_doc_id_ + 1;
+  sparse_ = range / 4 > docs.size() + 1024;
+  if (sparse_) {
+    sparse_doc_ids_.reserve(docs.size());
+  } else {
+    doc_ids_.assign(range, INVALID_DOCID);
+  }
+}
+
+DocID_t DocMap::Get(DocID_t doc_id) const {
+  if (sparse_) {
+    auto it = sparse_doc_ids_.find(doc_id);
+    return (it == sparse_doc_ids_.end()) ? INVALID_DOCID : it->second;
+  }
+  if (doc_id < first_doc_id_ || doc_id - first_doc_id_ >= doc_ids_.size()) {
+    return INVALID_DOCID;
+  }
+  return doc_ids_[doc_id - first_doc_id_];
+}
+
+bool DocMap::Set(DocID_t doc_id, DocID_t new_doc_id) {
+  if (sparse_) {
+    return sparse_doc_ids_.emplace(doc_id, new_doc_id).second;
+  }
+  DocID_t& entry = doc_ids_[doc_id - first_doc_id_];
+  if (entry != INVALID_DOCID) {
+    return false;
+  }
+  entry = new_doc_id;
+  return true;
+}
+
+bool IndexPostingsStream::Next() {
+  while (true) {
+    if (next_term_ == terms_.size()) {
+      if (!more_terms_) {
+        return false;
+      }
+
+      // Read the next page of words from the dictionary.  Without one,
+      // the view reads the whole word table, so we may as well take all
+      // of it at once.
+      string first;
+      if (!terms_.empty()) {
+        // The smallest string that sorts after the last word.
+        first = terms_.back().first + '\0';
+      }
+      size_t max_terms = dict_.has_dictionary()
+          ? kTermsPerPage : std::numeric_limits<size_t>::max();
+      more_terms_ = !dict_.GetRange(first, "", max_terms, &terms_);
+      next_term_ = 0;
+      if (terms_.empty()) {
+        return false;
+      }
+    }
+
+    const TermDictView::Term& term = terms_[next_term_++];
+    word_ = term.first;
+    if (!ReadPostings(term.second)) {
+      failed_ = true;
+      return false;
+    }
+    if (!docs_.empty()) {
+      return true;
+    }
+  }
+}
+
+bool IndexPostingsStream::GetDocs(vector<PostingsDoc>* docs) const {
+  for (size_t i = 0; i < docs_.size(); i++) {
+    docs->push_back(docs_[i]);
+    if (with_positions_) {
+      docs->back().positions = positions_.data() + positions_offsets_[i];
+    }
+  }
+  return true;
+}
+
+bool IndexPostingsStream::ReadPostings(IndexFileOffset_t element_pos) {
+  docs_.clear();
+  positions_.clear();
+  positions_offsets_.clear();
+  unique_ptr<PostingsView> postings(table_.LookupElement(element_pos));
+  if (postings == nullptr) {
+    return false;
+  }
+
+  // Keep the documents that survive renumbering.
+  vector<DocIDElementHeader> headers;
+  vector<DocID_t> doc_ids;
+  postings->GetSortedDocIDs(&headers);
+  if (static_cast<int>(headers.size()) != postings->num_docs()) {
+    return false;
+  }
+  for (const DocIDElementHeader& header : headers) {
+    DocID_t doc_id = doc_map_->Get(header.doc_id);
+    if (doc_id == INVALID_DOCID) {
+      return false;
+    }
+    if (doc_id == kDuplicateDoc) {
+      continue;
+    }
+    docs_.push_back({doc_id, header.num_positions, nullptr, 0});
+    doc_ids.push_back(header.doc_id);
+  }
+  if (!with_positions_ || docs_.empty()) {
+    return true;
+  }
+
+  // Re-encode their positions as a v2 position stream.
+  vector<vector<DocPositionOffset_t>> positions;
+  if (!postings->GetSortedPositions(doc_ids, &positions)) {
+    return false;
+  }
+  for (size_t i = 0; i < docs_.size(); i++) {
+    size_t start = positions_.size();
+    DocPositionOffset_t prev = 0;
+    for (DocPositionOffset_t position : positions[i]) {
+      AppendVarint(position - prev, &positions_);
+      prev = position;
+    }
+    docs_[i].num_positions = positions[i].size();
+    docs_[i].positions_bytes = positions_.size() - start;
+    positions_offsets_.push_back(start);
+  }
+  return true;
+}
+
+}  // namespace hw3
@@ -0,0 +1,55 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_INDEXMERGER_H_
+#define HW3_INDEXMERGER_H_
+
+#include <string>  // for std::string.
+#include <vector>  // for std::vector.
+
+namespace hw3 {
+
+// Merges the index files "index_files" (of either format) into a single
+// v2 index file, "file_name", so that a QueryProcessor can search one
+// file instead of many.
+//
+// The documents are renumbered: the first file's documents get docIDs
+// 1, 2, ..., in the order of their old docIDs, the second file's
+// documents follow on from there, and so on.  A document whose name is
+// in more than one of the files is kept only from the first file that
+// has it, along with its postings from that file; list newer files
+// first to keep the newest copy of each document.
+//
+// A document with no postings is a tombstone (see IncrementalIndex.h),
+// which only exists to hide other copies of the document.  Unless
+// "keep_tombstones" is true, tombstones are dropped, along with the
+// copies they hide in later files, so they don't count towards the
+// merged file's document statistics.  Keep them when the result will
+// itself be searched ahead of other files that they need to hide copies
+// in, as an incremental index's delta is.
+//
+// The files are streamed rather than loaded into a MemIndex: the merge
+// reads each file's words in sorted order (through its term dictionary,
+// if it has one) and combines their postings with WriteMergedIndex().
+// Only the merged DocTable, the files' document names and lengths, and a
+// few dozen bytes per distinct word are held in memory.  The lengths come
+// from each file's doc stats section, or are counted from its postings
+// if it doesn't have one.
+//
+// Crashes (via Verify333) if one of the files is malformed, just as
+// QueryProcessor does.  Returns the number of bytes written, or a
+// negative value on failure (in which case "file_name" is removed).
+int MergeIndexFiles(const std::vector<std::string>& index_files,
+                    const char* file_name, bool keep_tombstones = false);
+
+}  // namespace hw3
+
+#endif  // HW3_INDEXMERGER_H_
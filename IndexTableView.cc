@@ -0,0 +1,123 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./IndexTableView.h"
+
+#include <memory>    // for std::shared_ptr.
+#include <string>    // for std::string.
+#include <utility>   // for std::pair.
+#include <vector>    // for std::vector.
+
+#include "./DocIDTableView.h"
+#include "./LayoutStructs.h"
+#include "./PackedPostingsView.h"
+
+extern "C" {
+  #include "libhw1/HashTable.h"  // for FNVHash64().
+}
+
+using std::pair;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+IndexTableView::IndexTableView(shared_ptr<const IndexFileSource> file)
+  : HashTableView(file, file->word_table_offset()) { }
+
+PostingsView* IndexTableView::LookupWord(const string& word) const {
+  // Calculate the FNVHash64 of the word, and find its bucket.
+  HTKey_t word_hash =
+      FNVHash64(reinterpret_cast<unsigned char*>(
+                    const_cast<char*>(word.c_str())),
+                word.length());
+  BucketRecord bucket;
+  if (!LookupBucket(word_hash, &bucket)) {
+    return nullptr;
+  }
+
+  // Walk the bucket's chain, looking for our word.
+  for (int i = 0; i < bucket.chain_num_elements; i++) {
+    IndexFileOffset_t element_pos;
+    WordPostingsHeader header;
+    if (!LookupElementPosition(bucket, i, &element_pos)
+        || !file_->ReadRecord(element_pos, &header)) {
+      return nullptr;
+    }
+
+    // Skip elements whose word length doesn't match.
+    if (header.word_bytes != static_cast<signed>(word.length())) {
+      continue;
+    }
+
+    // Read the word itself, and see if it matches.
+    IndexFileOffset_t word_pos = element_pos + sizeof(WordPostingsHeader);
+    string candidate;
+    if (!file_->ReadString(word_pos, header.word_bytes, &candidate)) {
+      return nullptr;
+    }
+    if (word.compare(candidate) == 0) {
+      return NewPostingsView(element_pos, header);
+    }
+  }
+  return nullptr;
+}
+
+PostingsView* IndexTableView::LookupElement(
+    IndexFileOffset_t element_pos) const {
+  WordPostingsHeader header;
+  if (!file_->ReadRecord(element_pos, &header)) {
+    return nullptr;
+  }
+  return NewPostingsView(element_pos, header);
+}
+
+vector<pair<string, IndexFileOffset_t>> IndexTableView::GetWordList() const {
+  vector<pair<string, IndexFileOffset_t>> word_list;
+
+  // Go through *all* of the buckets of this hashtable, extracting
+  // out each element's word.
+  for (int i = 0; i < header_.num_buckets; i++) {
+    BucketRecord bucket;
+    if (!file_->ReadRecord(offset_ + sizeof(BucketListHeader)
+                           + sizeof(BucketRecord) * i, &bucket)) {
+      return word_list;
+    }
+
+    for (int j = 0; j < bucket.chain_num_elements; j++) {
+      IndexFileOffset_t element_pos;
+      WordPostingsHeader header;
+      string word;
+      if (!LookupElementPosition(bucket, j, &element_pos)
+          || !file_->ReadRecord(element_pos, &header)
+          || !file_->ReadString(element_pos + sizeof(WordPostingsHeader),
+                                header.word_bytes, &word)) {
+        return word_list;
+      }
+      word_list.emplace_back(word, element_pos);
+    }
+  }
+  return word_list;
+}
+
+PostingsView* IndexTableView::NewPostingsView(
+    IndexFileOffset_t element_pos, const WordPostingsHeader& header) const {
+  // The word's postings follow the word itself.
+  IndexFileOffset_t postings_pos =
+      element_pos + sizeof(WordPostingsHeader) + header.word_bytes;
+  if (file_->format_version() == 1) {
+    return new DocIDTableView(file_, postings_pos);
+  }
+  return new PackedPostingsView(file_, postings_pos, header.postings_bytes);
+}
+
+}  // namespace hw3
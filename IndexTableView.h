@@ -0,0 +1,72 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_INDEXTABLEVIEW_H_
+#define HW3_INDEXTABLEVIEW_H_
+
+#include <memory>   // for std::shared_ptr.
+#include <string>   // for std::string.
+#include <utility>  // for std::pair.
+#include <vector>   // for std::vector.
+
+#include "./HashTableView.h"
+#include "./IndexFileSource.h"
+#include "./LayoutStructs.h"
+#include "./PostingsView.h"
+
+namespace hw3 {
+
+// An IndexTableView is the shareable counterpart of IndexTableReader:
+// it looks up words within the word->postings table of an
+// IndexFileSource.  It reads both v1 and v2 index files.
+class IndexTableView : public HashTableView {
+ public:
+  // Construct a view of the word->postings table of "file".
+  explicit IndexTableView(std::shared_ptr<const IndexFileSource> file);
+
+  // Lookup a word and get back a PostingsView containing the
+  // docid->positions mapping associated with that word.
+  //
+  // Arguments:
+  // - word: the word to look up.
+  //
+  // Returns:
+  // - a heap-allocated PostingsView for the word (a DocIDTableView for
+  //   a v1 file, or a PackedPostingsView for a v2 file), or nullptr if
+  //   the word isn't in the index.  The caller takes ownership and must
+  //   delete it.  It shares this view's IndexFileSource, so no file
+  //   handle is duplicated.
+  PostingsView* LookupWord(const std::string& word) const;
+
+  // Like LookupWord(), but for the word whose element is at file offset
+  // "element_pos" of the table, as recorded by the term dictionary (see
+  // TermDictView.h) or GetWordList().  Returns nullptr if the element
+  // can't be read.
+  PostingsView* LookupElement(IndexFileOffset_t element_pos) const;
+
+  // Returns every word in the table, in no particular order, each paired
+  // with the file offset of its element.  This reads the whole table, so
+  // it's only for index files without a term dictionary.
+  std::vector<std::pair<std::string, IndexFileOffset_t>>
+      GetWordList() const;
+
+ private:
+  // Returns a new PostingsView of the postings of the element at
+  // "element_pos", whose header is "header".
+  PostingsView* NewPostingsView(IndexFileOffset_t element_pos,
+                                const WordPostingsHeader& header) const;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexTableView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_INDEXTABLEVIEW_H_
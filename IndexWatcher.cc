@@ -0,0 +1,322 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./IndexWatcher.h"
+
+#include <dirent.h>       // for opendir(), readdir(), closedir().
+#include <errno.h>        // for errno, EINTR.
+#include <poll.h>         // for poll().
+#include <pthread.h>      // for pthread_create(), etc.
+#include <stdint.h>       // for int64_t.
+#include <string.h>       // for strcmp().
+#include <sys/inotify.h>  // for inotify_init1(), inotify_add_watch(), etc.
+#include <sys/stat.h>     // for stat().
+#include <time.h>         // for clock_gettime().
+#include <unistd.h>       // for read(), close().
+#include <algorithm>      // for std::min().
+#include <string>         // for std::string.
+#include <unordered_map>  // for std::unordered_map.
+#include <unordered_set>  // for std::unordered_set.
+#include <vector>         // for std::vector.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+#include "./IncrementalIndex.h"
+
+using std::min;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+namespace hw3 {
+
+// The events that can mean a file needs to be indexed again, or has gone.
+// Modifications are only noticed once the file's closed, so that a file
+// being written isn't indexed half done.
+static constexpr uint32_t kWatchEvents =
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+    | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF;
+
+// How many batch segments may pile up before they're compacted into the
+// delta.
+static constexpr int kCompactBatches = 8;
+
+// The watched directories, by watch descriptor.
+typedef unordered_map<int, string> WatchMap;
+
+// A compaction (see IncrementalIndex::Compact()) running on a thread of
+// its own, so that batches of changes keep being published meanwhile.
+struct Compaction {
+  IncrementalIndex* index;
+  pthread_t thread;
+  bool running;           // whether "thread" needs joining
+  pthread_mutex_t lock;   // guards "done"
+  bool done;              // whether "thread" has finished
+  int result;             // what Compact() returned, once it's done
+};
+
+// Watches "dir_path", and every directory beneath it, with the inotify
+// instance "fd", adding them to "dirs".  Directories that are already
+// watched are watched again, so that any new directories beneath them
+// are found.  "visited" holds the watches this walk has already reached,
+// which keeps it out of symlink loops.  Returns false if we've run out of
+// watches.
+static bool WatchTree(int fd, const string& dir_path, WatchMap* dirs,
+                      unordered_set<int>* visited);
+
+// Reads a buffer's worth of events from "fd", which must be readable,
+// adding the paths they're about to "paths", watching any directories
+// that have been created, and forgetting those that have gone.  Sets
+// "overflow" if events were lost, in which case the whole tree needs
+// watching and walking again.  Returns false on error.
+static bool ReadEvents(int fd, WatchMap* dirs, unordered_set<string>* paths,
+                       bool* overflow);
+
+// Starts compacting the index in "compaction" on a thread of its own,
+// unless it's already doing so.  If an earlier compaction has finished,
+// sets "result" to what it returned; otherwise sets it to 0.
+static void StartCompaction(Compaction* compaction, int* result);
+
+// Waits for any compaction to finish, returning what it returned (or 0,
+// if none was running).
+static int FinishCompaction(Compaction* compaction);
+
+// The body of a compaction's thread.
+static void* CompactionMain(void* arg);
+
+// Waits up to "timeout_ms" milliseconds (or forever, if it's negative)
+// for "fd" to become readable.  Returns 1 if it did, 0 if it timed out,
+// or -1 on error.
+static int WaitForEvents(int fd, int timeout_ms);
+
+// Returns the time, in milliseconds, on a clock that never jumps.
+static int64_t NowMs();
+
+int WatchIndex(char* root_dir, int num_workers, size_t memory_budget,
+               int settle_ms, const char* file_name) {
+  int fd = inotify_init1(IN_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+
+  // Start watching before the first update, so that nothing that changes
+  // during it is missed.
+  IncrementalIndex index(root_dir, num_workers, memory_budget, file_name);
+  WatchMap dirs;
+  unordered_set<int> visited;
+  if (!WatchTree(fd, root_dir, &dirs, &visited) || index.Update(false) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  Compaction compaction;
+  compaction.index = &index;
+  compaction.running = false;
+  Verify333(pthread_mutex_init(&compaction.lock, nullptr) == 0);
+  int result = 0;
+  while (result >= 0) {
+    // Wait for a burst of changes to start, and then to die down.
+    unordered_set<string> paths;
+    bool overflow = false;
+    if (WaitForEvents(fd, -1) < 0
+        || !ReadEvents(fd, &dirs, &paths, &overflow)) {
+      break;
+    }
+    const int64_t deadline = NowMs() + 10 * static_cast<int64_t>(settle_ms);
+    int ready = 1;
+    while (ready > 0) {
+      int64_t remaining = deadline - NowMs();
+      if (remaining <= 0) {
+        break;
+      }
+      ready = WaitForEvents(fd, min<int64_t>(settle_ms, remaining));
+      if (ready > 0 && !ReadEvents(fd, &dirs, &paths, &overflow)) {
+        ready = -1;
+      }
+    }
+    if (ready < 0) {
+      break;
+    }
+
+    if (overflow) {
+      // We've lost track of what changed, so fall back on watching and
+      // walking the whole tree.  That rewrites the delta, which mustn't
+      // happen under a compaction.
+      visited.clear();
+      if (!WatchTree(fd, root_dir, &dirs, &visited)
+          || FinishCompaction(&compaction) < 0) {
+        break;
+      }
+      result = index.Update(false);
+    } else {
+      // Only the paths the events were about need looking at.
+      result = index.UpdatePaths(vector<string>(paths.begin(), paths.end()));
+    }
+    if (result >= 0 && index.num_batches() >= kCompactBatches) {
+      StartCompaction(&compaction, &result);
+    }
+  }
+  FinishCompaction(&compaction);
+  pthread_mutex_destroy(&compaction.lock);
+  close(fd);
+  return -1;
+}
+
+static bool WatchTree(int fd, const string& dir_path, WatchMap* dirs,
+                      unordered_set<int>* visited) {
+  int wd = inotify_add_watch(fd, dir_path.c_str(), kWatchEvents | IN_ONLYDIR);
+  if (wd < 0) {
+    // The directory may have gone again already, which is fine.
+    return errno != ENOSPC;
+  }
+  if (!visited->insert(wd).second) {
+    return true;
+  }
+  (*dirs)[wd] = dir_path;
+
+  DIR* d = opendir(dir_path.c_str());
+  if (d == nullptr) {
+    return true;
+  }
+  bool ok = true;
+  struct dirent* dirent;
+  while (ok && (dirent = readdir(d)) != nullptr) {
+    if (strcmp(dirent->d_name, ".") == 0
+        || strcmp(dirent->d_name, "..") == 0) {
+      continue;
+    }
+
+    // Follow symlinks to directories, as the crawl does.
+    string path = dir_path;
+    if (path.back() != '/') {
+      path += '/';
+    }
+    path += dirent->d_name;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      ok = WatchTree(fd, path, dirs, visited);
+    }
+  }
+  closedir(d);
+  return ok;
+}
+
+static bool ReadEvents(int fd, WatchMap* dirs, unordered_set<string>* paths,
+                       bool* overflow) {
+  alignas(struct inotify_event) char buf[16384];
+  ssize_t len;
+  do {
+    len = read(fd, buf, sizeof(buf));
+  } while (len < 0 && errno == EINTR);
+  if (len <= 0) {
+    return false;
+  }
+
+  const char* next = buf;
+  while (next < buf + len) {
+    const struct inotify_event* event =
+        reinterpret_cast<const struct inotify_event*>(next);
+    next += sizeof(struct inotify_event) + event->len;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      *overflow = true;
+      continue;
+    }
+    auto dir = dirs->find(event->wd);
+    if (dir == dirs->end()) {
+      continue;
+    }
+    string path = dir->second;
+    if (event->len > 0) {
+      if (path.back() != '/') {
+        path += '/';
+      }
+      path += event->name;
+    }
+    if (event->mask & IN_IGNORED) {
+      dirs->erase(dir);
+      continue;
+    }
+    paths->insert(path);
+
+    if ((event->mask & IN_ISDIR)
+        && (event->mask & (IN_CREATE | IN_MOVED_TO)) && event->len > 0) {
+      // Watch a new directory straight away, so that changes to what's
+      // put in it aren't missed.  Anything put there before the watch
+      // existed is found when its path is crawled.
+      unordered_set<int> visited;
+      if (!WatchTree(fd, path, dirs, &visited)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static int WaitForEvents(int fd, int timeout_ms) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  int result;
+  do {
+    result = poll(&pfd, 1, timeout_ms);
+  } while (result < 0 && errno == EINTR);
+  return result;
+}
+
+static void StartCompaction(Compaction* compaction, int* result) {
+  *result = 0;
+  if (compaction->running) {
+    Verify333(pthread_mutex_lock(&compaction->lock) == 0);
+    bool done = compaction->done;
+    Verify333(pthread_mutex_unlock(&compaction->lock) == 0);
+    if (!done) {
+      return;
+    }
+    *result = FinishCompaction(compaction);
+    if (*result < 0) {
+      return;
+    }
+  }
+  compaction->done = false;
+  compaction->running = true;
+  Verify333(pthread_create(&compaction->thread, nullptr, &CompactionMain,
+                           compaction) == 0);
+}
+
+static int FinishCompaction(Compaction* compaction) {
+  if (!compaction->running) {
+    return 0;
+  }
+  Verify333(pthread_join(compaction->thread, nullptr) == 0);
+  compaction->running = false;
+  return compaction->result;
+}
+
+static void* CompactionMain(void* arg) {
+  Compaction* compaction = static_cast<Compaction*>(arg);
+  int result = compaction->index->Compact();
+  Verify333(pthread_mutex_lock(&compaction->lock) == 0);
+  compaction->result = result;
+  compaction->done = true;
+  Verify333(pthread_mutex_unlock(&compaction->lock) == 0);
+  return nullptr;
+}
+
+static int64_t NowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * INT64_C(1000) + ts.tv_nsec / 1000000;
+}
+
+}  // namespace hw3
@@ -0,0 +1,42 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_INDEXWATCHER_H_
+#define HW3_INDEXWATCHER_H_
+
+#include <stddef.h>  // for size_t.
+
+namespace hw3 {
+
+// Keeps the index "file_name" of "root_dir" up to date for as long as it
+// runs, using inotify to learn when files under "root_dir" change.
+//
+// It first brings the index up to date with IncrementalIndex::Update(),
+// and then waits for changes.  Changes tend to come in bursts (a file
+// being written, or a directory being unpacked), so once one arrives it
+// waits until there have been none for "settle_ms" milliseconds, or
+// until 10 * settle_ms have passed.  Then it hands the paths the events
+// named to IncrementalIndex::UpdatePaths(), which publishes the changes
+// as a new batch segment; only if events were lost does it walk the
+// whole tree with Update() instead.  Once enough batch segments have
+// piled up, they're compacted into the delta on a thread of its own.  A
+// running ReloadingQueryProcessor picks up each new segment without
+// restarting.  "num_workers" and "memory_budget" are as for
+// UpdateIndex().
+//
+// The index files shouldn't live under "root_dir", or each update would
+// set off another.  Only returns on failure, returning a negative value.
+int WatchIndex(char* root_dir, int num_workers, size_t memory_budget,
+               int settle_ms, const char* file_name);
+
+}  // namespace hw3
+
+#endif  // HW3_INDEXWATCHER_H_
@@ -0,0 +1,354 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_LAYOUTSTRUCTSV2_H_
+#define HW3_LAYOUTSTRUCTSV2_H_
+
+#include <arpa/inet.h>  // for htonl(), ntohl().
+#include <stdint.h>     // for uint32_t, etc.
+#include <cmath>        // for std::nextafter(), HUGE_VALF.
+#include <cstddef>      // for ptrdiff_t.
+#include <cstring>      // for memcpy().
+#include <vector>       // for std::vector.
+
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+///////////////////////////////////////////////////////////////////////////////
+// Version 2 of the index file format.
+//
+// A v2 index file starts with the same IndexFileHeader as a v1 file, but
+// with kMagicNumberV2 in place of kMagicNumber.  The checksum, and the
+// doctable_bytes and index_bytes fields, mean exactly what they do in v1,
+// and the doctable region is laid out exactly as in v1.
+//
+// The index region, however, is a sequence of "sections", followed by a
+// directory of them:
+//
+//   [section] [section] ... [SectionRecord] ... [SectionDirectoryFooter]
+//
+// The directory sits at the end of the region, so the writer can stream
+// each section out before it knows how big it will be.  A reader finds it
+// by reading the footer from the last bytes of the index region.
+// Sections a reader doesn't recognize can simply be ignored.
+//
+// The word table section (kWordTableSection) is a hash table keyed on
+// FNVHash64(word), laid out exactly like the v1 word->postings table
+// (BucketListHeader, BucketRecords, ElementPositionRecords), but each
+// element is:
+//
+//   [WordPostingsHeader] [word bytes] [postings]
+//
+// where WordPostingsHeader::postings_bytes is the length of "postings".
+// Instead of a nested docID hash table, "postings" is a compact,
+// docID-sorted encoding of the word's posting list, which starts with a
+// one-byte encoding tag:
+//
+//   kPostingsDeltaVarint:
+//     uint8_t  encoding      (kPostingsDeltaVarint)
+//     varint   num_docs
+//     varint   docs_bytes    (the length of the doc stream)
+//     doc stream:      for each doc, in increasing docID order:
+//                        varint  docID - previous docID (or docID itself)
+//                        varint  num_positions
+//     position stream: for each doc, in the same order, num_positions
+//                      varints: each position minus the previous one in
+//                      that doc (the first is relative to 0).
+//
+// Keeping the positions out of the doc stream means that walking the
+// docIDs (which is all most queries need) never touches them.
+//
+//   kPostingsScoredDeltaVarint:
+//     uint8_t  encoding      (kPostingsScoredDeltaVarint)
+//     uint32_t max_tf_score  (the bits of an IEEE float)
+//     ...followed by everything after the encoding byte of a
+//     kPostingsDeltaVarint posting list.
+//
+//     max_tf_score is at least as large as BM25TermFrequencyScore() (see
+//     BM25.h) of every document in the list, computed with the doc stats
+//     section's average document length.  Queries use it to skip
+//     documents that can't make the top results.
+//
+//   kPostingsBlockMax:
+//     uint8_t  encoding         (kPostingsBlockMax)
+//     uint32_t max_tf_score     (as for kPostingsScoredDeltaVarint)
+//     varint   num_docs
+//     varint   num_blocks
+//     varint   directory_bytes  (the length of the block directory)
+//     block directory: for each block of kPostingsBlockSize consecutive
+//                      docs (the last block may have fewer), in order:
+//                        varint   its last docID minus the previous
+//                                 block's (or the docID itself)
+//                        varint   its share of the doc stream, in bytes
+//                        varint   its share of the position stream, in
+//                                 bytes
+//                        uint32_t its own max_tf_score
+//     varint   docs_bytes
+//     doc stream, position stream: exactly as for kPostingsDeltaVarint.
+//
+//     The directory lets a reader jump straight to the block holding a
+//     docID, decoding nothing before it, and skip blocks whose
+//     max_tf_score is too low for any of their documents to make the top
+//     results.  Posting lists of a single block don't need one, and are
+//     written as kPostingsScoredDeltaVarint.
+//
+// The doc stats section (kDocStatsSection) holds what BM25 scoring needs
+// to know about the documents:
+//
+//   [DocStatsHeader] [DocLengthRecord] ...
+//
+// with one DocLengthRecord for each docID from first_doc_id to
+// first_doc_id + num_lengths - 1, in order.  A document's length is the
+// number of words in it.
+//
+// The term dictionary section (kTermDictSection) lists every word in the
+// word table in sorted (byte) order, so that all of the words with a
+// given prefix, or within a given range, can be found without hashing
+// each candidate:
+//
+//   [TermDictHeader] [term blocks] [block index]
+//
+// The words are split into blocks of kTermDictBlockSize consecutive
+// words (the last block may have fewer), and each block is front coded:
+// for each of its words, in order,
+//
+//   varint  the length of the prefix it shares with the word before it
+//           (0 for a block's first word, which is written in full)
+//   varint  the length of the rest of the word
+//   bytes   the rest of the word
+//   varint  the file offset of the word's element in the word table
+//
+// The block index has one entry per block, in order:
+//
+//   varint  the block's offset from the start of the term blocks
+//   varint  the length of the block's first word
+//   bytes   the block's first word
+//
+// It's small enough for a reader to hold in memory, and binary search,
+// to find the only block a word could be in.
+//
+// All fixed-width fields are in network byte order.  Varints are unsigned
+// LEB128: seven bits per byte, least significant group first, with the
+// high bit set on every byte but the last.
+///////////////////////////////////////////////////////////////////////////////
+
+static constexpr uint32_t kMagicNumberV2 = 0xCAFEF00E;
+
+// Section IDs.
+static constexpr int32_t kWordTableSection = 1;
+static constexpr int32_t kDocStatsSection = 2;
+static constexpr int32_t kTermDictSection = 3;
+
+// Postings encodings.
+static constexpr uint8_t kPostingsDeltaVarint = 1;
+static constexpr uint8_t kPostingsScoredDeltaVarint = 2;
+static constexpr uint8_t kPostingsBlockMax = 3;
+
+// The number of docs in each block of a kPostingsBlockMax posting list.
+static constexpr int kPostingsBlockSize = 128;
+
+// The number of words in each block of the term dictionary section.
+static constexpr int kTermDictBlockSize = 16;
+
+// The longest a varint encoding of a 64-bit value can be.
+static constexpr int kMaxVarintBytes = 10;
+
+// One entry in the index region's section directory.
+struct SectionRecord {
+  int32_t           section_id;  // which section this is
+  IndexFileOffset_t position;    // byte offset of the section in the file
+  int32_t           bytes;       // length of the section
+
+  SectionRecord() = default;
+  SectionRecord(int32_t section_id_arg, IndexFileOffset_t position_arg,
+                int32_t bytes_arg)
+    : section_id(section_id_arg), position(position_arg), bytes(bytes_arg) { }
+
+  void ToDiskFormat() {
+    section_id = htonl(section_id);
+    position = htonl(position);
+    bytes = htonl(bytes);
+  }
+  void ToHostFormat() {
+    section_id = ntohl(section_id);
+    position = ntohl(position);
+    bytes = ntohl(bytes);
+  }
+} __attribute__((packed));
+
+// The last bytes of a v2 index region: the number of SectionRecords that
+// immediately precede it.
+struct SectionDirectoryFooter {
+  int32_t num_sections;
+
+  SectionDirectoryFooter() = default;
+  explicit SectionDirectoryFooter(int32_t num_sections_arg)
+    : num_sections(num_sections_arg) { }
+
+  void ToDiskFormat() { num_sections = htonl(num_sections); }
+  void ToHostFormat() { num_sections = ntohl(num_sections); }
+} __attribute__((packed));
+
+// The start of the doc stats section.
+struct DocStatsHeader {
+  int32_t num_docs;      // the number of documents in the index
+  int64_t total_words;   // the sum of all of their lengths
+  DocID_t first_doc_id;  // the docID of the first DocLengthRecord
+  int32_t num_lengths;   // the number of DocLengthRecords
+
+  DocStatsHeader() = default;
+  DocStatsHeader(int32_t num_docs_arg, int64_t total_words_arg,
+                 DocID_t first_doc_id_arg, int32_t num_lengths_arg)
+    : num_docs(num_docs_arg), total_words(total_words_arg),
+      first_doc_id(first_doc_id_arg), num_lengths(num_lengths_arg) { }
+
+  void ToDiskFormat() {
+    num_docs = htonl(num_docs);
+    total_words = htonll(total_words);
+    first_doc_id = htonll(first_doc_id);
+    num_lengths = htonl(num_lengths);
+  }
+  void ToHostFormat() {
+    num_docs = ntohl(num_docs);
+    total_words = ntohll(total_words);
+    first_doc_id = ntohll(first_doc_id);
+    num_lengths = ntohl(num_lengths);
+  }
+} __attribute__((packed));
+
+// The length of one document, in the doc stats section.
+struct DocLengthRecord {
+  uint32_t length;
+
+  DocLengthRecord() = default;
+  explicit DocLengthRecord(uint32_t length_arg) : length(length_arg) { }
+
+  void ToDiskFormat() { length = htonl(length); }
+  void ToHostFormat() { length = ntohl(length); }
+} __attribute__((packed));
+
+// The start of the term dictionary section.
+struct TermDictHeader {
+  int32_t num_terms;     // the number of words in the dictionary
+  int32_t num_blocks;    // the number of blocks (and block index entries)
+  int32_t blocks_bytes;  // the length of the term blocks
+
+  TermDictHeader() = default;
+  TermDictHeader(int32_t num_terms_arg, int32_t num_blocks_arg,
+                 int32_t blocks_bytes_arg)
+    : num_terms(num_terms_arg), num_blocks(num_blocks_arg),
+      blocks_bytes(blocks_bytes_arg) { }
+
+  void ToDiskFormat() {
+    num_terms = htonl(num_terms);
+    num_blocks = htonl(num_blocks);
+    blocks_bytes = htonl(blocks_bytes);
+  }
+  void ToHostFormat() {
+    num_terms = ntohl(num_terms);
+    num_blocks = ntohl(num_blocks);
+    blocks_bytes = ntohl(blocks_bytes);
+  }
+} __attribute__((packed));
+
+// Returns the number of bytes AppendVarint() uses to encode "value".
+inline int VarintLength(uint64_t value) {
+  int len = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    len++;
+  }
+  return len;
+}
+
+// Appends the varint encoding of "value" to "out".
+inline void AppendVarint(uint64_t value, std::vector<uint8_t>* const out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+// Decodes the varint at "*cursor" into "value", and advances "*cursor"
+// past it.  Returns false, leaving "*cursor" alone, if the varint runs
+// past "end" or is longer than any 64-bit value's encoding.
+inline bool ReadVarint(const uint8_t** const cursor, const uint8_t* end,
+                       uint64_t* const value) {
+  const uint8_t* p = *cursor;
+  uint64_t result = 0;
+  for (int shift = 0; shift < 7 * kMaxVarintBytes && p < end; shift += 7) {
+    uint8_t byte = *p++;
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *cursor = p;
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Appends a max_tf_score field holding "score", rounded up to the next
+// float so that it stays an upper bound, to "out".
+inline void AppendMaxScore(double score, std::vector<uint8_t>* const out) {
+  float value = static_cast<float>(score);
+  if (value < score) {
+    value = std::nextafter(value, HUGE_VALF);
+  }
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  bits = htonl(bits);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&bits);
+  out->insert(out->end(), bytes, bytes + sizeof(bits));
+}
+
+// Decodes the max_tf_score field at "*cursor" into "score", and advances
+// "*cursor" past it.  Returns false, leaving "*cursor" alone, if the
+// field runs past "end".
+inline bool ReadMaxScore(const uint8_t** const cursor, const uint8_t* end,
+                         double* const score) {
+  uint32_t bits;
+  float value;
+  if (end - *cursor < static_cast<ptrdiff_t>(sizeof(bits))) {
+    return false;
+  }
+  memcpy(&bits, *cursor, sizeof(bits));
+  bits = ntohl(bits);
+  memcpy(&value, &bits, sizeof(value));
+  *cursor += sizeof(bits);
+  *score = value;
+  return true;
+}
+
+// Advances "*cursor" past "count" varints.  Returns false if they run past
+// "end".
+inline bool SkipVarints(const uint8_t** const cursor, const uint8_t* end,
+                        uint64_t count) {
+  const uint8_t* p = *cursor;
+  while (count > 0) {
+    if (p >= end) {
+      return false;
+    }
+    // Every varint ends with the first byte whose high bit is clear.
+    if ((*p++ & 0x80) == 0) {
+      count--;
+    }
+  }
+  *cursor = p;
+  return true;
+}
+
+}  // namespace hw3
+
+#endif  // HW3_LAYOUTSTRUCTSV2_H_
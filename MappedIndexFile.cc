@@ -0,0 +1,89 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./MappedIndexFile.h"
+
+#include <fcntl.h>      // for open().
+#include <sys/mman.h>   // for mmap(), munmap().
+#include <sys/types.h>  // for fstat().
+#include <sys/stat.h>   // for fstat().
+#include <unistd.h>     // for close().
+
+#include <cstring>      // for memcpy().
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::string;
+
+namespace hw3 {
+
+MappedIndexFile::MappedIndexFile(const string& file_name, bool validate)
+  : IndexFileSource(file_name) {
+  // Open the file and figure out how big it is.  Crash on error.
+  int fd = open(file_name_.c_str(), O_RDONLY);
+  Verify333(fd != -1);
+
+  struct stat f_stat;
+  Verify333(fstat(fd, &f_stat) == 0);
+  Verify333(f_stat.st_size >= static_cast<off_t>(sizeof(IndexFileHeader)));
+  length_ = f_stat.st_size;
+
+  // Map the whole file.  The mapping stays valid after we close the
+  // descriptor, so there's no need to hang on to it.
+  void* addr = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  Verify333(addr != MAP_FAILED);
+  data_ = static_cast<const uint8_t*>(addr);
+
+  // Check the header, and possibly the checksum, straight out of the
+  // mapping.
+  ReadAndValidateHeader(length_, validate);
+}
+
+MappedIndexFile::~MappedIndexFile() {
+  Verify333(munmap(const_cast<uint8_t*>(data_), length_) == 0);
+  data_ = nullptr;
+}
+
+const uint8_t* MappedIndexFile::BytesAt(IndexFileOffset_t offset,
+                                        size_t len) const {
+  if (offset < 0 || static_cast<size_t>(offset) > length_
+      || len > length_ - offset) {
+    return nullptr;
+  }
+  return data_ + offset;
+}
+
+bool MappedIndexFile::ReadBytes(IndexFileOffset_t offset, void* buf,
+                                size_t len) const {
+  const uint8_t* src = BytesAt(offset, len);
+  if (src == nullptr) {
+    return false;
+  }
+  // The mapping is only byte-aligned for the (packed) on-disk
+  // structures, so copy rather than handing out a cast pointer.
+  memcpy(buf, src, len);
+  return true;
+}
+
+bool MappedIndexFile::ReadString(IndexFileOffset_t offset, size_t len,
+                                 string* const ret_str) const {
+  const uint8_t* src = BytesAt(offset, len);
+  if (src == nullptr) {
+    return false;
+  }
+  ret_str->assign(reinterpret_cast<const char*>(src), len);
+  return true;
+}
+
+}  // namespace hw3
@@ -0,0 +1,66 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_MAPPEDINDEXFILE_H_
+#define HW3_MAPPEDINDEXFILE_H_
+
+#include <stdint.h>  // for uint8_t, etc.
+#include <cstddef>   // for size_t.
+#include <string>    // for std::string.
+
+#include "./IndexFileSource.h"
+#include "./LayoutStructs.h"
+#include "./Utils.h"  // for DISALLOW_COPY_AND_ASSIGN().
+
+namespace hw3 {
+
+// A MappedIndexFile is an IndexFileSource that maps an entire index file
+// read-only into memory.  It performs the same header, length, and
+// checksum validation as FileIndexReader, but reads are then resolved
+// by pointer arithmetic over the mapping, without issuing a syscall.
+class MappedIndexFile : public IndexFileSource {
+ public:
+  // Map an index file.  Crashes (via Verify333) if the file can't be
+  // opened or mapped, or if it is malformed.
+  //
+  // Arguments:
+  // - file_name: the name of the index file to map.
+  // - validate: a bool indicating whether or not to re-calculate the
+  //   checksum of the index file and compare it against the header.
+  //   Defaults to true.
+  explicit MappedIndexFile(const std::string& file_name,
+                           bool validate = true);
+
+  // Unmaps the file.  Any views still referring to this MappedIndexFile
+  // must have been destroyed first; HashTableView holds a shared_ptr to
+  // guarantee this.
+  ~MappedIndexFile() override;
+
+  // IndexFileSource methods.  The whole file is mapped, so BytesAt()
+  // returns a pointer into the mapping for any range within the file.
+  const uint8_t* BytesAt(IndexFileOffset_t offset,
+                         size_t len) const override;
+  bool ReadBytes(IndexFileOffset_t offset, void* buf,
+                 size_t len) const override;
+  bool ReadString(IndexFileOffset_t offset, size_t len,
+                  std::string* const ret_str) const override;
+
+ private:
+  // The start and length of the read-only mapping.
+  const uint8_t* data_;
+  size_t length_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedIndexFile);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_MAPPEDINDEXFILE_H_
@@ -20,6 +20,9 @@
 #include "libhw1/CSE333.h"
 #include "libhw1/HashTable.h"
 #include "libhw1/LinkedList.h"
+#include "./PositionList.h"
+#include "./StringKey.h"
+#include "./WordPositionArray.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -29,6 +32,14 @@
 // to indicate that they should not be considered part of the MemIndex's
 // public API.
 
+// Rough costs, in bytes, of one more HashTable element and of a new, empty
+// HashTable (including malloc()'s overhead), for the estimates that
+// MemIndex_AddWordPositionArray() returns.  They're in the right range
+// for both of libhw1's HashTable implementations.
+#define MI_HT_ELEMENT_BYTES 64
+#define MI_HT_TABLE_BYTES   1024
+#define MI_MALLOC_OVERHEAD  16
+
 // Comparator usable by LinkedList_Sort(), which implements an increasing
 // order by rank over SearchResult's.  If the caller is interested in a
 // decreasing sort order, they should invert the return value.
@@ -50,12 +61,11 @@ static int MI_SearchResultComparator(LLPayload_t e1, LLPayload_t e2) {
 // malloc'ed), there is nothing to do in this function.
 static void MI_NoOpFree(LLPayload_t ptr) { }
 
-// Deallocator usable by HashTable_Free(), which frees a LinkedList of
-// DocPositionOffset_t (ie, our posting list).  We use these LinkedLists
-// in our WordPostings.
+// Deallocator usable by HashTable_Free(), which frees a PositionList
+// (ie, our posting list).  We use these PositionLists in our
+// WordPostings.
 static void MI_PostingsFree(HTValue_t ptr) {
-  LinkedList* list = (LinkedList*) ptr;
-  LinkedList_Free(list, &MI_NoOpFree);
+  PositionList_Free((PositionList*) ptr);
 }
 
 // Deallocator used by HashTable_Free(), which frees a WordPostings.  A
@@ -70,6 +80,20 @@ static void MI_ValueFree(HTValue_t ptr) {
   free(wp);
 }
 
+// StringKeyFn for the MemIndex, whose elements are keyed on their
+// WordPostings' word.
+static const char* MI_WordOf(HTValue_t value, void* arg) {
+  return ((WordPostings*) value)->word;
+}
+
+// Looks up "word" in "index", setting "kv" to its WordPostings' element
+// if it's there, and "free_key" to the key to insert it at if not.  See
+// StringKey.h.
+static bool MI_FindWord(MemIndex* index, const char* word,
+                        HTKeyValue_t* kv, HTKey_t* free_key) {
+  return StringKey_Find(index, word, &MI_WordOf, NULL, kv, free_key);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // MemIndex implementation
 
@@ -91,7 +115,7 @@ int MemIndex_NumWords(MemIndex* index) {
 
 void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
                              LinkedList* postings) {
-  HTKey_t key = FNVHash64((unsigned char*) word, strlen(word));
+  HTKey_t key;
   HTKeyValue_t mi_kv, postings_kv, unused;
   WordPostings* wp;
 
@@ -105,8 +129,9 @@ void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
   // would pass even if you haven't finished your MemIndex implementation.
 
   // First, we have to see if the passed-in word already exists in
-  // the inverted index.
-  if (!HashTable_Find(index, key, &mi_kv)) {
+  // the inverted index.  A different word with the same hash doesn't
+  // count; if there is one, "key" skips past it.
+  if (!MI_FindWord(index, word, &mi_kv, &key)) {
     // STEP 2.
     // No, this is the first time the inverted index has seen this word.  We
     // need to prepare and insert a new WordPostings structure.  After
@@ -134,10 +159,6 @@ void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
     // already in the inverted index.
     wp = (WordPostings*) mi_kv.value;
 
-    // Ensure we don't have hash collisions (two different words that hash to
-    // the same key, which is very unlikely).
-   Verify333(strcmp(wp->word, word) == 0);
-
     // Now we can free the word (since the caller gave us ownership of it).
     free(word);
   }
@@ -154,13 +175,54 @@ void MemIndex_AddPostingList(MemIndex* index, char* word, DocID_t doc_id,
   // Insert a new entry into the wp->postings hash table.
   // The entry's key is this docID and the entry's value
   // is the "postings" (ie, word positions list) we were passed
-  // as an argument.
-  // if (HashTable_Find(wp->postings, doc_id, &postings_kv)) {
-  //   LinkedList* existingPostings = postings_kv.value;
-  // } else {
+  // as an argument, packed into a PositionList.
   postings_kv.key = doc_id;
-  postings_kv.value = postings;
+  postings_kv.value = PositionList_FromLinkedList(postings);
   HashTable_Insert(wp->postings, postings_kv, &unused);
+  LinkedList_Free(postings, &MI_NoOpFree);
+}
+
+size_t MemIndex_AddWordPositionArray(MemIndex* index,
+                                     const WordPositionArray* wpa,
+                                     DocID_t doc_id) {
+  HTKey_t key;
+  HTKeyValue_t kv, unused;
+  WordPostings* wp;
+  PositionList* positions;
+  size_t bytes = 0;
+
+  Verify333(wpa->word != NULL && wpa->word[0] != '\0');
+
+  // Like MemIndex_AddPostingList(), except that "wpa" still belongs to the
+  // caller (and its Arena), so the index makes its own copies: of the word,
+  // only if this is the first time we've seen it, and of the positions.
+  if (!MI_FindWord(index, wpa->word, &kv, &key)) {
+    size_t word_bytes = strlen(wpa->word) + 1;
+    wp = (WordPostings*) malloc(sizeof(WordPostings));
+    Verify333(wp != NULL);
+    wp->word = (char*) malloc(word_bytes);
+    Verify333(wp->word != NULL);
+    memcpy(wp->word, wpa->word, word_bytes);
+    wp->postings = HashTable_Allocate(16);
+
+    kv.key = key;
+    kv.value = wp;
+    HashTable_Insert(index, kv, &unused);
+    bytes += sizeof(WordPostings) + word_bytes + 2 * MI_MALLOC_OVERHEAD
+      + MI_HT_ELEMENT_BYTES + MI_HT_TABLE_BYTES;
+  } else {
+    wp = (WordPostings*) kv.value;
+  }
+
+  Verify333(!HashTable_Find(wp->postings, doc_id, &kv));
+
+  positions = PositionList_FromArray(wpa->positions, wpa->num_positions);
+  kv.key = doc_id;
+  kv.value = positions;
+  HashTable_Insert(wp->postings, kv, &unused);
+  bytes += PositionList_MemoryBytes(positions) + MI_MALLOC_OVERHEAD
+    + MI_HT_ELEMENT_BYTES;
+  return bytes;
 }
 
 
@@ -191,15 +253,14 @@ LinkedList* MemIndex_Search(MemIndex* index, char* query[], int query_len) {
   // appears in that document).  Finally, append the SearchResult onto ret_list.
 
   SearchResult* ht_it;
-  key = FNVHash64((unsigned char*) query[0], strlen(query[0]));
-  if (HashTable_Find(index, key, &kv)) {
+  if (MI_FindWord(index, query[0], &kv, &key)) {
   wp = (WordPostings*) kv.value;
   HTIterator* ht_it = HTIterator_Allocate(wp->postings);
   while (HTIterator_IsValid(ht_it)) {
     HTIterator_Get(ht_it, &kv); 
     SearchResult* sr = (SearchResult*)malloc(sizeof(SearchResult));
     sr->doc_id = kv.key;
-    sr->rank = LinkedList_NumElements((LinkedList*) kv.value);
+    sr->rank = PositionList_NumPositions((PositionList*) kv.value);
     LinkedList_Append(ret_list, sr);
     HTIterator_Next(ht_it);
   }
@@ -235,8 +296,7 @@ int num = LinkedList_NumElements(ret_list);
     // Look up the next query word (query[i]) in the inverted index.
     // If there are no matches, it means the overall query
     // should return no documents, so free retlist and return NULL.
-    key = FNVHash64((unsigned char*)query[i], strlen(query[i]));
-    if(!HashTable_Find(index, key, &kv)){
+    if (!MI_FindWord(index, query[i], &kv, &key)) {
       LinkedList_Free(ret_list, free);
       return NULL;
     }
@@ -259,7 +319,7 @@ int num = LinkedList_NumElements(ret_list);
     for (j = 0; j < num_docs; j++) {
       LLIterator_Get(ll_it, (void**) &ht_it);
       if(HashTable_Find(wp->postings, ht_it->doc_id, &kv)){
-        ht_it->rank = ht_it->rank + LinkedList_NumElements(kv.value);
+        ht_it->rank = ht_it->rank + PositionList_NumPositions(kv.value);
         LLIterator_Next(ll_it);
       }else{
         LLIterator_Remove(ll_it, free);
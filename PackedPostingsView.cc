@@ -0,0 +1,329 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./PackedPostingsView.h"
+
+#include <stdint.h>   // for uint8_t, etc.
+#include <algorithm>  // for std::lower_bound(), std::min().
+#include <list>       // for std::list.
+#include <memory>     // for std::shared_ptr.
+#include <vector>     // for std::vector.
+
+#include "./LayoutStructsV2.h"
+
+using std::list;
+using std::lower_bound;
+using std::shared_ptr;
+using std::vector;
+
+namespace hw3 {
+
+PackedPostingsView::PackedPostingsView(shared_ptr<const IndexFileSource> file,
+                                       IndexFileOffset_t offset, int32_t len)
+  : file_(file), docs_(nullptr), docs_end_(nullptr), positions_end_(nullptr),
+    num_docs_(0), max_tf_score_(PostingsView::max_tf_score()),
+    directory_(nullptr), directory_end_(nullptr), num_blocks_(0) {
+  // Get at the encoded bytes, copying them out of the file only if we
+  // have to.
+  const uint8_t* data = (len >= 0) ? file_->BytesAt(offset, len) : nullptr;
+  if (data == nullptr) {
+    if (len < 0) {
+      return;
+    }
+    buffer_.resize(len);
+    if (len > 0 && !file_->ReadBytes(offset, buffer_.data(), len)) {
+      return;
+    }
+    data = buffer_.data();
+  }
+  const uint8_t* end = data + len;
+
+  // Parse the posting list's header.  Anything we don't understand leaves
+  // the view empty.
+  uint64_t num_docs, docs_bytes;
+  if (len < 1) {
+    return;
+  }
+  const uint8_t encoding = *data;
+  const uint8_t* cursor = data + 1;
+  double max_tf_score = max_tf_score_;
+  if (encoding != kPostingsDeltaVarint
+      && encoding != kPostingsScoredDeltaVarint
+      && encoding != kPostingsBlockMax) {
+    return;
+  }
+  if (encoding != kPostingsDeltaVarint
+      && !ReadMaxScore(&cursor, end, &max_tf_score)) {
+    return;
+  }
+  if (!ReadVarint(&cursor, end, &num_docs) || num_docs > INT32_MAX) {
+    return;
+  }
+  const uint8_t* directory = nullptr;
+  const uint8_t* directory_end = nullptr;
+  uint64_t num_blocks = 0;
+  if (encoding == kPostingsBlockMax) {
+    uint64_t directory_bytes;
+    if (!ReadVarint(&cursor, end, &num_blocks)
+        || num_blocks != (num_docs + kPostingsBlockSize - 1)
+                         / kPostingsBlockSize
+        || !ReadVarint(&cursor, end, &directory_bytes)
+        || directory_bytes > static_cast<uint64_t>(end - cursor)) {
+      return;
+    }
+    directory = cursor;
+    directory_end = cursor + directory_bytes;
+    cursor = directory_end;
+  }
+  if (!ReadVarint(&cursor, end, &docs_bytes)
+      || docs_bytes > static_cast<uint64_t>(end - cursor)) {
+    return;
+  }
+  docs_ = cursor;
+  docs_end_ = cursor + docs_bytes;
+  positions_end_ = end;
+  num_docs_ = num_docs;
+  max_tf_score_ = max_tf_score;
+  directory_ = directory;
+  directory_end_ = directory_end;
+  num_blocks_ = num_blocks;
+}
+
+bool PackedPostingsView::LookupDocID(
+     const DocID_t& doc_id, list<DocPositionOffset_t>* const ret_val) const {
+  // Start at the only block that could hold "doc_id".
+  vector<PostingsBlock> blocks;
+  GetBlocks(&blocks);
+  auto block = lower_bound(blocks.begin(), blocks.end(), doc_id,
+                           [](const PostingsBlock& b, DocID_t id) {
+                             return b.last_doc_id < id;
+                           });
+  if (block == blocks.end()) {
+    return false;
+  }
+  const uint8_t* doc_cursor = docs_ + block->docs_offset;
+  const uint8_t* pos_cursor = docs_end_ + block->positions_offset;
+  DocID_t cur_doc_id = block->base_doc_id;
+
+  // Walk the block's doc stream until we reach (or pass) "doc_id",
+  // keeping the position stream cursor in step by skipping over each
+  // earlier document's positions.
+  for (int i = 0; i < block->num_docs; i++) {
+    uint64_t delta, num_positions;
+    if (!ReadVarint(&doc_cursor, docs_end_, &delta)
+        || !ReadVarint(&doc_cursor, docs_end_, &num_positions)) {
+      return false;
+    }
+    cur_doc_id += delta;
+
+    if (cur_doc_id > doc_id) {
+      // The stream is sorted, so "doc_id" isn't in it.
+      return false;
+    }
+    if (cur_doc_id < doc_id) {
+      if (!SkipVarints(&pos_cursor, positions_end_, num_positions)) {
+        return false;
+      }
+      continue;
+    }
+
+    // Found it; decode its positions.
+    list<DocPositionOffset_t> positions;
+    DocPositionOffset_t position = 0;
+    for (uint64_t j = 0; j < num_positions; j++) {
+      uint64_t pos_delta;
+      if (!ReadVarint(&pos_cursor, positions_end_, &pos_delta)) {
+        return false;
+      }
+      position += pos_delta;
+      positions.push_back(position);
+    }
+    *ret_val = positions;
+    return true;
+  }
+
+  // We failed to find a matching docID, so return false.
+  return false;
+}
+
+bool PackedPostingsView::GetBlockPositions(
+    const PostingsBlock& block,
+    vector<vector<DocPositionOffset_t>>* const positions) const {
+  const uint8_t* doc_cursor = docs_ + block.docs_offset;
+  const uint8_t* pos_cursor = docs_end_ + block.positions_offset;
+  positions->resize(block.num_docs);
+  for (int i = 0; i < block.num_docs; i++) {
+    uint64_t delta, num_positions;
+    if (!ReadVarint(&doc_cursor, docs_end_, &delta)
+        || !ReadVarint(&doc_cursor, docs_end_, &num_positions)) {
+      return false;
+    }
+    vector<DocPositionOffset_t>& doc_positions = (*positions)[i];
+    doc_positions.clear();
+    doc_positions.reserve(num_positions);
+    DocPositionOffset_t position = 0;
+    for (uint64_t j = 0; j < num_positions; j++) {
+      uint64_t pos_delta;
+      if (!ReadVarint(&pos_cursor, positions_end_, &pos_delta)) {
+        return false;
+      }
+      position += pos_delta;
+      doc_positions.push_back(position);
+    }
+  }
+  return true;
+}
+
+list<DocIDElementHeader> PackedPostingsView::GetDocIDList() const {
+  vector<DocIDElementHeader> docs;
+  GetSortedDocIDs(&docs);
+  return list<DocIDElementHeader>(docs.begin(), docs.end());
+}
+
+void PackedPostingsView::GetSortedDocIDs(
+    vector<DocIDElementHeader>* const docs) const {
+  // The doc stream is already in docID order, and the positions aren't
+  // needed.
+  docs->clear();
+  docs->reserve(num_docs_);
+  DecodeDocs(docs_, 0, num_docs_, docs);
+}
+
+void PackedPostingsView::GetBlocks(vector<PostingsBlock>* const blocks) const {
+  if (directory_ == nullptr) {
+    PostingsView::GetBlocks(blocks);
+    return;
+  }
+
+  // Add up the blocks' shares of the streams as we go, to find where each
+  // one starts.  A malformed directory cuts the list short.
+  blocks->clear();
+  blocks->reserve(num_blocks_);
+  const uint8_t* cursor = directory_;
+  DocID_t last_doc_id = 0;
+  int64_t docs_offset = 0, positions_offset = 0;
+  const int64_t docs_bytes = docs_end_ - docs_;
+  const int64_t positions_bytes = positions_end_ - docs_end_;
+  for (int i = 0; i < num_blocks_; i++) {
+    uint64_t delta, block_docs_bytes, block_positions_bytes;
+    double max_tf_score;
+    if (!ReadVarint(&cursor, directory_end_, &delta)
+        || !ReadVarint(&cursor, directory_end_, &block_docs_bytes)
+        || !ReadVarint(&cursor, directory_end_, &block_positions_bytes)
+        || !ReadMaxScore(&cursor, directory_end_, &max_tf_score)
+        || block_docs_bytes > static_cast<uint64_t>(docs_bytes - docs_offset)
+        || block_positions_bytes
+           > static_cast<uint64_t>(positions_bytes - positions_offset)) {
+      return;
+    }
+    int num_docs = std::min(kPostingsBlockSize,
+                            num_docs_ - i * kPostingsBlockSize);
+    blocks->push_back({last_doc_id + delta, max_tf_score, last_doc_id,
+                       num_docs, docs_offset, positions_offset});
+    last_doc_id += delta;
+    docs_offset += block_docs_bytes;
+    positions_offset += block_positions_bytes;
+  }
+}
+
+void PackedPostingsView::GetBlockDocIDs(
+    const PostingsBlock& block, vector<DocIDElementHeader>* const docs) const {
+  docs->clear();
+  docs->reserve(block.num_docs);
+  DecodeDocs(docs_ + block.docs_offset, block.base_doc_id, block.num_docs,
+             docs);
+}
+
+void PackedPostingsView::DecodeDocs(
+    const uint8_t* cursor, DocID_t base_doc_id, int count,
+    vector<DocIDElementHeader>* const docs) const {
+  DocID_t cur_doc_id = base_doc_id;
+  for (int i = 0; i < count; i++) {
+    uint64_t delta, num_positions;
+    if (!ReadVarint(&cursor, docs_end_, &delta)
+        || !ReadVarint(&cursor, docs_end_, &num_positions)) {
+      break;
+    }
+    cur_doc_id += delta;
+    docs->push_back(DocIDElementHeader(cur_doc_id, num_positions));
+  }
+}
+
+bool PackedPostingsView::GetSortedPositions(
+    const vector<DocID_t>& doc_ids,
+    vector<vector<DocPositionOffset_t>>* const positions) const {
+  vector<PostingsBlock> blocks;
+  GetBlocks(&blocks);
+
+  // Like LookupDocID(), but a single pass over both streams serves every
+  // docID, since they're sorted too.  Blocks that hold none of them are
+  // jumped over.
+  positions->resize(doc_ids.size());
+  size_t next = 0, block = 0;
+  const uint8_t* doc_cursor = nullptr;
+  const uint8_t* pos_cursor = nullptr;
+  DocID_t cur_doc_id = 0;
+  int docs_left = 0;
+  while (next < doc_ids.size()) {
+    if (docs_left == 0 || blocks[block].last_doc_id < doc_ids[next]) {
+      // Move on to the block that holds the next docID.
+      if (docs_left != 0 || doc_cursor != nullptr) {
+        block++;
+      }
+      while (block < blocks.size()
+             && blocks[block].last_doc_id < doc_ids[next]) {
+        block++;
+      }
+      if (block == blocks.size()) {
+        return false;
+      }
+      doc_cursor = docs_ + blocks[block].docs_offset;
+      pos_cursor = docs_end_ + blocks[block].positions_offset;
+      cur_doc_id = blocks[block].base_doc_id;
+      docs_left = blocks[block].num_docs;
+    }
+
+    uint64_t delta, num_positions;
+    if (!ReadVarint(&doc_cursor, docs_end_, &delta)
+        || !ReadVarint(&doc_cursor, docs_end_, &num_positions)) {
+      return false;
+    }
+    cur_doc_id += delta;
+    docs_left--;
+
+    if (cur_doc_id > doc_ids[next]) {
+      // We passed it, so it isn't in the posting list.
+      return false;
+    }
+    if (cur_doc_id < doc_ids[next]) {
+      if (!SkipVarints(&pos_cursor, positions_end_, num_positions)) {
+        return false;
+      }
+      continue;
+    }
+
+    vector<DocPositionOffset_t>& doc_positions = (*positions)[next++];
+    doc_positions.clear();
+    doc_positions.reserve(num_positions);
+    DocPositionOffset_t position = 0;
+    for (uint64_t j = 0; j < num_positions; j++) {
+      uint64_t pos_delta;
+      if (!ReadVarint(&pos_cursor, positions_end_, &pos_delta)) {
+        return false;
+      }
+      position += pos_delta;
+      doc_positions.push_back(position);
+    }
+  }
+  return true;
+}
+
+}  // namespace hw3
@@ -0,0 +1,107 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_PACKEDPOSTINGSVIEW_H_
+#define HW3_PACKEDPOSTINGSVIEW_H_
+
+#include <stdint.h>  // for uint8_t, etc.
+#include <list>      // for std::list.
+#include <memory>    // for std::shared_ptr.
+#include <vector>    // for std::vector.
+
+#include "./IndexFileSource.h"
+#include "./LayoutStructsV2.h"
+#include "./PostingsView.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A PackedPostingsView decodes one word's posting list from a v2 index
+// file (see LayoutStructsV2.h).  Lookups walk the docID-sorted doc stream
+// sequentially instead of probing a hash table, and only decode the
+// position stream for the document whose positions were asked for.  If
+// the posting list has a block directory, they start at the block that
+// holds the document, rather than at the beginning.
+//
+// If the source is memory-resident (see IndexFileSource::BytesAt()), the
+// view decodes straight out of it; otherwise it reads the encoded posting
+// list into a private buffer once, when it's constructed.
+// PackedPostingsViews are manufactured by IndexTableView::LookupWord().
+class PackedPostingsView : public PostingsView {
+ public:
+  // PostingsView methods.
+  bool LookupDocID(const DocID_t& doc_id,
+                   std::list<DocPositionOffset_t>* const ret_val)
+      const override;
+  std::list<DocIDElementHeader> GetDocIDList() const override;
+  bool IsSortedByDocID() const override { return true; }
+  int num_docs() const override { return num_docs_; }
+  double max_tf_score() const override { return max_tf_score_; }
+  void GetBlocks(std::vector<PostingsBlock>* const blocks) const override;
+  void GetBlockDocIDs(
+      const PostingsBlock& block,
+      std::vector<DocIDElementHeader>* const docs) const override;
+  bool GetBlockPositions(
+      const PostingsBlock& block,
+      std::vector<std::vector<DocPositionOffset_t>>* const positions)
+      const override;
+  void GetSortedDocIDs(
+      std::vector<DocIDElementHeader>* const docs) const override;
+  bool GetSortedPositions(
+      const std::vector<DocID_t>& doc_ids,
+      std::vector<std::vector<DocPositionOffset_t>>* const positions)
+      const override;
+
+ protected:
+  // Construct a view of the "len"-byte encoded posting list stored at
+  // byte offset "offset" of "file".  Only IndexTableView should
+  // manufacture these.  If the posting list can't be read or is
+  // malformed, the view is empty.
+  PackedPostingsView(std::shared_ptr<const IndexFileSource> file,
+                     IndexFileOffset_t offset, int32_t len);
+
+ private:
+  friend class IndexTableView;
+
+  // Appends the "count" doc stream entries starting at "cursor" to
+  // "docs"; the first docID delta is relative to "base_doc_id".  Stops
+  // short if the doc stream is malformed.
+  void DecodeDocs(const uint8_t* cursor, DocID_t base_doc_id, int count,
+                  std::vector<DocIDElementHeader>* const docs) const;
+
+  // The index file we're viewing; holding onto it keeps "data_" valid.
+  std::shared_ptr<const IndexFileSource> file_;
+
+  // Our copy of the encoded posting list, if the source isn't
+  // memory-resident.
+  std::vector<uint8_t> buffer_;
+
+  // The doc stream, and the position stream that follows it.
+  const uint8_t* docs_;
+  const uint8_t* docs_end_;
+  const uint8_t* positions_end_;
+  int num_docs_;
+
+  // The posting list's max_tf_score, or the default bound if it doesn't
+  // record one.
+  double max_tf_score_;
+
+  // The block directory, if the posting list has one.
+  const uint8_t* directory_;
+  const uint8_t* directory_end_;
+  int num_blocks_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackedPostingsView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_PACKEDPOSTINGSVIEW_H_
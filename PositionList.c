@@ -0,0 +1,151 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./PositionList.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "libhw1/CSE333.h"
+
+struct position_list_st {
+  int32_t num_positions;  // how many positions are encoded
+  int32_t num_bytes;      // the length of "bytes"
+  uint8_t bytes[];        // the varint-encoded deltas
+};
+
+// Returns the length of the varint encoding of "value".
+static int VarintBytes(uint32_t value) {
+  int bytes = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    bytes++;
+  }
+  return bytes;
+}
+
+// Comparator usable by qsort(), which orders DocPositionOffset_ts.
+static int PositionCompare(const void* p1, const void* p2) {
+  DocPositionOffset_t pos1 = *(const DocPositionOffset_t*) p1;
+  DocPositionOffset_t pos2 = *(const DocPositionOffset_t*) p2;
+  return (pos1 > pos2) - (pos1 < pos2);
+}
+
+PositionList* PositionList_FromArray(const DocPositionOffset_t* positions,
+                                     int num_positions) {
+  PositionList* list;
+  DocPositionOffset_t prev = 0;
+  uint8_t* out;
+  int num_bytes = 0;
+  int i;
+
+  // Size the encoding first, so that the list is a single, exactly-sized
+  // allocation.
+  for (i = 0; i < num_positions; i++) {
+    Verify333(positions[i] >= prev);
+    num_bytes += VarintBytes(positions[i] - prev);
+    prev = positions[i];
+  }
+
+  list = (PositionList*) malloc(sizeof(PositionList) + num_bytes);
+  Verify333(list != NULL);
+  list->num_positions = num_positions;
+  list->num_bytes = num_bytes;
+
+  out = list->bytes;
+  prev = 0;
+  for (i = 0; i < num_positions; i++) {
+    uint32_t delta = positions[i] - prev;
+    while (delta >= 0x80) {
+      *out++ = (uint8_t) delta | 0x80;
+      delta >>= 7;
+    }
+    *out++ = (uint8_t) delta;
+    prev = positions[i];
+  }
+  return list;
+}
+
+PositionList* PositionList_FromLinkedList(LinkedList* list) {
+  int num_positions = LinkedList_NumElements(list);
+  DocPositionOffset_t* positions;
+  PositionList* result;
+  LLIterator* it;
+  int i;
+
+  if (num_positions == 0) {
+    return PositionList_FromArray(NULL, 0);
+  }
+
+  // Copy the payloads out, so that we can sort them.
+  positions = (DocPositionOffset_t*)
+      malloc(num_positions * sizeof(DocPositionOffset_t));
+  Verify333(positions != NULL);
+  it = LLIterator_Allocate(list);
+  Verify333(it != NULL);
+  for (i = 0; i < num_positions; i++) {
+    LLPayload_t payload;
+    LLIterator_Get(it, &payload);
+    positions[i] = (DocPositionOffset_t) (intptr_t) payload;
+    LLIterator_Next(it);
+  }
+  LLIterator_Free(it);
+  qsort(positions, num_positions, sizeof(DocPositionOffset_t),
+        &PositionCompare);
+
+  result = PositionList_FromArray(positions, num_positions);
+  free(positions);
+  return result;
+}
+
+void PositionList_Free(PositionList* list) {
+  free(list);
+}
+
+int PositionList_NumPositions(const PositionList* list) {
+  return list->num_positions;
+}
+
+size_t PositionList_MemoryBytes(const PositionList* list) {
+  return sizeof(PositionList) + list->num_bytes;
+}
+
+const uint8_t* PositionList_Bytes(const PositionList* list, int* num_bytes) {
+  *num_bytes = list->num_bytes;
+  return list->bytes;
+}
+
+void PLIterator_Init(PLIterator* iter, const PositionList* list) {
+  iter->next = list->bytes;
+  iter->remaining = list->num_positions;
+  iter->position = 0;
+}
+
+bool PLIterator_Next(PLIterator* iter, DocPositionOffset_t* position) {
+  uint32_t delta = 0;
+  int shift = 0;
+  uint8_t byte;
+
+  if (iter->remaining == 0) {
+    return false;
+  }
+  do {
+    byte = *iter->next++;
+    delta |= (uint32_t) (byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+
+  iter->position += delta;
+  iter->remaining--;
+  *position = iter->position;
+  return true;
+}
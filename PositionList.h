@@ -0,0 +1,72 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW2_POSITIONLIST_H_
+#define HW2_POSITIONLIST_H_
+
+#include <stdbool.h>  // for bool
+#include <stddef.h>   // for size_t
+#include <stdint.h>   // for uint8_t
+
+#include "libhw1/LinkedList.h"
+#include "./FileParser.h"
+
+// A PositionList holds the positions of one word in one document: the
+// values of the MemIndex's per-word docID->positions tables.
+//
+// It's a single allocation holding the positions in increasing order, as
+// varint-encoded deltas (the first from 0).  A word that appears a few
+// times in a document costs a few bytes past a small header, rather than
+// a LinkedList plus a node per position.  The encoding is exactly that of
+// a document's positions in a v2 index file's position stream (see
+// LayoutStructsV2.h), so WriteIndex() copies the bytes straight out.
+typedef struct position_list_st PositionList;
+
+// Returns a new PositionList of the "num_positions" offsets in
+// "positions", which must be in non-decreasing order.  Never returns
+// NULL.
+PositionList* PositionList_FromArray(const DocPositionOffset_t* positions,
+                                     int num_positions);
+
+// Returns a new PositionList of the DocPositionOffset_t payloads of
+// "list", in any order.  "list" is left alone.  Never returns NULL.
+PositionList* PositionList_FromLinkedList(LinkedList* list);
+
+// Frees a PositionList.
+void PositionList_Free(PositionList* list);
+
+// Returns the number of positions in "list".
+int PositionList_NumPositions(const PositionList* list);
+
+// Returns the number of bytes "list" occupies in memory, not counting
+// malloc()'s own overhead.
+size_t PositionList_MemoryBytes(const PositionList* list);
+
+// Returns the encoded deltas of "list", setting "num_bytes" to their
+// length.  The bytes belong to "list".
+const uint8_t* PositionList_Bytes(const PositionList* list, int* num_bytes);
+
+// Decodes the positions of a PositionList, in increasing order.  It's
+// plain data, so it can live on the stack.
+typedef struct {
+  const uint8_t*      next;       // the next encoded delta
+  int                 remaining;  // how many positions are left
+  DocPositionOffset_t position;   // the last position decoded
+} PLIterator;
+
+// Sets up "iter" to decode "list" from its first position.
+void PLIterator_Init(PLIterator* iter, const PositionList* list);
+
+// Decodes the next position into "position" and returns true, or returns
+// false if there are none left.
+bool PLIterator_Next(PLIterator* iter, DocPositionOffset_t* position);
+
+#endif  // HW2_POSITIONLIST_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./PostingsCursor.h"
+
+#include <algorithm>  // for std::lower_bound(), std::min().
+#include <vector>     // for std::vector.
+
+using std::lower_bound;
+using std::min;
+using std::vector;
+
+namespace hw3 {
+
+// Marks PostingsCursor::decoded_block_ as naming no block.
+static const size_t kNoBlock = static_cast<size_t>(-1);
+
+PostingsCursor::PostingsCursor(const PostingsView* postings)
+  : postings_(postings), block_(0), decoded_block_(kNoBlock), doc_(0),
+    have_positions_(false) {
+  postings_->GetBlocks(&blocks_);
+}
+
+bool PostingsCursor::SeekBlock(DocID_t doc_id) {
+  while (block_ < blocks_.size() && blocks_[block_].last_doc_id < doc_id) {
+    block_++;
+  }
+  return block_ < blocks_.size();
+}
+
+bool PostingsCursor::Seek(DocID_t doc_id) {
+  // Most calls ask for a document at or just after the current one.
+  if (decoded_block_ == block_ && doc_ < docs_.size()) {
+    if (docs_[doc_].doc_id >= doc_id) {
+      return true;
+    }
+    if (doc_ + 1 < docs_.size() && docs_[doc_ + 1].doc_id >= doc_id) {
+      doc_++;
+      return true;
+    }
+  }
+
+  while (SeekBlock(doc_id)) {
+    if (decoded_block_ != block_) {
+      postings_->GetBlockDocIDs(blocks_[block_], &docs_);
+      decoded_block_ = block_;
+      doc_ = 0;
+      have_positions_ = false;
+    }
+
+    // The documents we're asked for are usually far apart, so we gallop
+    // forward (probing 1, 2, 4, ... documents ahead) to bracket "doc_id"
+    // and then binary search within the bracket.  That costs O(log gap)
+    // per call rather than the O(gap) of a plain merge.
+    const size_t num_docs = docs_.size();
+    size_t lo = doc_, hi = lo, step = 1;
+    while (hi < num_docs && docs_[hi].doc_id < doc_id) {
+      lo = hi + 1;
+      hi = lo + step;
+      step *= 2;
+    }
+    hi = min(hi, num_docs);
+    doc_ = lower_bound(docs_.begin() + lo, docs_.begin() + hi, doc_id,
+                       [](const DocIDElementHeader& doc, DocID_t id) {
+                         return doc.doc_id < id;
+                       }) - docs_.begin();
+    if (doc_ < num_docs) {
+      return true;
+    }
+
+    // The block's last_doc_id was only a bound, so "doc_id" may belong
+    // to a later block.
+    block_++;
+  }
+  return false;
+}
+
+const vector<DocPositionOffset_t>* PostingsCursor::GetPositions() {
+  if (!have_positions_) {
+    if (!postings_->GetBlockPositions(blocks_[decoded_block_], &positions_)
+        || positions_.size() != docs_.size()) {
+      return nullptr;
+    }
+    have_positions_ = true;
+  }
+  return &positions_[doc_];
+}
+
+}  // namespace hw3
@@ -0,0 +1,84 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_POSTINGSCURSOR_H_
+#define HW3_POSTINGSCURSOR_H_
+
+#include <stddef.h>  // for size_t.
+#include <vector>    // for std::vector.
+
+#include "./LayoutStructs.h"
+#include "./PostingsView.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A PostingsCursor walks forward through a posting list in docID order,
+// one block (see PostingsView::GetBlocks()) at a time.  Moving between
+// blocks only reads the block directory; a block's documents are
+// decoded when the cursor first lands on one of them.  So a query that
+// only needs a few of a long posting list's documents only decodes the
+// blocks that hold them, and one that can tell from a block's
+// max_tf_score that none of its documents matter needn't decode it at
+// all.
+class PostingsCursor {
+ public:
+  // Construct a cursor at the start of "postings", which must outlive
+  // it.
+  explicit PostingsCursor(const PostingsView* postings);
+
+  // Moves to the first block whose last_doc_id is at least "doc_id",
+  // without decoding it.  Returns false if there isn't one, in which
+  // case the posting list holds no more documents that large.  "doc_id"
+  // must be at least as large as any docID passed to an earlier call.
+  bool SeekBlock(DocID_t doc_id);
+
+  // Moves to the first document whose docID is at least "doc_id",
+  // decoding its block if needed.  Returns false if there isn't one.
+  // "doc_id" must be at least as large as any docID passed to an earlier
+  // call.
+  bool Seek(DocID_t doc_id);
+
+  // The block the cursor is in; only valid after SeekBlock() or Seek()
+  // returns true.
+  const PostingsBlock& block() const { return blocks_[block_]; }
+
+  // The document the cursor is at; only valid after Seek() returns true.
+  const DocIDElementHeader& doc() const { return docs_[doc_]; }
+
+  // Returns the positions of the word in doc(), in increasing order, or
+  // nullptr if the posting list can't be read.  Only valid after Seek()
+  // returns true, and only until the cursor next moves.  The first call
+  // in a block decodes the positions of all of its documents, which the
+  // calls after it share.
+  const std::vector<DocPositionOffset_t>* GetPositions();
+
+ private:
+  const PostingsView* postings_;
+  std::vector<PostingsBlock> blocks_;
+  size_t block_;
+
+  // The documents of the block numbered "decoded_block_", if any, and
+  // which of them we're at.
+  std::vector<DocIDElementHeader> docs_;
+  size_t decoded_block_;
+  size_t doc_;
+
+  // The positions of the documents in "docs_", if they've been decoded.
+  std::vector<std::vector<DocPositionOffset_t>> positions_;
+  bool have_positions_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostingsCursor);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_POSTINGSCURSOR_H_
@@ -0,0 +1,82 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./PostingsView.h"
+
+#include <algorithm>  // for std::sort().
+#include <limits>     // for std::numeric_limits.
+#include <list>       // for std::list.
+#include <vector>     // for std::vector.
+
+using std::list;
+using std::sort;
+using std::vector;
+
+namespace hw3 {
+
+void PostingsView::GetSortedDocIDs(
+    vector<DocIDElementHeader>* const docs) const {
+  list<DocIDElementHeader> doc_id_list = GetDocIDList();
+  docs->assign(doc_id_list.begin(), doc_id_list.end());
+  if (!IsSortedByDocID()) {
+    sort(docs->begin(), docs->end(),
+         [](const DocIDElementHeader& a, const DocIDElementHeader& b) {
+           return a.doc_id < b.doc_id;
+         });
+  }
+}
+
+void PostingsView::GetBlocks(vector<PostingsBlock>* const blocks) const {
+  // We don't know the largest docID without reading them all, but the
+  // largest possible one will do.
+  blocks->assign(1, {std::numeric_limits<DocID_t>::max(), max_tf_score(),
+                     0, num_docs(), 0, 0});
+}
+
+void PostingsView::GetBlockDocIDs(
+    const PostingsBlock& block,
+    vector<DocIDElementHeader>* const docs) const {
+  GetSortedDocIDs(docs);
+}
+
+bool PostingsView::GetBlockPositions(
+    const PostingsBlock& block,
+    vector<vector<DocPositionOffset_t>>* const positions) const {
+  vector<DocIDElementHeader> docs;
+  GetBlockDocIDs(block, &docs);
+  positions->resize(docs.size());
+  for (size_t i = 0; i < docs.size(); i++) {
+    list<DocPositionOffset_t> doc_positions;
+    if (!LookupDocID(docs[i].doc_id, &doc_positions)) {
+      return false;
+    }
+    (*positions)[i].assign(doc_positions.begin(), doc_positions.end());
+    sort((*positions)[i].begin(), (*positions)[i].end());
+  }
+  return true;
+}
+
+bool PostingsView::GetSortedPositions(
+    const vector<DocID_t>& doc_ids,
+    vector<vector<DocPositionOffset_t>>* const positions) const {
+  positions->resize(doc_ids.size());
+  for (size_t i = 0; i < doc_ids.size(); i++) {
+    list<DocPositionOffset_t> doc_positions;
+    if (!LookupDocID(doc_ids[i], &doc_positions)) {
+      return false;
+    }
+    (*positions)[i].assign(doc_positions.begin(), doc_positions.end());
+    sort((*positions)[i].begin(), (*positions)[i].end());
+  }
+  return true;
+}
+
+}  // namespace hw3
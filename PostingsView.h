@@ -0,0 +1,139 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_POSTINGSVIEW_H_
+#define HW3_POSTINGSVIEW_H_
+
+#include <stdint.h>  // for int64_t.
+#include <list>      // for std::list.
+#include <vector>    // for std::vector.
+
+#include "./BM25.h"
+#include "./LayoutStructs.h"
+
+namespace hw3 {
+
+// A run of consecutive documents (in docID order) within a posting list.
+// Queries can skip over a block as a whole, without decoding it, when
+// none of its documents could be the one they're looking for; see
+// PostingsView::GetBlocks().
+struct PostingsBlock {
+  DocID_t last_doc_id;   // no docID in the block is larger, and every
+                         // docID in the next block is
+  double  max_tf_score;  // as for PostingsView::max_tf_score(), but for
+                         // just this block's documents
+
+  // Where the block's documents are, for the view that made it.
+  DocID_t base_doc_id;       // the docID before the block's first
+  int     num_docs;          // how many documents the block holds
+  int64_t docs_offset;       // where they start in the doc stream
+  int64_t positions_offset;  // ...and in the position stream
+};
+
+// A PostingsView is a read-only view of a single word's posting list:
+// which documents the word appears in, and at which positions.  It is
+// the interface that IndexTableView::LookupWord() hands back, whichever
+// version of the index file format the word came from:
+//
+// - DocIDTableView reads a v1 file's nested docid->positions hash table.
+// - PackedPostingsView decodes a v2 file's docID-sorted, delta+varint
+//   encoded posting list.
+//
+// As with the other views, all methods are const and safe to call
+// concurrently.
+class PostingsView {
+ public:
+  virtual ~PostingsView() { }
+
+  // Lookup a docid and get back a std::list<DocPositionOffset_t>
+  // containing the positions listed for that docid.
+  //
+  // Arguments:
+  // - doc_id: the docID to look for within the posting list.
+  // - ret_val: the std::list<DocPositionOffset_t> containing the
+  //   positions of the word in the document (an output parameter).
+  //   Has an unspecified value if the docID is not found.
+  //
+  // Returns:
+  // - true if the docID was found, false otherwise.
+  virtual bool LookupDocID(
+      const DocID_t& doc_id,
+      std::list<DocPositionOffset_t>* const ret_val) const = 0;
+
+  // Returns a list of DocIDElementHeaders, one for each document in
+  // the posting list.
+  virtual std::list<DocIDElementHeader> GetDocIDList() const = 0;
+
+  // Returns true if GetDocIDList() returns its documents in increasing
+  // docID order.
+  virtual bool IsSortedByDocID() const = 0;
+
+  // Returns the number of documents in the posting list (i.e., the
+  // word's document frequency).  This is cheaper than counting
+  // GetDocIDList()'s result, so it's what queries use to decide which
+  // posting lists to read first.
+  virtual int num_docs() const = 0;
+
+  // Returns an upper bound on BM25TermFrequencyScore() (see BM25.h) of
+  // every document in the posting list, which lets queries skip
+  // documents that can't score well enough.  The default implementation
+  // returns the bound that holds for any posting list.
+  virtual double max_tf_score() const { return kBM25MaxTermFrequencyScore; }
+
+  // Replaces the contents of "blocks" with the posting list's blocks, in
+  // docID order.  Reading this directory doesn't decode any documents.
+  // The default implementation returns a single block holding the whole
+  // posting list.
+  virtual void GetBlocks(std::vector<PostingsBlock>* const blocks) const;
+
+  // Like GetSortedDocIDs(), but just for "block", which must be one of
+  // the blocks that GetBlocks() returned.  The default implementation
+  // calls GetSortedDocIDs().
+  virtual void GetBlockDocIDs(
+      const PostingsBlock& block,
+      std::vector<DocIDElementHeader>* const docs) const;
+
+  // Replaces the contents of "positions" with the positions of the word
+  // in each document of "block" (one of the blocks that GetBlocks()
+  // returned), in the order GetBlockDocIDs() returns them, and each in
+  // increasing order.  Returns false if the posting list can't be read.
+  // The default implementation calls LookupDocID() for each document.
+  virtual bool GetBlockPositions(
+      const PostingsBlock& block,
+      std::vector<std::vector<DocPositionOffset_t>>* const positions) const;
+
+  // Replaces the contents of "docs" with a DocIDElementHeader for each
+  // document in the posting list, in increasing docID order.  The
+  // default implementation sorts GetDocIDList()'s result, if it isn't
+  // sorted already.
+  virtual void GetSortedDocIDs(
+      std::vector<DocIDElementHeader>* const docs) const;
+
+  // Looks up the positions of several documents at once.
+  //
+  // Arguments:
+  // - doc_ids: the docIDs to look up, in increasing order.
+  // - positions: resized to doc_ids.size(), with (*positions)[i] set to
+  //   the positions of the word in doc_ids[i], in increasing order (an
+  //   output parameter).
+  //
+  // Returns:
+  // - true if every docID was found, false otherwise.
+  //
+  // The default implementation calls LookupDocID() for each docID.
+  virtual bool GetSortedPositions(
+      const std::vector<DocID_t>& doc_ids,
+      std::vector<std::vector<DocPositionOffset_t>>* const positions) const;
+};
+
+}  // namespace hw3
+
+#endif  // HW3_POSTINGSVIEW_H_
@@ -0,0 +1,77 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./PreadIndexFile.h"
+
+#include <errno.h>      // for errno.
+#include <fcntl.h>      // for open().
+#include <sys/types.h>  // for fstat().
+#include <sys/stat.h>   // for fstat().
+#include <unistd.h>     // for pread(), close().
+
+#include <cstdint>      // for uint8_t.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::string;
+
+namespace hw3 {
+
+PreadIndexFile::PreadIndexFile(const string& file_name, bool validate)
+  : IndexFileSource(file_name) {
+  // Open the file and figure out how big it is.  Crash on error.
+  fd_ = open(file_name_.c_str(), O_RDONLY);
+  Verify333(fd_ != -1);
+
+  struct stat f_stat;
+  Verify333(fstat(fd_, &f_stat) == 0);
+  length_ = f_stat.st_size;
+
+  // Check the header, and possibly the checksum.
+  ReadAndValidateHeader(length_, validate);
+}
+
+PreadIndexFile::~PreadIndexFile() {
+  Verify333(close(fd_) == 0);
+}
+
+bool PreadIndexFile::ReadBytes(IndexFileOffset_t offset, void* buf,
+                               size_t len) const {
+  if (offset < 0 || static_cast<size_t>(offset) > length_
+      || len > length_ - offset) {
+    return false;
+  }
+
+  // Like read(), pread() may return fewer bytes than we asked for, so
+  // loop until we have them all.
+  uint8_t* dst = static_cast<uint8_t*>(buf);
+  while (len > 0) {
+    ssize_t num_read = pread(fd_, dst, len, offset);
+    if (num_read == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (num_read == 0) {
+      // The file shrank out from under us.
+      return false;
+    }
+    dst += num_read;
+    offset += num_read;
+    len -= num_read;
+  }
+  return true;
+}
+
+}  // namespace hw3
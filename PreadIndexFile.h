@@ -0,0 +1,63 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_PREADINDEXFILE_H_
+#define HW3_PREADINDEXFILE_H_
+
+#include <cstddef>  // for size_t.
+#include <string>   // for std::string.
+
+#include "./IndexFileSource.h"
+#include "./LayoutStructs.h"
+#include "./Utils.h"  // for DISALLOW_COPY_AND_ASSIGN().
+
+namespace hw3 {
+
+// A PreadIndexFile is an IndexFileSource that keeps a single descriptor
+// open on an index file and serves every read with pread().  Since
+// pread() never touches the descriptor's file position, one
+// PreadIndexFile can be shared by any number of views and threads,
+// which is something the fseek()/fread() based HashTableReader can't
+// offer without FileDup()'ing its (FILE*).
+//
+// Prefer MappedIndexFile unless the index is too large to map, or lives
+// on a filesystem where mapping isn't desirable.
+class PreadIndexFile : public IndexFileSource {
+ public:
+  // Open an index file.  Crashes (via Verify333) if the file can't be
+  // opened, or if it is malformed.
+  //
+  // Arguments:
+  // - file_name: the name of the index file to open.
+  // - validate: a bool indicating whether or not to re-calculate the
+  //   checksum of the index file and compare it against the header.
+  //   Defaults to true.
+  explicit PreadIndexFile(const std::string& file_name,
+                          bool validate = true);
+
+  // Closes the descriptor.
+  ~PreadIndexFile() override;
+
+  // IndexFileSource methods.
+  bool ReadBytes(IndexFileOffset_t offset, void* buf,
+                 size_t len) const override;
+
+ private:
+  // The descriptor we pread() from, and the length of the file.
+  int fd_;
+  size_t length_;
+
+  DISALLOW_COPY_AND_ASSIGN(PreadIndexFile);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_PREADINDEXFILE_H_
@@ -0,0 +1,461 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./QueryIterator.h"
+
+#include <algorithm>  // for std::stable_sort(), std::min(), etc.
+#include <cmath>      // for HUGE_VAL.
+#include <limits>     // for std::numeric_limits.
+#include <memory>     // for std::unique_ptr.
+#include <utility>    // for std::move().
+#include <vector>     // for std::vector.
+
+#include "./BM25.h"
+
+extern "C" {
+  #include "./libhw1/CSE333.h"
+}
+
+using std::lower_bound;
+using std::max;
+using std::min;
+using std::move;
+using std::stable_sort;
+using std::unique_ptr;
+using std::vector;
+
+namespace hw3 {
+
+// The largest docID, which BlockMaxScore() reports as the end of a run
+// that never ends.
+static const DocID_t kLastDocID = std::numeric_limits<DocID_t>::max();
+
+// The most bytes that may separate consecutive words of a phrase.  Word
+// positions are the byte offsets that words (runs of letters) start at,
+// so a gap of up to 2 bytes can't hide another word, which would need a
+// letter plus a separator on either side of it.  It's still enough for
+// a space, a line break, or punctuation followed by a space.
+static const int64_t kMaxPhraseGap = 2;
+
+// Returns true if the words whose sorted positions are "positions" and
+// whose lengths are "lengths" occur, in order, as a phrase.
+static bool ContainsPhrase(
+    const vector<const vector<DocPositionOffset_t>*>& positions,
+    const vector<int64_t>& lengths);
+
+// Returns true if an occurrence of the word whose sorted positions are
+// "a" and another of the word whose sorted positions are "b" start within
+// "max_distance" bytes of each other.  If "a" and "b" are the same list,
+// the query named the same word twice, and two of its occurrences must
+// be that close.
+static bool ContainsNear(const vector<DocPositionOffset_t>& a,
+                         const vector<DocPositionOffset_t>& b,
+                         int64_t max_distance);
+
+///////////////////////////////////////////////////////////////////////////////
+// TermIterator
+///////////////////////////////////////////////////////////////////////////////
+TermIterator::TermIterator(unique_ptr<PostingsView> postings, double idf,
+                           const DocStatsView* stats)
+  : postings_(move(postings)), cursor_(postings_.get()), idf_(idf),
+    stats_(stats) { }
+
+double TermIterator::Score() const {
+  const DocIDElementHeader& doc = cursor_.doc();
+  if (stats_ == nullptr) {
+    return doc.num_positions;
+  }
+  return idf_ * BM25TermFrequencyScore(doc.num_positions,
+                                       stats_->DocLength(doc.doc_id),
+                                       stats_->avg_doc_length());
+}
+
+double TermIterator::max_score() const {
+  // Occurrence counts aren't bounded by anything the index records.
+  return (stats_ == nullptr) ? HUGE_VAL : idf_ * postings_->max_tf_score();
+}
+
+double TermIterator::BlockMaxScore(DocID_t doc_id,
+                                   DocID_t* const block_end) {
+  if (!cursor_.SeekBlock(doc_id)) {
+    // No documents are left to score.
+    *block_end = kLastDocID;
+    return 0;
+  }
+  const PostingsBlock& block = cursor_.block();
+  *block_end = block.last_doc_id;
+  return (stats_ == nullptr) ? HUGE_VAL : idf_ * block.max_tf_score;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AndIterator
+///////////////////////////////////////////////////////////////////////////////
+AndIterator::AndIterator(vector<unique_ptr<QueryIterator>> children,
+                         vector<unique_ptr<QueryIterator>> excluded)
+  : children_(move(children)), excluded_(move(excluded)),
+    block_max_(children_.size()), block_max_sum_(0), block_max_end_(0),
+    have_block_max_(false), doc_id_(0), positioned_(false) {
+  Verify333(!children_.empty());
+  stable_sort(children_.begin(), children_.end(),
+              [](const unique_ptr<QueryIterator>& a,
+                 const unique_ptr<QueryIterator>& b) {
+                return a->cost() < b->cost();
+              });
+}
+
+bool AndIterator::Seek(DocID_t doc_id, double min_score) {
+  if (positioned_ && doc_id_ >= doc_id) {
+    return true;
+  }
+
+  // The rarest child proposes a document, and the others seek to it.
+  // When one of them overshoots, nothing before where it landed can
+  // match, so that's where the rarest child looks next.
+  //
+  // For a top-K search, we also bound the document's score by the
+  // scores of the children that have matched it so far plus the block
+  // bounds of the rest, and give up on it as soon as that falls short,
+  // before the remaining children decode anything for it.
+  const bool prune = (min_score > -HUGE_VAL);
+  positioned_ = false;
+  while (children_[0]->Seek(doc_id, -HUGE_VAL)) {
+    const DocID_t candidate = children_[0]->doc_id();
+    double bound = 0;
+    if (prune) {
+      if (!have_block_max_ || candidate > block_max_end_) {
+        // The bounds hold until we leave one of the children's blocks.
+        block_max_sum_ = 0;
+        block_max_end_ = kLastDocID;
+        for (size_t i = 1; i < children_.size(); i++) {
+          DocID_t block_end;
+          block_max_[i] = children_[i]->BlockMaxScore(candidate, &block_end);
+          block_max_sum_ += block_max_[i];
+          block_max_end_ = min(block_max_end_, block_end);
+        }
+        have_block_max_ = true;
+      }
+      bound = children_[0]->Score() + block_max_sum_;
+    }
+
+    doc_id = candidate + 1;
+    size_t i = 1;
+    for (; i < children_.size(); i++) {
+      if (prune && bound < min_score) {
+        break;
+      }
+      if (!children_[i]->Seek(candidate, -HUGE_VAL)) {
+        return false;
+      }
+      if (children_[i]->doc_id() != candidate) {
+        doc_id = children_[i]->doc_id();
+        break;
+      }
+      if (prune) {
+        bound += children_[i]->Score() - block_max_[i];
+      }
+    }
+    if (i < children_.size()) {
+      continue;
+    }
+
+    bool excluded = false;
+    for (const auto& ex : excluded_) {
+      if (ex->Seek(candidate, -HUGE_VAL) && ex->doc_id() == candidate) {
+        excluded = true;
+        break;
+      }
+    }
+    if (!excluded) {
+      doc_id_ = candidate;
+      positioned_ = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+double AndIterator::Score() const {
+  double score = 0;
+  for (const auto& child : children_) {
+    score += child->Score();
+  }
+  return score;
+}
+
+double AndIterator::max_score() const {
+  double score = 0;
+  for (const auto& child : children_) {
+    score += child->max_score();
+  }
+  return score;
+}
+
+double AndIterator::BlockMaxScore(DocID_t doc_id,
+                                  DocID_t* const block_end) {
+  // Each child's bound holds up to its own block end, so the sum holds
+  // up to the earliest of them.
+  double score = 0;
+  *block_end = kLastDocID;
+  for (const auto& child : children_) {
+    DocID_t child_end;
+    score += child->BlockMaxScore(doc_id, &child_end);
+    *block_end = min(*block_end, child_end);
+  }
+  return score;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OrIterator
+///////////////////////////////////////////////////////////////////////////////
+OrIterator::OrIterator(vector<unique_ptr<QueryIterator>> children)
+  : children_(move(children)), live_(children_.size(), true),
+    started_(false), doc_id_(0), positioned_(false) {
+  Verify333(!children_.empty());
+}
+
+bool OrIterator::Seek(DocID_t doc_id, double min_score) {
+  if (positioned_ && doc_id_ >= doc_id) {
+    return true;
+  }
+
+  // Move every child that's behind, and take the earliest document any
+  // of them is at.  A child alone may fall short of "min_score" where the
+  // sum wouldn't, so the children can't skip anything.
+  positioned_ = false;
+  for (size_t i = 0; i < children_.size(); i++) {
+    if (!live_[i]) {
+      continue;
+    }
+    if ((!started_ || children_[i]->doc_id() < doc_id)
+        && !children_[i]->Seek(doc_id, -HUGE_VAL)) {
+      live_[i] = false;
+      continue;
+    }
+    if (!positioned_ || children_[i]->doc_id() < doc_id_) {
+      doc_id_ = children_[i]->doc_id();
+      positioned_ = true;
+    }
+  }
+  started_ = true;
+  return positioned_;
+}
+
+double OrIterator::Score() const {
+  double score = 0;
+  for (size_t i = 0; i < children_.size(); i++) {
+    if (live_[i] && children_[i]->doc_id() == doc_id_) {
+      score += children_[i]->Score();
+    }
+  }
+  return score;
+}
+
+double OrIterator::max_score() const {
+  double score = 0;
+  for (const auto& child : children_) {
+    score += child->max_score();
+  }
+  return score;
+}
+
+double OrIterator::BlockMaxScore(DocID_t doc_id,
+                                 DocID_t* const block_end) {
+  double score = 0;
+  *block_end = kLastDocID;
+  for (size_t i = 0; i < children_.size(); i++) {
+    if (!live_[i]) {
+      continue;
+    }
+    DocID_t child_end;
+    score += children_[i]->BlockMaxScore(doc_id, &child_end);
+    *block_end = min(*block_end, child_end);
+  }
+  return score;
+}
+
+int64_t OrIterator::cost() const {
+  int64_t cost = 0;
+  for (const auto& child : children_) {
+    cost += child->cost();
+  }
+  return cost;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ScoredDocsIterator
+///////////////////////////////////////////////////////////////////////////////
+
+// How many documents share each of a ScoredDocsIterator's block bounds.
+static const size_t kBlockDocs = 128;
+
+ScoredDocsIterator::ScoredDocsIterator(vector<ScoredDoc> docs)
+  : docs_(move(docs)), pos_(0), max_score_(0),
+    block_max_((docs_.size() + kBlockDocs - 1) / kBlockDocs, 0) {
+  for (size_t i = 0; i < docs_.size(); i++) {
+    block_max_[i / kBlockDocs] = max(block_max_[i / kBlockDocs],
+                                          docs_[i].second);
+    max_score_ = max(max_score_, docs_[i].second);
+  }
+}
+
+bool ScoredDocsIterator::Seek(DocID_t doc_id, double min_score) {
+  // The ranks are already known, so documents that fall short of
+  // "min_score" cost nothing to skip.
+  pos_ = lower_bound(docs_.begin() + pos_, docs_.end(), doc_id,
+                     [](const ScoredDoc& doc, DocID_t id) {
+                       return doc.first < id;
+                     }) - docs_.begin();
+  while (pos_ < docs_.size() && docs_[pos_].second < min_score) {
+    pos_++;
+  }
+  return pos_ < docs_.size();
+}
+
+double ScoredDocsIterator::BlockMaxScore(DocID_t doc_id,
+                                         DocID_t* const block_end) {
+  size_t i = lower_bound(docs_.begin() + pos_, docs_.end(), doc_id,
+                         [](const ScoredDoc& doc, DocID_t id) {
+                           return doc.first < id;
+                         }) - docs_.begin();
+  if (i == docs_.size()) {
+    // No documents are left to score.
+    *block_end = kLastDocID;
+    return 0;
+  }
+  size_t block = i / kBlockDocs;
+  *block_end = docs_[min(docs_.size(), (block + 1) * kBlockDocs) - 1].first;
+  return block_max_[block];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PositionalIterator, PhraseIterator, and NearIterator
+///////////////////////////////////////////////////////////////////////////////
+PositionalIterator::PositionalIterator(
+    vector<unique_ptr<TermIterator>> words)
+  : all_words_(Adopt(move(words)), vector<unique_ptr<QueryIterator>>()),
+    positions_(words_.size()), checked_doc_id_(0), checked_(false) { }
+
+vector<unique_ptr<QueryIterator>> PositionalIterator::Adopt(
+    vector<unique_ptr<TermIterator>> words) {
+  vector<unique_ptr<QueryIterator>> children;
+  for (auto& word : words) {
+    words_.push_back(word.get());
+    children.emplace_back(move(word));
+  }
+  return children;
+}
+
+bool PositionalIterator::Seek(DocID_t doc_id, double min_score) {
+  // Only the documents that contain every word (and, for a top-K search,
+  // could make the cut) need their positions checked.
+  while (all_words_.Seek(doc_id, min_score)) {
+    const DocID_t candidate = all_words_.doc_id();
+    if (checked_ && candidate == checked_doc_id_) {
+      return true;
+    }
+    bool readable = true;
+    for (size_t w = 0; readable && w < words_.size(); w++) {
+      positions_[w] = words_[w]->GetPositions();
+      readable = (positions_[w] != nullptr);
+    }
+    if (readable && Satisfied(positions_)) {
+      checked_doc_id_ = candidate;
+      checked_ = true;
+      return true;
+    }
+    doc_id = candidate + 1;
+  }
+  return false;
+}
+
+bool PhraseIterator::Satisfied(
+    const vector<const vector<DocPositionOffset_t>*>& positions) const {
+  return ContainsPhrase(positions, lengths_);
+}
+
+bool NearIterator::Satisfied(
+    const vector<const vector<DocPositionOffset_t>*>& positions) const {
+  for (size_t i = 0; i < max_distances_.size(); i++) {
+    const vector<DocPositionOffset_t>& a = *positions[i];
+    const vector<DocPositionOffset_t>& b = same_word_[i] ? a
+                                                         : *positions[i + 1];
+    if (!ContainsNear(a, b, max_distances_[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ContainsPhrase(
+    const vector<const vector<DocPositionOffset_t>*>& positions,
+    const vector<int64_t>& lengths) {
+  // For each occurrence of the first word, chase the phrase forward one
+  // word at a time.  Later occurrences of the first word can only push
+  // each later word's match further along, so each word's cursor only
+  // ever moves forward and the whole check is a single merge pass.
+  const size_t num_words = positions.size();
+  vector<size_t> cursors(num_words, 0);
+  for (DocPositionOffset_t start : *positions[0]) {
+    int64_t word_end = static_cast<int64_t>(start) + lengths[0];
+    size_t w = 1;
+    for (; w < num_words; w++) {
+      const vector<DocPositionOffset_t>& next = *positions[w];
+      size_t& cursor = cursors[w];
+      while (cursor < next.size()
+             && static_cast<int64_t>(next[cursor]) <= word_end) {
+        cursor++;
+      }
+      if (cursor == next.size()) {
+        // This word never occurs again, so no later start can match.
+        return false;
+      }
+      if (static_cast<int64_t>(next[cursor]) - word_end > kMaxPhraseGap) {
+        break;
+      }
+      word_end = static_cast<int64_t>(next[cursor]) + lengths[w];
+    }
+    if (w == num_words) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool ContainsNear(const vector<DocPositionOffset_t>& a,
+                         const vector<DocPositionOffset_t>& b,
+                         int64_t max_distance) {
+  if (&a == &b) {
+    for (size_t i = 1; i < a.size(); i++) {
+      if (static_cast<int64_t>(a[i]) - a[i - 1] <= max_distance) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Walk both lists in step, always advancing whichever is behind; the
+  // closest pair of positions is compared along the way.
+  size_t i = 0, j = 0;
+  while (i < a.size() && j < b.size()) {
+    int64_t distance = static_cast<int64_t>(a[i]) - b[j];
+    if (distance <= max_distance && -distance <= max_distance) {
+      return true;
+    }
+    if (distance < 0) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+  return false;
+}
+
+}  // namespace hw3
@@ -0,0 +1,292 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_QUERYITERATOR_H_
+#define HW3_QUERYITERATOR_H_
+
+#include <stdint.h>  // for int64_t.
+#include <memory>    // for std::unique_ptr.
+#include <utility>   // for std::move(), std::pair.
+#include <vector>    // for std::vector.
+
+#include "./DocStatsView.h"
+#include "./LayoutStructs.h"
+#include "./PostingsCursor.h"
+#include "./PostingsView.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A QueryIterator walks through the documents of one index file that
+// match (part of) a query, in docID order, and ranks each of them.  A
+// query is compiled into a tree of QueryIterators, one per node of its
+// QueryNode tree (see QueryParser.h), whose leaves walk posting lists;
+// each interior node combines its children's documents as it goes, so
+// no intermediate list of results is ever built.
+//
+// As with PostingsCursor, a QueryIterator only moves forward.
+class QueryIterator {
+ public:
+  virtual ~QueryIterator() { }
+
+  // Moves to the first matching document whose docID is at least
+  // "doc_id", or stays put if the iterator is already at one.  Returns
+  // false if there isn't one.  Documents whose Score() would be less
+  // than "min_score" may be skipped, so a top-K search can pass the
+  // score it takes to make the cut (or -HUGE_VAL to skip nothing).
+  virtual bool Seek(DocID_t doc_id, double min_score) = 0;
+
+  // The docID of the current document; only valid after Seek() returns
+  // true.
+  virtual DocID_t doc_id() const = 0;
+
+  // The rank of the current document; only valid after Seek() returns
+  // true.
+  virtual double Score() const = 0;
+
+  // Returns an upper bound on Score(), over every document.
+  virtual double max_score() const = 0;
+
+  // Returns an upper bound on Score() over the documents from "doc_id"
+  // to "*block_end" (an output parameter), inclusive.  This only reads
+  // block directories (see PostingsCursor::SeekBlock()), and "doc_id"
+  // is subject to the same rules as for Seek().
+  virtual double BlockMaxScore(DocID_t doc_id, DocID_t* const block_end) = 0;
+
+  // Returns an estimate of how many documents match, for deciding which
+  // operand of an AND to walk.
+  virtual int64_t cost() const = 0;
+};
+
+// A TermIterator walks a single word's posting list.
+class TermIterator : public QueryIterator {
+ public:
+  // Walk "postings", which we take ownership of.  Documents are ranked
+  // by BM25, using "stats" and the word's BM25 inverse document
+  // frequency "idf", or by the word's number of occurrences if "stats"
+  // is nullptr.
+  TermIterator(std::unique_ptr<PostingsView> postings, double idf,
+               const DocStatsView* stats);
+
+  // QueryIterator methods.
+  bool Seek(DocID_t doc_id, double min_score) override {
+    return cursor_.Seek(doc_id);
+  }
+  DocID_t doc_id() const override { return cursor_.doc().doc_id; }
+  double Score() const override;
+  double max_score() const override;
+  double BlockMaxScore(DocID_t doc_id, DocID_t* const block_end) override;
+  int64_t cost() const override { return postings_->num_docs(); }
+
+  // Returns the positions of the word in the current document, as
+  // PostingsCursor::GetPositions() does.
+  const std::vector<DocPositionOffset_t>* GetPositions() {
+    return cursor_.GetPositions();
+  }
+
+ private:
+  std::unique_ptr<PostingsView> postings_;
+  PostingsCursor cursor_;
+  double idf_;
+  const DocStatsView* stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(TermIterator);
+};
+
+// An AndIterator walks the documents that all of its children match,
+// and none of its excluded children do.  It's ranked by the sum of its
+// children's ranks.
+class AndIterator : public QueryIterator {
+ public:
+  // "children" must not be empty.
+  AndIterator(std::vector<std::unique_ptr<QueryIterator>> children,
+              std::vector<std::unique_ptr<QueryIterator>> excluded);
+
+  // QueryIterator methods.
+  bool Seek(DocID_t doc_id, double min_score) override;
+  DocID_t doc_id() const override { return doc_id_; }
+  double Score() const override;
+  double max_score() const override;
+  double BlockMaxScore(DocID_t doc_id, DocID_t* const block_end) override;
+  int64_t cost() const override { return children_[0]->cost(); }
+
+ private:
+  // Ordered by cost(), so that the rarest child proposes documents and
+  // the rest seek to them.
+  std::vector<std::unique_ptr<QueryIterator>> children_;
+  std::vector<std::unique_ptr<QueryIterator>> excluded_;
+
+  // Each child's BlockMaxScore() (but the first's), their sum, and the
+  // docID up to which they hold, as of the last document Seek() bounded.
+  std::vector<double> block_max_;
+  double block_max_sum_;
+  DocID_t block_max_end_;
+  bool have_block_max_;
+
+  DocID_t doc_id_;
+  bool positioned_;
+
+  DISALLOW_COPY_AND_ASSIGN(AndIterator);
+};
+
+// An OrIterator walks the documents that any of its children match.
+// It's ranked by the sum of the ranks of the children that match.
+class OrIterator : public QueryIterator {
+ public:
+  // "children" must not be empty.
+  explicit OrIterator(std::vector<std::unique_ptr<QueryIterator>> children);
+
+  // QueryIterator methods.
+  bool Seek(DocID_t doc_id, double min_score) override;
+  DocID_t doc_id() const override { return doc_id_; }
+  double Score() const override;
+  double max_score() const override;
+  double BlockMaxScore(DocID_t doc_id, DocID_t* const block_end) override;
+  int64_t cost() const override;
+
+ private:
+  std::vector<std::unique_ptr<QueryIterator>> children_;
+
+  // Whether each child has documents left, once we've started.
+  std::vector<bool> live_;
+  bool started_;
+  DocID_t doc_id_;
+  bool positioned_;
+
+  DISALLOW_COPY_AND_ASSIGN(OrIterator);
+};
+
+// A ScoredDocsIterator walks a list of documents whose ranks were all
+// computed up front, such as the union of more posting lists than an
+// OrIterator could sensibly walk side by side.
+class ScoredDocsIterator : public QueryIterator {
+ public:
+  // A docID, and the document's rank.
+  typedef std::pair<DocID_t, double> ScoredDoc;
+
+  // Walk "docs", which must be sorted by docID.
+  explicit ScoredDocsIterator(std::vector<ScoredDoc> docs);
+
+  // QueryIterator methods.
+  bool Seek(DocID_t doc_id, double min_score) override;
+  DocID_t doc_id() const override { return docs_[pos_].first; }
+  double Score() const override { return docs_[pos_].second; }
+  double max_score() const override { return max_score_; }
+  double BlockMaxScore(DocID_t doc_id, DocID_t* const block_end) override;
+  int64_t cost() const override { return docs_.size(); }
+
+ private:
+  std::vector<ScoredDoc> docs_;
+  size_t pos_;
+
+  // The highest rank of all, and of each run of kBlockDocs documents.
+  double max_score_;
+  std::vector<double> block_max_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScoredDocsIterator);
+};
+
+// A PositionalIterator walks the documents that contain all of its
+// words, and in which the words' positions satisfy some constraint.
+// It's ranked by the sum of its words' ranks.
+class PositionalIterator : public QueryIterator {
+ public:
+  // QueryIterator methods.
+  bool Seek(DocID_t doc_id, double min_score) override;
+  DocID_t doc_id() const override { return all_words_.doc_id(); }
+  double Score() const override { return all_words_.Score(); }
+  double max_score() const override { return all_words_.max_score(); }
+  double BlockMaxScore(DocID_t doc_id, DocID_t* const block_end) override {
+    return all_words_.BlockMaxScore(doc_id, block_end);
+  }
+  int64_t cost() const override { return all_words_.cost(); }
+
+ protected:
+  // Walk "words", which must not be empty.
+  explicit PositionalIterator(
+      std::vector<std::unique_ptr<TermIterator>> words);
+
+  // Returns true if the words, whose positions within the current
+  // document are *positions[i] (in the order they were passed to the
+  // constructor), satisfy the constraint.
+  virtual bool Satisfied(
+      const std::vector<const std::vector<DocPositionOffset_t>*>& positions)
+      const = 0;
+
+ private:
+  // Converts "words" to the children of an AndIterator, noting them in
+  // "words_" along the way.
+  std::vector<std::unique_ptr<QueryIterator>> Adopt(
+      std::vector<std::unique_ptr<TermIterator>> words);
+
+  // The words, in order; "all_words_" owns them.
+  std::vector<TermIterator*> words_;
+  AndIterator all_words_;
+
+  // The words' positions in the current document.
+  std::vector<const std::vector<DocPositionOffset_t>*> positions_;
+
+  // The last document found to satisfy the constraint, if any.
+  DocID_t checked_doc_id_;
+  bool checked_;
+
+  DISALLOW_COPY_AND_ASSIGN(PositionalIterator);
+};
+
+// A PhraseIterator walks the documents in which its words occur as a
+// phrase: consecutively, each one starting within a couple of bytes of
+// where the one before it ends.
+class PhraseIterator : public PositionalIterator {
+ public:
+  // Walk the phrase of "words", whose lengths (in bytes) are "lengths".
+  PhraseIterator(std::vector<std::unique_ptr<TermIterator>> words,
+                 const std::vector<int64_t>& lengths)
+    : PositionalIterator(std::move(words)), lengths_(lengths) { }
+
+ protected:
+  bool Satisfied(
+      const std::vector<const std::vector<DocPositionOffset_t>*>& positions)
+      const override;
+
+ private:
+  std::vector<int64_t> lengths_;
+
+  DISALLOW_COPY_AND_ASSIGN(PhraseIterator);
+};
+
+// A NearIterator walks the documents in which, for each i, an occurrence
+// of words[i] and one of words[i + 1] start within max_distances[i]
+// bytes of each other, in either order.
+class NearIterator : public PositionalIterator {
+ public:
+  // same_word[i] is true if words[i] and words[i + 1] are the same
+  // word, in which case two of its occurrences must be that close.
+  NearIterator(std::vector<std::unique_ptr<TermIterator>> words,
+               const std::vector<int64_t>& max_distances,
+               const std::vector<bool>& same_word)
+    : PositionalIterator(std::move(words)), max_distances_(max_distances),
+      same_word_(same_word) { }
+
+ protected:
+  bool Satisfied(
+      const std::vector<const std::vector<DocPositionOffset_t>*>& positions)
+      const override;
+
+ private:
+  std::vector<int64_t> max_distances_;
+  std::vector<bool> same_word_;
+
+  DISALLOW_COPY_AND_ASSIGN(NearIterator);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_QUERYITERATOR_H_
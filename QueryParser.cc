@@ -0,0 +1,325 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./QueryParser.h"
+
+#include <ctype.h>   // for tolower(), isdigit().
+#include <stddef.h>  // for size_t.
+#include <string>    // for std::string.
+#include <utility>   // for std::move().
+#include <vector>    // for std::vector.
+
+using std::string;
+using std::vector;
+
+namespace hw3 {
+
+// The pieces a query is made of.
+typedef struct {
+  enum Kind {
+    kWord, kOpenQuote, kCloseQuote, kOpenParen, kCloseParen,
+    kAnd, kOr, kNot, kNear,
+  };
+  Kind    kind;
+  string  text;          // for kWord, the word; otherwise the token
+  int64_t max_distance;  // for kNear
+} Lexeme;
+
+// Returns true, and sets "*max_distance", if "token" is "near/<digits>"
+// in any case.  It can't be mistaken for a word, since words only
+// contain letters.
+static bool IsNearOperator(const string& token, int64_t* max_distance) {
+  static const char kNear[] = "near/";
+  const size_t prefix_len = sizeof(kNear) - 1;
+  if (token.size() <= prefix_len || token.size() > prefix_len + 9) {
+    return false;
+  }
+  for (size_t j = 0; j < prefix_len; j++) {
+    if (tolower(static_cast<unsigned char>(token[j])) != kNear[j]) {
+      return false;
+    }
+  }
+  int64_t distance = 0;
+  for (size_t j = prefix_len; j < token.size(); j++) {
+    if (!isdigit(static_cast<unsigned char>(token[j]))) {
+      return false;
+    }
+    distance = distance * 10 + (token[j] - '0');
+  }
+  *max_distance = distance;
+  return true;
+}
+
+// Returns "text" in lower case.
+static string ToLower(const string& text) {
+  string lower = text;
+  for (char& ch : lower) {
+    ch = tolower(static_cast<unsigned char>(ch));
+  }
+  return lower;
+}
+
+// Splits the query's tokens into lexemes.
+static vector<Lexeme> Lex(const vector<string>& query) {
+  vector<Lexeme> lexemes;
+  bool in_phrase = false;
+
+  // Emits the lexeme for a quote or parenthesis character.
+  auto punctuation = [&](char ch) {
+    if (ch == '"') {
+      lexemes.push_back({in_phrase ? Lexeme::kCloseQuote
+                                   : Lexeme::kOpenQuote, "\"", 0});
+      in_phrase = !in_phrase;
+    } else if (!in_phrase) {
+      // Parentheses inside a phrase are ignored.
+      lexemes.push_back({ch == '(' ? Lexeme::kOpenParen
+                                   : Lexeme::kCloseParen, string(1, ch), 0});
+    }
+  };
+
+  // Emits the lexeme for a word or operator.
+  auto word = [&](const string& text) {
+    int64_t distance;
+    if (in_phrase) {
+      lexemes.push_back({Lexeme::kWord, ToLower(text), 0});
+    } else if (text == "AND") {
+      lexemes.push_back({Lexeme::kAnd, text, 0});
+    } else if (text == "OR") {
+      lexemes.push_back({Lexeme::kOr, text, 0});
+    } else if (text == "NOT") {
+      lexemes.push_back({Lexeme::kNot, text, 0});
+    } else if (IsNearOperator(text, &distance)) {
+      lexemes.push_back({Lexeme::kNear, text, distance});
+    } else {
+      lexemes.push_back({Lexeme::kWord, ToLower(text), 0});
+    }
+  };
+
+  // Quotes and parentheses needn't be separated from the words around
+  // them, so they split tokens too.
+  for (const string& token : query) {
+    size_t start = 0;
+    for (size_t j = 0; j <= token.size(); j++) {
+      if (j < token.size() && token[j] != '"' && token[j] != '('
+          && token[j] != ')') {
+        continue;
+      }
+      if (j > start) {
+        word(token.substr(start, j - start));
+      }
+      if (j < token.size()) {
+        punctuation(token[j]);
+      }
+      start = j + 1;
+    }
+  }
+  return lexemes;
+}
+
+// Turns the operators in "lexemes" that have nothing to apply to into
+// words.
+static void DemoteStrayOperators(vector<Lexeme>* lexemes) {
+  auto ends_operand = [](const Lexeme& lexeme) {
+    return lexeme.kind == Lexeme::kWord || lexeme.kind == Lexeme::kCloseQuote
+           || lexeme.kind == Lexeme::kCloseParen;
+  };
+  auto starts_operand = [](const Lexeme& lexeme) {
+    return lexeme.kind == Lexeme::kWord || lexeme.kind == Lexeme::kOpenQuote
+           || lexeme.kind == Lexeme::kOpenParen || lexeme.kind == Lexeme::kNot;
+  };
+
+  vector<Lexeme>& l = *lexemes;
+  for (size_t i = 0; i < l.size(); i++) {
+    bool has_prev = i > 0, has_next = i + 1 < l.size();
+    bool valid = true;
+    switch (l[i].kind) {
+      case Lexeme::kAnd:
+      case Lexeme::kOr:
+        valid = has_prev && ends_operand(l[i - 1])
+                && has_next && starts_operand(l[i + 1]);
+        break;
+      case Lexeme::kNot:
+        valid = has_next && starts_operand(l[i + 1]);
+        break;
+      case Lexeme::kNear:
+        valid = has_prev && l[i - 1].kind == Lexeme::kWord
+                && has_next && l[i + 1].kind == Lexeme::kWord;
+        break;
+      default:
+        break;
+    }
+    if (!valid) {
+      l[i].kind = Lexeme::kWord;
+      l[i].text = ToLower(l[i].text);
+    }
+  }
+}
+
+// A recursive descent parser over a query's lexemes.  From loosest to
+// tightest binding:
+//
+//   or      := and { OR and }
+//   and     := { [AND] [NOT ...] primary }
+//   primary := ( or ) | " word ... " | word { NEAR/k word } | prefix*
+class Parser {
+ public:
+  explicit Parser(const vector<Lexeme>& lexemes)
+    : lexemes_(lexemes), next_(0) { }
+
+  QueryNode ParseAll() {
+    QueryNode root = ParseOr();
+    while (next_ < lexemes_.size()) {
+      // Only an unmatched closing parenthesis can stop ParseOr() early;
+      // skip it, and carry on as if the query were juxtaposed.
+      next_++;
+      QueryNode rest = ParseOr();
+      root = Combine(QueryNode::kAnd, std::move(root), std::move(rest));
+    }
+    return root;
+  }
+
+ private:
+  bool Peek(Lexeme::Kind kind) const {
+    return next_ < lexemes_.size() && lexemes_[next_].kind == kind;
+  }
+
+  QueryNode ParseOr() {
+    QueryNode node = ParseAnd();
+    while (Peek(Lexeme::kOr)) {
+      next_++;
+      node = Combine(QueryNode::kOr, std::move(node), ParseAnd());
+    }
+    return node;
+  }
+
+  QueryNode ParseAnd() {
+    QueryNode node = {QueryNode::kAnd, "", {}, {}, {}};
+    while (next_ < lexemes_.size()) {
+      if (Peek(Lexeme::kAnd)) {
+        next_++;
+        continue;
+      }
+      bool negated = false;
+      while (Peek(Lexeme::kNot)) {
+        next_++;
+        negated = !negated;
+      }
+      if (!Peek(Lexeme::kWord) && !Peek(Lexeme::kOpenQuote)
+          && !Peek(Lexeme::kOpenParen)) {
+        break;
+      }
+      QueryNode operand = ParsePrimary();
+      if (negated) {
+        node.excluded.push_back(std::move(operand));
+      } else if (operand.kind == QueryNode::kAnd) {
+        // Flatten nested conjunctions, so that "a (NOT b)" excludes b from
+        // a, and empty groups and phrases are ignored.
+        for (QueryNode& child : operand.children) {
+          node.children.push_back(std::move(child));
+        }
+        for (QueryNode& child : operand.excluded) {
+          node.excluded.push_back(std::move(child));
+        }
+      } else {
+        node.children.push_back(std::move(operand));
+      }
+    }
+    if (node.children.size() == 1 && node.excluded.empty()) {
+      return std::move(node.children[0]);
+    }
+    return node;
+  }
+
+  QueryNode ParsePrimary() {
+    if (Peek(Lexeme::kOpenParen)) {
+      next_++;
+      QueryNode node = ParseOr();
+      if (Peek(Lexeme::kCloseParen)) {
+        next_++;
+      }
+      return node;
+    }
+
+    if (Peek(Lexeme::kOpenQuote)) {
+      next_++;
+      QueryNode node = {QueryNode::kPhrase, "", {}, {}, {}};
+      while (Peek(Lexeme::kWord)) {
+        node.children.push_back(Word(lexemes_[next_++].text));
+      }
+      if (Peek(Lexeme::kCloseQuote)) {
+        next_++;
+      }
+      if (node.children.size() == 1) {
+        return std::move(node.children[0]);
+      }
+      if (node.children.empty()) {
+        // A pair of quotes around nothing.
+        node.kind = QueryNode::kAnd;
+      }
+      return node;
+    }
+
+    const string& text = lexemes_[next_++].text;
+    if (!Peek(Lexeme::kNear)) {
+      return Term(text);
+    }
+    QueryNode node = Word(text);
+    QueryNode near = {QueryNode::kNear, "", {}, {}, {}};
+    near.children.push_back(std::move(node));
+    while (Peek(Lexeme::kNear)) {
+      near.max_distances.push_back(lexemes_[next_++].max_distance);
+      near.children.push_back(Word(lexemes_[next_++].text));
+    }
+    return near;
+  }
+
+  static QueryNode Word(const string& word) {
+    return {QueryNode::kWord, word, {}, {}, {}};
+  }
+
+  // Returns a kPrefix node if "text" is a prefix followed by "*"s, or a
+  // kWord otherwise.  A bare "*" is just a word, which matches nothing,
+  // rather than every word in the index.
+  static QueryNode Term(const string& text) {
+    size_t len = text.find_last_not_of('*') + 1;
+    if (len == 0 || len == text.size()) {
+      return Word(text);
+    }
+    return {QueryNode::kPrefix, text.substr(0, len), {}, {}, {}};
+  }
+
+  // Returns a node of kind "kind" (kAnd or kOr) over "a" and "b".
+  static QueryNode Combine(QueryNode::Kind kind, QueryNode a, QueryNode b) {
+    QueryNode node = {kind, "", {}, {}, {}};
+    for (QueryNode* operand : {&a, &b}) {
+      if (operand->kind == kind && operand->excluded.empty()
+          && !operand->children.empty()) {
+        for (QueryNode& child : operand->children) {
+          node.children.push_back(std::move(child));
+        }
+      } else {
+        node.children.push_back(std::move(*operand));
+      }
+    }
+    return node;
+  }
+
+  const vector<Lexeme>& lexemes_;
+  size_t next_;
+};
+
+QueryNode ParseQuery(const vector<string>& query) {
+  vector<Lexeme> lexemes = Lex(query);
+  DemoteStrayOperators(&lexemes);
+  return Parser(lexemes).ParseAll();
+}
+
+}  // namespace hw3
@@ -0,0 +1,83 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_QUERYPARSER_H_
+#define HW3_QUERYPARSER_H_
+
+#include <stdint.h>  // for int64_t.
+#include <string>    // for std::string.
+#include <vector>    // for std::vector.
+
+namespace hw3 {
+
+// One node of a parsed query.  Which documents a node matches depends on
+// its kind:
+struct QueryNode {
+  enum Kind {
+    // Those containing "word".
+    kWord,
+
+    // Those containing any word that starts with "word".
+    kPrefix,
+
+    // Those containing "children", which are all kWords, as a phrase:
+    // consecutively, each word starting within a couple of bytes of
+    // where the one before it ends.
+    kPhrase,
+
+    // Those where, for each i, an occurrence of children[i] and one of
+    // children[i + 1] (all kWords) start within max_distances[i] bytes
+    // of each other, in either order.
+    kNear,
+
+    // Those matching every one of "children" and none of "excluded".
+    // With no children, nothing matches.
+    kAnd,
+
+    // Those matching any of "children".
+    kOr,
+  };
+
+  Kind kind;
+  std::string word;
+  std::vector<int64_t> max_distances;
+  std::vector<QueryNode> children;
+  std::vector<QueryNode> excluded;
+};
+
+// Parses the words of a query into a tree of QueryNodes.  Words are
+// matched in lower case, and juxtaposed terms must all match.  The
+// query may also use:
+//
+// - "quoted phrases", whose quotes are attached to their first and last
+//   words (as in "\"a", "b\"");
+// - "a NEAR/k b" (in any case), which requires words a and b to start
+//   within k bytes of each other, and may be chained ("a NEAR/k b
+//   NEAR/j c");
+// - "AND", "OR", and "NOT", which must be in upper case so that the
+//   words "and", "or", and "not" can still be searched for, where NOT
+//   binds tightest and OR loosest;
+// - parentheses, which may be attached to words like quotes; and
+// - "prefix*", which matches any word starting with "prefix", though
+//   only as a term of its own: within a phrase or NEAR, the "*" is
+//   taken literally.
+//
+// An operator with nothing to apply to, or inside a phrase, is taken as
+// a word; unbalanced parentheses and quotes are closed at the end of the
+// query, and empty ones are ignored.  NOT only excludes documents from
+// the terms it's juxtaposed with (even across parentheses, so "a (NOT
+// b)" is "a NOT b"), and a query or OR operand of nothing but NOTs
+// matches nothing.
+QueryNode ParseQuery(const std::vector<std::string>& query);
+
+}  // namespace hw3
+
+#endif  // HW3_QUERYPARSER_H_
@@ -11,173 +11,631 @@
 
 #include "./QueryProcessor.h"
 
+#include <climits>
+#include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 #include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "./BM25.h"
+#include "./QueryIterator.h"
+#include "./QueryParser.h"
+
 extern "C" {
   #include "./libhw1/CSE333.h"
 }
 
 using std::list;
+using std::lower_bound;
+using std::make_shared;
+using std::pair;
+using std::pop_heap;
+using std::push_heap;
+using std::shared_ptr;
 using std::sort;
+using std::sort_heap;
 using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::unordered_set;
 using std::vector;
 using std::cerr;
 using std::endl;
 
 namespace hw3 {
 
-QueryProcessor::QueryProcessor(const list<string>& index_list, bool validate) {
+// The docIDs of one index file's documents, sorted by a hash of their
+// names, so that a name can be looked up without reading every other.
+class QueryProcessor::DocNameIndex {
+ public:
+  explicit DocNameIndex(const DocTableView& doc_table) {
+    for (const auto& doc : doc_table.GetDocList()) {
+      entries_.push_back({std::hash<string>()(doc.second), doc.first});
+    }
+    sort(entries_.begin(), entries_.end());
+  }
+
+  // Returns the docID that "doc_table", this index's doctable, gives
+  // "name", or INVALID_DOCID if it has none.  Names whose hashes match
+  // are told apart by reading them.
+  DocID_t Lookup(const DocTableView& doc_table, const string& name) const {
+    size_t hash = std::hash<string>()(name);
+    auto it = lower_bound(entries_.begin(), entries_.end(),
+                          pair<size_t, DocID_t>(hash, 0));
+    for (; it != entries_.end() && it->first == hash; it++) {
+      string doc_name;
+      if (doc_table.LookupDocID(it->second, &doc_name) && doc_name == name) {
+        return it->second;
+      }
+    }
+    return INVALID_DOCID;
+  }
+
+ private:
+  vector<pair<size_t, DocID_t>> entries_;
+};
+
+QueryProcessor::QueryProcessor(const list<string>& index_list, bool validate,
+                               bool use_mmap, QueryWorkerPool* pool)
+  : pool_(pool), ranking_(kBM25) {
   // Stash away a copy of the index list.
   index_list_ = index_list;
   array_len_ = index_list_.size();
   Verify333(array_len_ > 0);
 
-  // Create the arrays of DocTableReader*'s. and IndexTableReader*'s.
-  dtr_array_ = new DocTableReader* [array_len_];
-  itr_array_ = new IndexTableReader* [array_len_];
+  // Open each index file, and view it.
+  for (const string& index_file : index_list_) {
+    sources_.push_back(OpenIndexFileSource(index_file, validate, use_mmap));
+  }
+  CreateViews();
+  name_indexes_.resize(array_len_);
+
+  // Work out which index file owns each document, walking the index
+  // files in order so the first one to list a name claims it.  Every
+  // later index file's docID for that name is shadowed.
+  unordered_set<string> owned_names;
+  for (int i = 0; i < array_len_; i++) {
+    auto shadowed = make_shared<unordered_set<DocID_t>>();
+    if (array_len_ > 1) {
+      for (const auto& doc : dtr_array_[i]->GetDocList()) {
+        if (!owned_names.insert(doc.second).second) {
+          shadowed->insert(doc.first);
+        }
+      }
+    }
+    shadowed_docs_.push_back(shadowed);
+  }
+}
+
+QueryProcessor::QueryProcessor(const list<string>& index_list,
+                               const QueryProcessor& previous,
+                               const unordered_set<string>& unchanged,
+                               bool validate, bool use_mmap,
+                               QueryWorkerPool* pool)
+  : pool_(pool), ranking_(previous.ranking_) {
+  index_list_ = index_list;
+  array_len_ = index_list_.size();
+  Verify333(array_len_ > 0);
+
+  // Share the unchanged index files that "previous" has open, noting
+  // where each was in its list, and open the rest.
+  unordered_map<string, int> previous_positions;
+  int j = 0;
+  for (const string& index_file : previous.index_list_) {
+    previous_positions[index_file] = j++;
+  }
+  vector<int> previous_position(array_len_, -1);
+  int i = 0;
+  for (const string& index_file : index_list_) {
+    auto it = previous_positions.find(index_file);
+    if (it != previous_positions.end() && unchanged.count(index_file) > 0) {
+      previous_position[i] = it->second;
+      sources_.push_back(previous.sources_[it->second]);
+      name_indexes_.push_back(previous.name_indexes_[it->second]);
+    } else {
+      sources_.push_back(OpenIndexFileSource(index_file, validate,
+                                             use_mmap));
+      name_indexes_.push_back(nullptr);
+    }
+    i++;
+  }
+  CreateViews();
+
+  // An index file's documents are shadowed by the names in the index
+  // files before it.  Each of those files' names is only read once.
+  vector<vector<string>> doc_names(array_len_);
+  vector<bool> have_doc_names(array_len_, false);
+  auto get_doc_names = [&](int k) -> const vector<string>& {
+    if (!have_doc_names[k]) {
+      for (auto& doc : dtr_array_[k]->GetDocList()) {
+        doc_names[k].push_back(std::move(doc.second));
+      }
+      have_doc_names[k] = true;
+    }
+    return doc_names[k];
+  };
+  for (i = 0; i < array_len_; i++) {
+    // Find which of the index files before this one are new to it.  If
+    // any that were before it in "previous" are gone, its shadowed
+    // documents are worked out afresh.
+    unordered_set<const IndexFileSource*> before;
+    for (int k = 0; k < i; k++) {
+      before.insert(sources_[k].get());
+    }
+    shared_ptr<const unordered_set<DocID_t>> previous_shadowed;
+    if (previous_position[i] >= 0) {
+      const int p = previous_position[i];
+      previous_shadowed = previous.shadowed_docs_[p];
+      for (int k = 0; k < p && previous_shadowed; k++) {
+        if (before.erase(previous.sources_[k].get()) == 0) {
+          previous_shadowed = nullptr;
+        }
+      }
+    }
+    if (previous_shadowed && before.empty()) {
+      shadowed_docs_.push_back(previous_shadowed);
+      continue;
+    }
+
+    auto shadowed = make_shared<unordered_set<DocID_t>>();
+    if (previous_shadowed) {
+      *shadowed = *previous_shadowed;
+    }
+    const DocNameIndex& name_index = GetNameIndex(i);
+    for (int k = 0; k < i; k++) {
+      if (previous_shadowed && before.count(sources_[k].get()) == 0) {
+        continue;
+      }
+      for (const string& name : get_doc_names(k)) {
+        DocID_t doc_id = name_index.Lookup(*dtr_array_[i], name);
+        if (doc_id != INVALID_DOCID) {
+          shadowed->insert(doc_id);
+        }
+      }
+    }
+    shadowed_docs_.push_back(shadowed);
+  }
+}
 
-  // Populate the arrays with heap-allocated DocTableReader and
-  // IndexTableReader object instances.
-  list<string>::const_iterator idx_iterator = index_list_.begin();
+void QueryProcessor::CreateViews() {
+  // Create the arrays of DocTableView*'s, IndexTableView*'s,
+  // DocStatsView*'s, and TermDictView*'s.
+  dtr_array_ = new DocTableView* [array_len_];
+  itr_array_ = new IndexTableView* [array_len_];
+  dsv_array_ = new DocStatsView* [array_len_];
+  tdv_array_ = new TermDictView* [array_len_];
+
+  // Populate the arrays with heap-allocated view object instances.  The
+  // views keep the IndexFileSource alive; it's closed when the last of
+  // them, and of the QueryProcessors sharing it, is deleted.
   for (int i = 0; i < array_len_; i++) {
-    FileIndexReader fir(*idx_iterator, validate);
-    dtr_array_[i] = fir.NewDocTableReader();
-    itr_array_[i] = fir.NewIndexTableReader();
-    idx_iterator++;
+    dtr_array_[i] = new DocTableView(sources_[i]);
+    itr_array_[i] = new IndexTableView(sources_[i]);
+    dsv_array_[i] = new DocStatsView(sources_[i]);
+    tdv_array_[i] = new TermDictView(sources_[i]);
+  }
+}
+
+const QueryProcessor::DocNameIndex& QueryProcessor::GetNameIndex(int i) {
+  if (!name_indexes_[i]) {
+    name_indexes_[i] = make_shared<const DocNameIndex>(*dtr_array_[i]);
   }
+  return *name_indexes_[i];
 }
 
 QueryProcessor::~QueryProcessor() {
-  // Delete the heap-allocated DocTableReader and IndexTableReader
-  // object instances.
+  // Delete the heap-allocated view object instances.
   Verify333(dtr_array_ != nullptr);
   Verify333(itr_array_ != nullptr);
+  Verify333(dsv_array_ != nullptr);
+  Verify333(tdv_array_ != nullptr);
   for (int i = 0; i < array_len_; i++) {
     delete dtr_array_[i];
     delete itr_array_[i];
+    delete dsv_array_[i];
+    delete tdv_array_[i];
   }
 
-  // Delete the arrays of DocTableReader*'s and IndexTableReader*'s.
+  // Delete the arrays of view pointers.
   delete[] dtr_array_;
   delete[] itr_array_;
+  delete[] dsv_array_;
+  delete[] tdv_array_;
   dtr_array_ = nullptr;
   itr_array_ = nullptr;
+  dsv_array_ = nullptr;
+  tdv_array_ = nullptr;
 }
 
-// This structure is used to store a index-file-specific query result.
+// Ranks can differ in their last bits depending on the order their
+// words' scores were added in, so we only give up on a document when its
+// bound falls short by more than this fraction.
+static const double kPruningSlack = 1e-9;
+
+// Compiles "node" into a QueryIterator over the index file whose views
+// are "index", "stats", and "dict", ranked by "ranking".  Returns nullptr
+// if no document in the index file can match.
+static unique_ptr<QueryIterator> CompileQuery(const QueryNode& node,
+  IndexTableView* index, const DocStatsView* stats, const TermDictView* dict,
+  QueryProcessor::Ranking ranking);
+
+// This structure is used to store a matching document while we pick out
+// the page of results to return.
 typedef struct {
-  DocID_t doc_id;  // The document ID within the index file.
-  int     rank;    // The rank of the result so far.
-} IdxQueryResult;
+  double  rank;    // The document's rank.
+  int     index;   // Which index file the document came from.
+  DocID_t doc_id;  // The document ID within that index file.
+} Candidate;
+
+// Orders candidates by descending rank.  Ties go to the earlier index
+// and then the smaller docID, so paging through the results is
+// deterministic.
+static bool RanksHigher(const Candidate& a, const Candidate& b) {
+  if (a.rank != b.rank) {
+    return a.rank > b.rank;
+  }
+  if (a.index != b.index) {
+    return a.index < b.index;
+  }
+  return a.doc_id < b.doc_id;
+}
+
+// Adds "candidate" to "heap", a heap of at most "limit" candidates whose
+// top is the lowest-ranked of them, if it ranks among the best "limit".
+static void OfferCandidate(const Candidate& candidate, size_t limit,
+                           vector<Candidate>* heap) {
+  if (heap->size() < limit) {
+    heap->push_back(candidate);
+    push_heap(heap->begin(), heap->end(), RanksHigher);
+  } else if (limit > 0 && RanksHigher(candidate, heap->front())) {
+    pop_heap(heap->begin(), heap->end(), RanksHigher);
+    heap->back() = candidate;
+    push_heap(heap->begin(), heap->end(), RanksHigher);
+  }
+}
 
-static vector<IdxQueryResult> ProcessSingleIndex(IndexTableReader* const 
-  idx_reader_arr[], int i, const vector<string>& query);
+// Returns the rank a candidate must beat to get into "heap", a heap of
+// at most "limit" candidates, or -HUGE_VAL if there's room.
+static double Threshold(const vector<Candidate>& heap, size_t limit) {
+  return (limit > 0 && heap.size() >= limit) ? heap.front().rank : -HUGE_VAL;
+}
 
-static void ProcessQueryWord(const DocIDTableReader* dtr, 
-  vector<IdxQueryResult>* index_query_res);
+// Runs "query" against index "i", ranked by "ranking", and offers each
+// match that index owns to "candidates" (see OfferCandidate()).  If
+// "prune" is true, skips matches that can't make the best "limit"
+// candidates.  Returns the number of matches offered.
+static int CollectCandidates(IndexTableView* const idx_reader_arr[],
+  DocStatsView* const stats_arr[], TermDictView* const dict_arr[], int i,
+  QueryProcessor::Ranking ranking,
+  const unordered_set<DocID_t>& shadowed, const QueryNode& query,
+  size_t limit, bool prune, vector<Candidate>* candidates);
 
 vector<QueryProcessor::QueryResult>
 QueryProcessor::ProcessQuery(const vector<string>& query) const {
-  Verify333(query.size() > 0);
+  return ProcessQuery(query, INT_MAX, 0);
+}
 
-  // STEP 1.
-  // (the only step in this file)
-  vector<QueryProcessor::QueryResult> final_result;
+vector<QueryProcessor::QueryResult>
+QueryProcessor::ProcessQuery(const vector<string>& query, int k, int offset,
+                             int* const total_results) const {
+  Verify333(query.size() > 0);
+  Verify333(k >= 0);
+  Verify333(offset >= 0);
+  if (total_results != nullptr) {
+    *total_results = 0;
+  }
 
-  for (int i = 0; i < array_len_; i++) {
-    if (!itr_array_[i]) {
-      cerr << "IndexTableReader is null for index " << i << endl;
-      continue;
+  // Parse the query once; each index file compiles the parse tree into
+  // its own QueryIterators.
+  const QueryNode parsed_query = ParseQuery(query);
+
+  // We keep the best "offset + k" candidates seen so far in a heap whose
+  // top is the worst of them, so each later candidate costs at most one
+  // comparison plus a log-sized heap update.
+  const size_t limit = static_cast<size_t>(offset) + k;
+  const bool prune = (total_results == nullptr);
+  vector<Candidate> heap;
+  int num_matches = 0;
+
+  if (pool_ == nullptr || array_len_ == 1) {
+    // Process the indices one after another, straight into "heap", so
+    // each index is pruned against the best of the ones before it.
+    for (int i = 0; i < array_len_; i++) {
+      num_matches += CollectCandidates(itr_array_, dsv_array_, tdv_array_,
+                                       i, ranking_, *shadowed_docs_[i],
+                                       parsed_query, limit, prune, &heap);
     }
+  } else {
+    // Process every index at once on the worker pool, each into its own
+    // heap, and then merge the heaps.  An index's best "limit" candidates
+    // include any of its documents that make the overall best "limit".
+    vector<vector<Candidate>> index_heaps(array_len_);
+    vector<int> index_matches(array_len_);
+    pool_->RunParallel(array_len_, [&](int i) {
+      index_matches[i] = CollectCandidates(itr_array_, dsv_array_,
+                                           tdv_array_, i, ranking_,
+                                           *shadowed_docs_[i], parsed_query,
+                                           limit, prune, &index_heaps[i]);
+    });
+    for (int i = 0; i < array_len_; i++) {
+      num_matches += index_matches[i];
+      for (const Candidate& candidate : index_heaps[i]) {
+        OfferCandidate(candidate, limit, &heap);
+      }
+    }
+  }
+  if (total_results != nullptr) {
+    *total_results = num_matches;
+  }
+
+  // Put the survivors in order, skip the first "offset" of them, and look
+  // up the names of the rest.
+  sort_heap(heap.begin(), heap.end(), RanksHigher);
+  vector<QueryProcessor::QueryResult> final_result;
+  for (size_t j = offset; j < heap.size(); j++) {
+    const Candidate& candidate = heap[j];
+    string filename;
+    Verify333(dtr_array_[candidate.index]->LookupDocID(candidate.doc_id,
+                                                       &filename));
+    final_result.push_back({filename, candidate.rank});
+  }
+  return final_result;
+}
 
-    vector<IdxQueryResult> q_query;
-    q_query = ProcessSingleIndex(itr_array_, i, query);
+static int CollectCandidates(IndexTableView* const idx_reader_arr[],
+  DocStatsView* const stats_arr[], TermDictView* const dict_arr[], int i,
+  QueryProcessor::Ranking ranking,
+  const unordered_set<DocID_t>& shadowed, const QueryNode& query,
+  size_t limit, bool prune, vector<Candidate>* candidates) {
+  if (!idx_reader_arr[i]) {
+    cerr << "IndexTableView is null for index " << i << endl;
+    return 0;
+  }
 
-    for (const IdxQueryResult & res : q_query) {
-      string filename;
+  unique_ptr<QueryIterator> root =
+      CompileQuery(query, idx_reader_arr[i], stats_arr[i], dict_arr[i],
+                   ranking);
+  if (root == nullptr) {
+    return 0;
+  }
 
-      Verify333(dtr_array_[i]->LookupDocID(res.doc_id, &filename));
+  // Pruning relies on the BM25 score bounds that the posting lists
+  // record.
+  prune = prune && ranking == QueryProcessor::kBM25;
+  auto min_score = [&]() {
+    if (!prune) {
+      return -HUGE_VAL;
+    }
+    double threshold = Threshold(*candidates, limit);
+    return threshold - kPruningSlack * std::fabs(threshold);
+  };
+  if (root->max_score() < min_score()) {
+    // Nothing in this index can make the cut.
+    return 0;
+  }
 
-      bool found = false;
-      for (const auto& curr_res : final_result) {
-        if (curr_res.document_name == filename) {
-          found = true;
+  // Score one match at a time, so that each one raises the bar for the
+  // matches after it.  Before the iterators decode any of the blocks
+  // that would hold the next match, we check whether their max_tf_scores
+  // let any document up to "blocks_end", which all of the blocks span,
+  // make the cut; if not, that whole run of documents is skipped.  The
+  // iterators are also told the bar, so they can give up on individual
+  // documents early.
+  const DocID_t last_doc_id = std::numeric_limits<DocID_t>::max();
+  DocID_t target = 0, blocks_end = 0;
+  double block_bound = 0;
+  bool have_bound = false;
+  int num_matches = 0;
+  while (true) {
+    if (prune) {
+      if (!have_bound || target > blocks_end) {
+        block_bound = root->BlockMaxScore(target, &blocks_end);
+        have_bound = true;
+      }
+      if (block_bound < min_score()) {
+        if (blocks_end == last_doc_id) {
           break;
         }
+        target = blocks_end + 1;
+        continue;
       }
-      if (!found) {
-        final_result.push_back({filename, res.rank});
-      }
     }
+    if (!root->Seek(target, min_score())) {
+      break;
+    }
+    const DocID_t doc_id = root->doc_id();
+    if (prune && doc_id > blocks_end) {
+      // The match lies beyond the run we bounded, so bound its run
+      // before scoring it.
+      target = doc_id;
+      continue;
+    }
+    target = doc_id + 1;
+    if (!shadowed.empty() && shadowed.count(doc_id) > 0) {
+      continue;
+    }
+    num_matches++;
+    OfferCandidate({root->Score(), i, doc_id}, limit, candidates);
   }
-  // Sort the final results.
-  sort(final_result.begin(), final_result.end());
-  return final_result;
+  return num_matches;
 }
 
-static vector<IdxQueryResult> ProcessSingleIndex(IndexTableReader* const 
-  idx_reader_arr[], int i, const vector<string>& query) {
-
-  std::cout << "Processing index: " << i << " for word: " << query[0] << 
-    std::endl;
-
-  const DocIDTableReader* doc_id_reader = idx_reader_arr[i]->LookupWord
-  (query[0]);
-
-  vector<IdxQueryResult> idx_reader_list;
-
-  if (!doc_id_reader) {
-    std::cout << "Word not found in index: " << query[0] << std::endl;
-    return idx_reader_list;
+// Returns a TermIterator over "postings", which it takes ownership of,
+// or nullptr if "postings" is nullptr.
+static unique_ptr<TermIterator> CompilePostings(PostingsView* postings,
+  const DocStatsView* stats, QueryProcessor::Ranking ranking) {
+  if (postings == nullptr) {
+    return nullptr;
   }
-
-list<DocIDElementHeader> doc_header_list = doc_id_reader->GetDocIDList();
-
-for (const DocIDElementHeader& doc_header : doc_header_list) {
-  idx_reader_list.push_back({doc_header.doc_id, doc_header.num_positions});
+  double idf = BM25InverseDocFrequency(postings->num_docs(),
+                                       stats->num_docs());
+  return unique_ptr<TermIterator>(new TermIterator(
+      unique_ptr<PostingsView>(postings), idf,
+      (ranking == QueryProcessor::kBM25) ? stats : nullptr));
 }
 
-delete doc_id_reader;
-
-if (query.size() <= 1) {
-  return idx_reader_list;
+// Looks up "word" in "index", returning nullptr if it's missing.
+static unique_ptr<TermIterator> CompileWord(const string& word,
+  IndexTableView* index, const DocStatsView* stats,
+  QueryProcessor::Ranking ranking) {
+  return CompilePostings(index->LookupWord(word), stats, ranking);
 }
 
-size_t idx = 1;
-
-while(idx < query.size()) {
-  DocIDTableReader* doc_id_reader = idx_reader_arr[i]->LookupWord(query[idx]);
-
-  if (!doc_id_reader) {
-    idx_reader_list.clear();
-    break;
+// Returns an OR of the words that start with "prefix", or nullptr if
+// there are none.
+static unique_ptr<QueryIterator> CompilePrefix(const string& prefix,
+  IndexTableView* index, const DocStatsView* stats, const TermDictView* dict,
+  QueryProcessor::Ranking ranking) {
+  // The term dictionary already knows the words' elements.  Usually
+  // there are few enough of them to walk side by side.
+  const string end = TermDictView::PrefixEnd(prefix);
+  vector<TermDictView::Term> terms;
+  bool complete = dict->GetRange(prefix, end,
+                                 QueryProcessor::kMaxPrefixTerms, &terms);
+  if (complete) {
+    vector<unique_ptr<QueryIterator>> children;
+    for (const TermDictView::Term& term : terms) {
+      unique_ptr<QueryIterator> itr = CompilePostings(
+          index->LookupElement(term.second), stats, ranking);
+      if (itr != nullptr) {
+        children.push_back(std::move(itr));
+      }
+    }
+    if (children.empty()) {
+      return nullptr;
+    }
+    if (children.size() == 1) {
+      return std::move(children[0]);
+    }
+    return unique_ptr<QueryIterator>(new OrIterator(std::move(children)));
   }
 
-  ProcessQueryWord(doc_id_reader, &idx_reader_list);
-
-  delete doc_id_reader;
-  idx++;
+  // Otherwise, rank the union a page of words at a time, summing each
+  // document's ranks as an OrIterator would.  The words are contiguous
+  // in the dictionary, so each page picks up just after the last word
+  // of the one before it.
+  unordered_map<DocID_t, double> scores;
+  while (true) {
+    for (const TermDictView::Term& term : terms) {
+      unique_ptr<QueryIterator> itr = CompilePostings(
+          index->LookupElement(term.second), stats, ranking);
+      if (itr == nullptr) {
+        continue;
+      }
+      for (DocID_t doc_id = 0; itr->Seek(doc_id, -HUGE_VAL);
+           doc_id = itr->doc_id() + 1) {
+        scores[itr->doc_id()] += itr->Score();
+      }
+    }
+    if (complete) {
+      break;
+    }
+    // A word followed by a NUL is the first string after it.
+    complete = dict->GetRange(terms.back().first + '\0', end,
+                              QueryProcessor::kMaxPrefixTerms, &terms);
   }
-  return idx_reader_list;
+  vector<ScoredDocsIterator::ScoredDoc> docs(scores.begin(), scores.end());
+  sort(docs.begin(), docs.end());
+  if (docs.empty()) {
+    return nullptr;
+  }
+  return unique_ptr<QueryIterator>(new ScoredDocsIterator(std::move(docs)));
 }
 
-static void ProcessQueryWord(const DocIDTableReader* doc_table_reader, 
-                    vector<IdxQueryResult>* index_query_res) {
-  list<DocPositionOffset_t> doc_pos_offsest;
-  auto iter = index_query_res->begin();
-  while (iter != index_query_res->end()) {
-    if (doc_table_reader->LookupDocID(iter->doc_id, &doc_pos_offsest)) {
-      iter->rank += doc_pos_offsest.size();
-      ++iter;
-    } else {
-      iter = index_query_res->erase(iter);
+static unique_ptr<QueryIterator> CompileQuery(const QueryNode& node,
+  IndexTableView* index, const DocStatsView* stats, const TermDictView* dict,
+  QueryProcessor::Ranking ranking) {
+  switch (node.kind) {
+    case QueryNode::kWord:
+      return CompileWord(node.word, index, stats, ranking);
+
+    case QueryNode::kPrefix:
+      return CompilePrefix(node.word, index, stats, dict, ranking);
+
+    case QueryNode::kPhrase:
+    case QueryNode::kNear: {
+      // Every word must be present.
+      vector<unique_ptr<TermIterator>> words;
+      for (const QueryNode& child : node.children) {
+        unique_ptr<TermIterator> word =
+            CompileWord(child.word, index, stats, ranking);
+        if (word == nullptr) {
+          return nullptr;
+        }
+        words.push_back(std::move(word));
+      }
+      if (node.kind == QueryNode::kPhrase) {
+        vector<int64_t> lengths;
+        for (const QueryNode& child : node.children) {
+          lengths.push_back(child.word.size());
+        }
+        return unique_ptr<QueryIterator>(
+            new PhraseIterator(std::move(words), lengths));
+      }
+      vector<bool> same_word;
+      for (size_t j = 0; j + 1 < node.children.size(); j++) {
+        same_word.push_back(node.children[j].word
+                            == node.children[j + 1].word);
+      }
+      return unique_ptr<QueryIterator>(
+          new NearIterator(std::move(words), node.max_distances, same_word));
+    }
+
+    case QueryNode::kAnd: {
+      // A child that can't match sinks the whole AND, but an exclusion
+      // that can't match excludes nothing.
+      vector<unique_ptr<QueryIterator>> children, excluded;
+      for (const QueryNode& child : node.children) {
+        unique_ptr<QueryIterator> itr =
+            CompileQuery(child, index, stats, dict, ranking);
+        if (itr == nullptr) {
+          return nullptr;
+        }
+        children.push_back(std::move(itr));
+      }
+      if (children.empty()) {
+        return nullptr;
+      }
+      for (const QueryNode& child : node.excluded) {
+        unique_ptr<QueryIterator> itr =
+            CompileQuery(child, index, stats, dict, ranking);
+        if (itr != nullptr) {
+          excluded.push_back(std::move(itr));
+        }
+      }
+      if (children.size() == 1 && excluded.empty()) {
+        return std::move(children[0]);
+      }
+      return unique_ptr<QueryIterator>(
+          new AndIterator(std::move(children), std::move(excluded)));
+    }
+
+    case QueryNode::kOr: {
+      vector<unique_ptr<QueryIterator>> children;
+      for (const QueryNode& child : node.children) {
+        unique_ptr<QueryIterator> itr =
+            CompileQuery(child, index, stats, dict, ranking);
+        if (itr != nullptr) {
+          children.push_back(std::move(itr));
+        }
+      }
+      if (children.empty()) {
+        return nullptr;
+      }
+      if (children.size() == 1) {
+        return std::move(children[0]);
+      }
+      return unique_ptr<QueryIterator>(new OrIterator(std::move(children)));
     }
   }
+  return nullptr;
 }
 
-
 }  // namespace hw3
@@ -13,66 +13,193 @@
 #define HW3_QUERYPROCESSOR_H_
 
 #include <list>
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
-#include "./DocIDTableReader.h"
-#include "./DocTableReader.h"
-#include "./FileIndexReader.h"
-#include "./IndexTableReader.h"
+#include "./DocStatsView.h"
+#include "./DocTableView.h"
+#include "./IndexFileSource.h"
+#include "./IndexTableView.h"
+#include "./PostingsView.h"
+#include "./QueryWorkerPool.h"
+#include "./TermDictView.h"
 #include "./Utils.h"
 
 using std::list;
 using std::string;
+using std::unordered_set;
 using std::vector;
 
 namespace hw3 {
 
 // A QueryProcessor is a class that is given a set of names of index
-// files, and uses the various FileIndexReader and HashTableReader
-// classes to process queries against the indices.
+// files, and uses the IndexFileSource and HashTableView classes to
+// process queries against the indices.  Each index file is opened (and
+// by default memory-mapped) once, when the QueryProcessor is
+// constructed.
+//
+// A document is identified by its name, and the same document may be
+// listed in more than one of the index files (say, an old and a new
+// index of overlapping directories).  Its ranks are not combined: the
+// first index file in the list that contains the document owns it, so
+// the document's rank is its rank within that index file, and its
+// entries in later index files are ignored, even when only a later
+// entry matches the query.
 class QueryProcessor {
  public:
-  // Construct a QueryProcessor.
+  // Construct a QueryProcessor, which ranks results by BM25.
   //
   // Arguments:
   // - indexlist: a list<string> containing a list of index
   //   file names that the QueryProcessor should use.
   // - validate: a bool indicating whether or not to validate the
   //   checksums in the index files.  Defaults to true.
-  explicit QueryProcessor(const list<string>& index_list, bool validate=true);
+  // - use_mmap: a bool indicating whether to memory-map the index files
+  //   (true) or to read them with pread() through one shared descriptor
+  //   per file (false).  Defaults to true.
+  // - pool: if not nullptr, queries against more than one index file
+  //   process the index files concurrently on this worker pool, which
+  //   must outlive the QueryProcessor (and may be shared with others).
+  //   Defaults to nullptr, which processes them one after another on
+  //   the calling thread.
+  explicit QueryProcessor(const list<string>& index_list, bool validate=true,
+                          bool use_mmap=true, QueryWorkerPool* pool=nullptr);
+
+  // Construct a QueryProcessor for "index_list" that shares what it can
+  // with "previous", a QueryProcessor of an earlier version of the same
+  // index files (see ReloadingQueryProcessor.h), and ranks as it does.
+  //
+  // Each index file named in "unchanged" that "previous" has open is
+  // shared rather than opened again.  So is what "previous" knows of
+  // which of its documents are shadowed, if the index files before it
+  // then are still before it now: only the names of the documents in
+  // index files that have been added in front of it are looked up.
+  // Otherwise, the names in every index file before it are, which still
+  // spares reading every name in it.  The other arguments are as above.
+  QueryProcessor(const list<string>& index_list,
+                 const QueryProcessor& previous,
+                 const unordered_set<string>& unchanged, bool validate=true,
+                 bool use_mmap=true, QueryWorkerPool* pool=nullptr);
 
   // The destructor.
   ~QueryProcessor();
 
-  // This structure defines a single query result.  As with HW2,
-  // the rank of a query result is the sum of the number of occurrences
-  // of query words within the document.
+  // The most words a prefix in a query expands to within an index file
+  // before its matches are ranked up front, a page of words at a time,
+  // instead of by walking the words' posting lists side by side.
+  static constexpr int kMaxPrefixTerms = 1024;
+
+  // How query results are ranked.
+  enum Ranking {
+    // The document's Okapi BM25 score (see BM25.h) against the query
+    // words, computed from its index file's statistics alone.  This is
+    // the default.
+    kBM25,
+
+    // As with HW2, the sum of the number of occurrences of query words
+    // within the document.
+    kOccurrenceCount,
+  };
+
+  // Chooses how query results are ranked.  Must not be called while a
+  // query is in progress.
+  void set_ranking(Ranking ranking) { ranking_ = ranking; }
+  Ranking ranking() const { return ranking_; }
+
+  // This structure defines a single query result.
   class QueryResult {
    public:
     bool operator<(const QueryResult& rhs) const { return rank > rhs.rank; }
 
     string document_name;  // The name of a matching document.
-    int    rank;           // The rank of the matching document.
+    double rank;           // The rank of the matching document.
   };
 
   // This method processes a query against the indices and returns a
   // vector of QueryResults, sorted in descending order of rank.  If no
   // documents match the query, then a valid but empty vector will be
-  // returned.
+  // returned.  The query's words are parsed by ParseQuery() (see
+  // QueryParser.h), so they may combine terms with AND, OR, NOT,
+  // parentheses, phrases, NEAR/k, and prefixes.  A prefix matches as
+  // though all of its words were ORed together.
+  //
+  // ProcessQuery() only performs positional reads against the index
+  // files, so a single QueryProcessor may be shared by many threads
+  // calling it concurrently.
   vector<QueryResult> ProcessQuery(const vector<string>& query) const;
 
+  // Like ProcessQuery(), but only returns one page of the results: the
+  // (up to) "k" results that would start at position "offset" of
+  // ProcessQuery()'s vector.  Rather than sorting every match, this keeps
+  // just the best "offset + k" in a bounded heap, and only looks up the
+  // names of the documents it returns.
+  //
+  // Arguments:
+  // - query: the query words, as for ProcessQuery().
+  // - k: the maximum number of results to return; must be >= 0.
+  // - offset: how many of the best results to skip; must be >= 0.
+  // - total_results: if not nullptr, set to the total number of
+  //   matching documents, so callers can tell how many pages there are
+  //   (an output parameter).
+  //
+  // Results with equal rank are ordered by index file, and then by docID
+  // within an index file, so consecutive pages neither overlap nor skip
+  // results.
+  //
+  // When ranking by BM25 and "total_results" is nullptr, documents are
+  // scored one at a time, and a document is abandoned (or a whole index
+  // file skipped) as soon as each word's max_tf_score shows that it can't
+  // outrank the worst of the best "offset + k" found so far.  Counting
+  // every match rules that out, so asking for "total_results" costs more.
+  vector<QueryResult> ProcessQuery(const vector<string>& query, int k,
+                                   int offset,
+                                   int* const total_results = nullptr) const;
+
  protected:
   // The list of index files we process.
   list<string> index_list_;
 
-  // The arrays of pointers to DocTableReader and IndexTableReader
-  // objects.
-  int                 array_len_;
-  DocTableReader**    dtr_array_;
-  IndexTableReader**  itr_array_;
+  // The arrays of pointers to DocTableView, IndexTableView,
+  // DocStatsView, and TermDictView objects.  Each index file's views
+  // share its IndexFileSource.
+  int               array_len_;
+  DocTableView**    dtr_array_;
+  IndexTableView**  itr_array_;
+  DocStatsView**    dsv_array_;
+  TermDictView**    tdv_array_;
+
+  // Each index file's IndexFileSource, which a later QueryProcessor may
+  // share (see above).
+  vector<std::shared_ptr<const IndexFileSource>> sources_;
+
+  // For each index file, the docIDs of the documents that an earlier
+  // index file owns (see above), which queries skip.  Computed once, at
+  // construction, so that queries never need to look up the names of
+  // documents they don't return.  Never nullptr; a later QueryProcessor
+  // may share them.
+  vector<std::shared_ptr<const unordered_set<DocID_t>>> shadowed_docs_;
+
+  // For each index file, its docIDs by a hash of their names (see
+  // QueryProcessor.cc), if a QueryProcessor has needed to look names up
+  // in it.  Built once, and then shared with later QueryProcessors.
+  class DocNameIndex;
+  vector<std::shared_ptr<const DocNameIndex>> name_indexes_;
+
+  // The worker pool that queries fan out to, if any.  Not owned.
+  QueryWorkerPool* pool_;
+
+  Ranking ranking_;
 
  private:
+  // Allocates the view arrays, and fills them in with views of the
+  // index files in "sources_".
+  void CreateViews();
+
+  // Returns the DocNameIndex of index file "i", building it if need be.
+  const DocNameIndex& GetNameIndex(int i);
+
   DISALLOW_COPY_AND_ASSIGN(QueryProcessor);
 };
 
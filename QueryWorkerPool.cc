@@ -0,0 +1,137 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./QueryWorkerPool.h"
+
+#include <pthread.h>   // for pthread_create(), etc.
+#include <functional>  // for std::function.
+#include <list>        // for std::list.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+
+using std::function;
+
+namespace hw3 {
+
+QueryWorkerPool::QueryWorkerPool(int num_threads)
+  : shutting_down_(false), num_threads_(num_threads) {
+  Verify333(num_threads_ > 0);
+  Verify333(pthread_mutex_init(&lock_, nullptr) == 0);
+  Verify333(pthread_cond_init(&work_queued_, nullptr) == 0);
+  Verify333(pthread_cond_init(&batch_finished_, nullptr) == 0);
+
+  threads_ = new pthread_t[num_threads_];
+  for (int i = 0; i < num_threads_; i++) {
+    Verify333(pthread_create(&threads_[i], nullptr, &WorkerMain, this) == 0);
+  }
+}
+
+QueryWorkerPool::~QueryWorkerPool() {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  Verify333(queue_.empty());
+  shutting_down_ = true;
+  Verify333(pthread_cond_broadcast(&work_queued_) == 0);
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+
+  for (int i = 0; i < num_threads_; i++) {
+    Verify333(pthread_join(threads_[i], nullptr) == 0);
+  }
+  delete[] threads_;
+
+  pthread_cond_destroy(&batch_finished_);
+  pthread_cond_destroy(&work_queued_);
+  pthread_mutex_destroy(&lock_);
+}
+
+void QueryWorkerPool::RunParallel(int num_tasks,
+                                  const function<void(int)>& fn) {
+  if (num_tasks <= 0) {
+    return;
+  }
+
+  // The batch lives on our stack; it's off the queue (and nobody else
+  // touches it) by the time we return.
+  Batch batch = {&fn, num_tasks, 0, 0};
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  queue_.push_back(&batch);
+  Verify333(pthread_cond_broadcast(&work_queued_) == 0);
+
+  // Rather than sit idle, help out with our own batch until all of its
+  // tasks have been handed out.
+  while (batch.next_task < batch.num_tasks) {
+    Batch* claimed = &batch;
+    int task = batch.next_task++;
+    if (batch.next_task == batch.num_tasks) {
+      queue_.remove(&batch);
+    }
+    Verify333(pthread_mutex_unlock(&lock_) == 0);
+    RunTask(claimed, task);
+    Verify333(pthread_mutex_lock(&lock_) == 0);
+  }
+
+  // Then wait for the tasks the workers took to finish.
+  while (batch.num_finished < batch.num_tasks) {
+    Verify333(pthread_cond_wait(&batch_finished_, &lock_) == 0);
+  }
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+}
+
+void* QueryWorkerPool::WorkerMain(void* arg) {
+  QueryWorkerPool* pool = static_cast<QueryWorkerPool*>(arg);
+
+  Verify333(pthread_mutex_lock(&pool->lock_) == 0);
+  while (true) {
+    Batch* batch;
+    int task;
+    if (pool->ClaimTask(&batch, &task)) {
+      Verify333(pthread_mutex_unlock(&pool->lock_) == 0);
+      pool->RunTask(batch, task);
+      Verify333(pthread_mutex_lock(&pool->lock_) == 0);
+      continue;
+    }
+    if (pool->shutting_down_) {
+      break;
+    }
+    Verify333(pthread_cond_wait(&pool->work_queued_, &pool->lock_) == 0);
+  }
+  Verify333(pthread_mutex_unlock(&pool->lock_) == 0);
+  return nullptr;
+}
+
+bool QueryWorkerPool::ClaimTask(Batch** batch, int* task) {
+  if (queue_.empty()) {
+    return false;
+  }
+
+  // Batches leave the queue as soon as their last task is handed out, so
+  // the oldest one always has a task left.
+  *batch = queue_.front();
+  *task = (*batch)->next_task++;
+  if ((*batch)->next_task == (*batch)->num_tasks) {
+    queue_.pop_front();
+  }
+  return true;
+}
+
+void QueryWorkerPool::RunTask(Batch* batch, int task) {
+  (*batch->fn)(task);
+
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  batch->num_finished++;
+  if (batch->num_finished == batch->num_tasks) {
+    Verify333(pthread_cond_broadcast(&batch_finished_) == 0);
+  }
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+}
+
+}  // namespace hw3
@@ -0,0 +1,81 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_QUERYWORKERPOOL_H_
+#define HW3_QUERYWORKERPOOL_H_
+
+#include <pthread.h>   // for pthread_t, pthread_mutex_t, etc.
+#include <functional>  // for std::function.
+#include <list>        // for std::list.
+
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A QueryWorkerPool is a fixed set of threads that a QueryProcessor can
+// fan the per-index work of a query out to.  The threads are started
+// once, when the pool is constructed, and are shared by every query
+// (and every QueryProcessor) that uses the pool, so queries never pay
+// to spawn threads.
+//
+// Any number of threads may call RunParallel() at once; their batches
+// are served in the order they arrive.
+class QueryWorkerPool {
+ public:
+  // Start "num_threads" worker threads; must be > 0.
+  explicit QueryWorkerPool(int num_threads);
+
+  // Stop and join the worker threads.  No RunParallel() may be in
+  // progress.
+  ~QueryWorkerPool();
+
+  // Call fn(0), fn(1), ..., fn(num_tasks - 1), spreading the calls over
+  // the pool's threads and the calling thread, and return once all of
+  // them have returned.  "fn" must be safe to call concurrently.
+  void RunParallel(int num_tasks, const std::function<void(int)>& fn);
+
+ private:
+  // One RunParallel() call's worth of work.
+  struct Batch {
+    const std::function<void(int)>* fn;
+    int num_tasks;
+    int next_task;     // the next task to hand out
+    int num_finished;  // how many tasks have returned
+  };
+
+  // The worker threads' main loop.
+  static void* WorkerMain(void* arg);
+
+  // Claim the next task of the oldest batch that has one left.  Must be
+  // called with lock_ held; returns false if there are none.
+  bool ClaimTask(Batch** batch, int* task);
+
+  // Run "task" of "batch", and report it finished.  Must be called
+  // without lock_ held.
+  void RunTask(Batch* batch, int task);
+
+  pthread_mutex_t lock_;
+  pthread_cond_t work_queued_;     // signaled when batches arrive
+  pthread_cond_t batch_finished_;  // signaled when a batch completes
+
+  // The batches that still have tasks to hand out, oldest first.
+  std::list<Batch*> queue_;
+  bool shutting_down_;
+
+  int num_threads_;
+  pthread_t* threads_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueryWorkerPool);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_QUERYWORKERPOOL_H_
@@ -0,0 +1,145 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./ReloadingQueryProcessor.h"
+
+#include <pthread.h>      // for pthread_mutex_lock(), etc.
+#include <sys/stat.h>     // for stat().
+#include <time.h>         // for time().
+#include <list>           // for std::list.
+#include <memory>         // for std::shared_ptr, std::make_shared().
+#include <string>         // for std::string.
+#include <unordered_map>  // for std::unordered_map.
+#include <unordered_set>  // for std::unordered_set.
+#include <vector>         // for std::vector.
+
+extern "C" {
+  #include "libhw1/CSE333.h"
+}
+#include "./IncrementalIndex.h"
+
+using std::list;
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+namespace hw3 {
+
+ReloadingQueryProcessor::ReloadingQueryProcessor(
+    const list<string>& index_list, bool validate, bool use_mmap,
+    QueryWorkerPool* pool, int check_interval)
+  : index_list_(index_list), validate_(validate), use_mmap_(use_mmap),
+    pool_(pool), check_interval_(check_interval), last_check_(time(nullptr)),
+    reloading_(false) {
+  Verify333(pthread_mutex_init(&lock_, nullptr) == 0);
+  segments_ = ListSegments(&versions_);
+  current_ = make_shared<const QueryProcessor>(segments_, validate_,
+                                               use_mmap_, pool_);
+}
+
+ReloadingQueryProcessor::~ReloadingQueryProcessor() {
+  pthread_mutex_destroy(&lock_);
+}
+
+shared_ptr<const QueryProcessor> ReloadingQueryProcessor::Get() {
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  shared_ptr<const QueryProcessor> current = current_;
+  time_t now = time(nullptr);
+  bool check = !reloading_ && now - last_check_ >= check_interval_;
+  if (check) {
+    last_check_ = now;
+    reloading_ = true;
+  }
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  if (!check) {
+    return current;
+  }
+
+  // Load the new files without holding the lock, so that other threads'
+  // queries go ahead against the old ones meanwhile.  If a file changes
+  // again while we're opening it, we may load a newer version than we
+  // noted, which just costs an extra reload later.
+  vector<FileVersion> versions;
+  list<string> segments = ListSegments(&versions);
+  unordered_set<string> unchanged;
+  bool changed;
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  changed = segments != segments_ || versions != versions_;
+  if (changed) {
+    unordered_map<string, FileVersion> old_versions;
+    auto version = versions_.begin();
+    for (const string& segment : segments_) {
+      old_versions.emplace(segment, *version++);
+    }
+    version = versions.begin();
+    for (const string& segment : segments) {
+      auto old_version = old_versions.find(segment);
+      if (version->exists && old_version != old_versions.end()
+          && old_version->second == *version) {
+        unchanged.insert(segment);
+      }
+      version++;
+    }
+  } else {
+    reloading_ = false;
+  }
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  if (!changed) {
+    return current;
+  }
+
+  current = make_shared<const QueryProcessor>(segments, *current, unchanged,
+                                              validate_, use_mmap_, pool_);
+  Verify333(pthread_mutex_lock(&lock_) == 0);
+  current_ = current;
+  segments_ = segments;
+  versions_ = versions;
+  reloading_ = false;
+  Verify333(pthread_mutex_unlock(&lock_) == 0);
+  return current;
+}
+
+bool ReloadingQueryProcessor::FileVersion::operator==(
+    const FileVersion& other) const {
+  if (!exists || !other.exists) {
+    return exists == other.exists;
+  }
+  return dev == other.dev && inode == other.inode
+      && mtime_ns == other.mtime_ns && size == other.size;
+}
+
+list<string> ReloadingQueryProcessor::ListSegments(
+    vector<FileVersion>* versions) const {
+  list<string> segments;
+  for (const string& index : index_list_) {
+    segments.splice(segments.end(), IndexSegments(index));
+  }
+  versions->clear();
+  for (const string& segment : segments) {
+    FileVersion version = FileVersion();
+    struct stat st;
+    if (stat(segment.c_str(), &st) == 0) {
+      version.exists = true;
+      version.dev = st.st_dev;
+      version.inode = st.st_ino;
+      version.mtime_ns = st.st_mtim.tv_sec * INT64_C(1000000000)
+                         + st.st_mtim.tv_nsec;
+      version.size = st.st_size;
+    }
+    versions->push_back(version);
+  }
+  return segments;
+}
+
+}  // namespace hw3
@@ -0,0 +1,99 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_RELOADINGQUERYPROCESSOR_H_
+#define HW3_RELOADINGQUERYPROCESSOR_H_
+
+#include <pthread.h>    // for pthread_mutex_t.
+#include <stdint.h>     // for int64_t.
+#include <sys/types.h>  // for dev_t, ino_t, off_t.
+#include <time.h>       // for time_t.
+#include <list>         // for std::list.
+#include <memory>       // for std::shared_ptr.
+#include <string>       // for std::string.
+#include <vector>       // for std::vector.
+
+#include "./QueryProcessor.h"
+#include "./QueryWorkerPool.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A ReloadingQueryProcessor serves queries against a set of indices that
+// may be updated while it runs, as updateindex (see IncrementalIndex.h)
+// updates them.  Each index is searched along with its delta and batch
+// segments, as IndexSegments() lists them.  Whenever that list changes,
+// or one of its files has been replaced since it was loaded, the first
+// query to notice loads a new QueryProcessor, while queries on other
+// threads carry on with the old one.  It stays loaded until the last
+// query using it is done.
+//
+// The new QueryProcessor shares the files that haven't changed with the
+// old one (see QueryProcessor.h), so publishing a small batch segment
+// costs a reload little more than opening it.
+//
+// The files must be replaced by renaming new copies over them, as
+// updateindex does, rather than rewritten in place, and not removed while
+// they're listed.  Get() may be called from any number of threads at
+// once.
+class ReloadingQueryProcessor {
+ public:
+  // Load "index_list", the base index files, and their other segments.
+  // The other arguments are as for QueryProcessor.  The files are checked
+  // for updates at most once every "check_interval" seconds.
+  ReloadingQueryProcessor(const std::list<std::string>& index_list,
+                          bool validate, bool use_mmap, QueryWorkerPool* pool,
+                          int check_interval = 1);
+
+  ~ReloadingQueryProcessor();
+
+  // Returns the QueryProcessor for the latest version of the indices,
+  // reloading them first if they've changed.  Hold on to the result for
+  // the whole of a query, rather than calling Get() again partway.
+  std::shared_ptr<const QueryProcessor> Get();
+
+ private:
+  // What identifies one version of one index file, or the lack of it.
+  struct FileVersion {
+    bool     exists;
+    dev_t    dev;
+    ino_t    inode;
+    int64_t  mtime_ns;
+    off_t    size;
+
+    bool operator==(const FileVersion& other) const;
+  };
+
+  // Lists the files that make up the indices right now, setting
+  // "versions" to their versions, in the same order.
+  std::list<std::string> ListSegments(std::vector<FileVersion>* versions)
+      const;
+
+  const std::list<std::string> index_list_;
+  const bool validate_;
+  const bool use_mmap_;
+  QueryWorkerPool* const pool_;
+  const int check_interval_;
+
+  pthread_mutex_t lock_;  // guards everything below
+
+  std::shared_ptr<const QueryProcessor> current_;
+  std::list<std::string> segments_;    // the files "current_" loaded
+  std::vector<FileVersion> versions_;  // and their versions
+  time_t last_check_;                  // when the files were last checked
+  bool reloading_;                     // whether a thread is reloading
+
+  DISALLOW_COPY_AND_ASSIGN(ReloadingQueryProcessor);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_RELOADINGQUERYPROCESSOR_H_
@@ -0,0 +1,48 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./StringKey.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "libhw1/HashTable.h"
+
+#ifndef STRINGKEY_HASH_BITS
+#define STRINGKEY_HASH_BITS 64
+#endif
+
+// See StringKey.h.  Below 16 bits, the probe sequences of a real corpus
+// run into each other and indexing slows to a crawl.
+#if STRINGKEY_HASH_BITS < 16 || STRINGKEY_HASH_BITS > 64
+#error "STRINGKEY_HASH_BITS must be between 16 and 64"
+#endif
+
+HTKey_t StringKey_Hash(const char* str) {
+  HTKey_t hash = FNVHash64((unsigned char*) str, strlen(str));
+  return hash >> (64 - STRINGKEY_HASH_BITS);
+}
+
+bool StringKey_Find(HashTable* table, const char* str, StringKeyFn key_fn,
+                    void* arg, HTKeyValue_t* kv, HTKey_t* free_key) {
+  HTKey_t key = StringKey_Hash(str);
+
+  // Walk the probe sequence until we find "str" or a free key.  It can't
+  // go on forever, since the table can't hold 2^64 elements.
+  while (HashTable_Find(table, key, kv)) {
+    if (strcmp(key_fn(kv->value, arg), str) == 0) {
+      return true;
+    }
+    key++;
+  }
+  *free_key = key;
+  return false;
+}
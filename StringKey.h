@@ -0,0 +1,71 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW2_STRINGKEY_H_
+#define HW2_STRINGKEY_H_
+
+#include <stdbool.h>  // for bool
+
+#include "libhw1/HashTable.h"
+
+// The MemIndex, the DocTable, and FileParser's word tables are all
+// HashTables keyed on strings (words or document names).  A HashTable
+// key is only 64 bits, though, so two different strings can hash to the
+// same key; across hundreds of millions of words, that's too likely to
+// ignore.
+//
+// These helpers resolve such collisions by probing: a string's element
+// is stored at the first key of the sequence
+//
+//   StringKey_Hash(str), StringKey_Hash(str) + 1, ...
+//
+// that is either free or holds that very string.  Since none of these
+// tables ever has an element removed, a lookup can stop at the first free
+// key.  In practice, of course, the first key almost always answers.
+//
+// As a result, a string's key in the table isn't necessarily its hash.
+// Anything that needs the hash itself (such as WriteIndex(), which
+// places words in on-disk buckets by FNVHash64()) must recompute it from
+// the string.
+//
+// Building with -DSTRINGKEY_HASH_BITS=n keeps only n bits of each hash,
+// which forces collisions on the tables so the probing can be tested on
+// any corpus (see stringkeytest.c).  n must be at least 16: with fewer
+// keys, the probe sequences run into each other and indexing goes
+// quadratic.  Even 16 bits is only fit for tests; a large corpus wants
+// 20 or more.
+
+// Returns the string that "value", an element of a string-keyed
+// HashTable, is keyed on.  "arg" is whatever was passed along to
+// StringKey_Find().
+typedef const char* (*StringKeyFn)(HTValue_t value, void* arg);
+
+// Returns the hash that the key of "str" is probed from.
+HTKey_t StringKey_Hash(const char* str);
+
+// Looks up "str" in "table", whose elements are keyed on the strings
+// that "key_fn" returns for them.
+//
+// Arguments:
+// - table: the string-keyed HashTable to look in.
+// - str: the string to look up.
+// - key_fn: returns the string an element of "table" is keyed on.
+// - arg: passed along to each call of "key_fn".
+// - kv: if "str" is found, set to its element (an output parameter).
+// - free_key: if "str" isn't found, set to the key a new element for it
+//   must be inserted at (an output parameter).
+//
+// Returns:
+// - true if "str" is in "table", false otherwise.
+bool StringKey_Find(HashTable* table, const char* str, StringKeyFn key_fn,
+                    void* arg, HTKeyValue_t* kv, HTKey_t* free_key);
+
+#endif  // HW2_STRINGKEY_H_
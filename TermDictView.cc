@@ -0,0 +1,180 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "./TermDictView.h"
+
+#include <stdint.h>   // for uint8_t, etc.
+#include <algorithm>  // for std::upper_bound(), std::sort().
+#include <memory>     // for std::shared_ptr.
+#include <string>     // for std::string.
+#include <utility>    // for std::move().
+#include <vector>     // for std::vector.
+
+#include "./IndexTableView.h"
+#include "./LayoutStructsV2.h"
+
+using std::shared_ptr;
+using std::sort;
+using std::string;
+using std::upper_bound;
+using std::vector;
+
+namespace hw3 {
+
+TermDictView::TermDictView(shared_ptr<const IndexFileSource> file)
+  : file_(file), has_dictionary_(false), blocks_pos_(0), blocks_bytes_(0) {
+  IndexFileOffset_t offset;
+  int32_t bytes;
+  TermDictHeader header;
+  if (!file_->FindSection(kTermDictSection, &offset, &bytes)
+      || bytes < static_cast<int32_t>(sizeof(TermDictHeader))
+      || !file_->ReadRecord(offset, &header)
+      || header.num_terms < 0 || header.num_blocks < 0
+      || header.blocks_bytes < 0
+      || header.blocks_bytes
+         > bytes - static_cast<int32_t>(sizeof(TermDictHeader))) {
+    return;
+  }
+
+  // Read the block index, which fills the rest of the section.
+  blocks_pos_ = offset + sizeof(TermDictHeader);
+  blocks_bytes_ = header.blocks_bytes;
+  vector<uint8_t> index(bytes - sizeof(TermDictHeader) - blocks_bytes_);
+  if (!index.empty()
+      && !file_->ReadBytes(blocks_pos_ + blocks_bytes_, index.data(),
+                           index.size())) {
+    return;
+  }
+  const uint8_t* cursor = index.data();
+  const uint8_t* end = cursor + index.size();
+  block_offsets_.reserve(header.num_blocks);
+  first_words_.reserve(header.num_blocks);
+  for (int32_t i = 0; i < header.num_blocks; i++) {
+    uint64_t block_offset, word_len;
+    if (!ReadVarint(&cursor, end, &block_offset)
+        || block_offset > static_cast<uint64_t>(blocks_bytes_)
+        || (i > 0 && block_offset
+                     <= static_cast<uint64_t>(block_offsets_.back()))
+        || !ReadVarint(&cursor, end, &word_len)
+        || word_len > static_cast<uint64_t>(end - cursor)) {
+      block_offsets_.clear();
+      first_words_.clear();
+      return;
+    }
+    block_offsets_.push_back(block_offset);
+    first_words_.emplace_back(reinterpret_cast<const char*>(cursor),
+                              word_len);
+    cursor += word_len;
+  }
+  has_dictionary_ = true;
+}
+
+bool TermDictView::GetRange(const string& first, const string& last,
+                            size_t max_terms, vector<Term>* const terms) const {
+  terms->clear();
+  if (!has_dictionary_) {
+    return ScanWordTable(first, last, max_terms, terms);
+  }
+
+  // Start at the last block whose first word isn't past "first"; no
+  // earlier block can hold a word in the range.
+  size_t block = upper_bound(first_words_.begin(), first_words_.end(),
+                             first) - first_words_.begin();
+  block = (block > 0) ? block - 1 : 0;
+
+  // Then decode blocks until we pass "last".
+  vector<uint8_t> buffer;
+  for (; block < block_offsets_.size(); block++) {
+    if (!last.empty() && first_words_[block] >= last) {
+      break;
+    }
+    int32_t block_bytes = ((block + 1 < block_offsets_.size())
+                           ? block_offsets_[block + 1] : blocks_bytes_)
+                          - block_offsets_[block];
+    IndexFileOffset_t block_pos = blocks_pos_ + block_offsets_[block];
+    const uint8_t* cursor = file_->BytesAt(block_pos, block_bytes);
+    if (cursor == nullptr) {
+      buffer.resize(block_bytes);
+      if (!file_->ReadBytes(block_pos, buffer.data(), block_bytes)) {
+        return true;
+      }
+      cursor = buffer.data();
+    }
+    const uint8_t* end = cursor + block_bytes;
+
+    // Each word is the first "shared" bytes of the one before it,
+    // followed by its own suffix.
+    string word;
+    while (cursor < end) {
+      uint64_t shared, suffix_len, element_pos;
+      if (!ReadVarint(&cursor, end, &shared) || shared > word.size()
+          || !ReadVarint(&cursor, end, &suffix_len)
+          || suffix_len > static_cast<uint64_t>(end - cursor)) {
+        return true;
+      }
+      word.resize(shared);
+      word.append(reinterpret_cast<const char*>(cursor), suffix_len);
+      cursor += suffix_len;
+      if (!ReadVarint(&cursor, end, &element_pos)) {
+        return true;
+      }
+
+      if (word < first) {
+        continue;
+      }
+      if (!last.empty() && word >= last) {
+        return true;
+      }
+      if (terms->size() == max_terms) {
+        return false;
+      }
+      terms->emplace_back(word, element_pos);
+    }
+  }
+  return true;
+}
+
+bool TermDictView::GetPrefix(const string& prefix, size_t max_terms,
+                             vector<Term>* const terms) const {
+  return GetRange(prefix, PrefixEnd(prefix), max_terms, terms);
+}
+
+string TermDictView::PrefixEnd(const string& prefix) {
+  // That's "prefix" with its last byte that can be incremented
+  // incremented, and everything after that byte dropped.  If there's no
+  // such byte, the range is unbounded above.
+  string last = prefix;
+  while (!last.empty() && static_cast<uint8_t>(last.back()) == 0xFF) {
+    last.pop_back();
+  }
+  if (!last.empty()) {
+    last.back()++;
+  }
+  return last;
+}
+
+bool TermDictView::ScanWordTable(const string& first, const string& last,
+                                 size_t max_terms,
+                                 vector<Term>* const terms) const {
+  for (Term& term : IndexTableView(file_).GetWordList()) {
+    if (term.first >= first && (last.empty() || term.first < last)) {
+      terms->push_back(std::move(term));
+    }
+  }
+  sort(terms->begin(), terms->end());
+  if (terms->size() > max_terms) {
+    terms->resize(max_terms);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace hw3
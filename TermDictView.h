@@ -0,0 +1,90 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_TERMDICTVIEW_H_
+#define HW3_TERMDICTVIEW_H_
+
+#include <stdint.h>  // for int32_t.
+#include <memory>    // for std::shared_ptr.
+#include <string>    // for std::string.
+#include <utility>   // for std::pair.
+#include <vector>    // for std::vector.
+
+#include "./IndexFileSource.h"
+#include "./LayoutStructs.h"
+#include "./Utils.h"
+
+namespace hw3 {
+
+// A TermDictView finds the words of an index file that fall within a
+// range, or that start with a prefix, in sorted (byte) order.  Each word
+// comes with the file offset of its word table element, which
+// IndexTableView::LookupElement() turns into its postings without
+// hashing the word again.
+//
+// A v2 file records its words in a term dictionary section (see
+// LayoutStructsV2.h).  The view reads the section's block index when
+// it's constructed, so that a lookup binary searches it in memory and
+// then decodes only the blocks that hold the range.
+//
+// A v1 file, or a v2 file written before the term dictionary existed,
+// has no such section.  Its lookups read every word in the word table
+// instead, which gives the same answers, only much more slowly.
+class TermDictView {
+ public:
+  // A word, and the file offset of its word table element.
+  typedef std::pair<std::string, IndexFileOffset_t> Term;
+
+  // Construct a view of the term dictionary of "file".
+  explicit TermDictView(std::shared_ptr<const IndexFileSource> file);
+
+  // Returns true if the file has a usable term dictionary section.
+  bool has_dictionary() const { return has_dictionary_; }
+
+  // Sets "terms" to the words w of the index file with first <= w < last,
+  // in sorted order; an empty "last" leaves the range unbounded above.
+  // Returns false if there are more than "max_terms" of them, in which
+  // case "terms" holds only the first "max_terms".
+  bool GetRange(const std::string& first, const std::string& last,
+                size_t max_terms, std::vector<Term>* const terms) const;
+
+  // Like GetRange(), for the words that start with "prefix".
+  bool GetPrefix(const std::string& prefix, size_t max_terms,
+                 std::vector<Term>* const terms) const;
+
+  // Returns the first string after all of those that start with
+  // "prefix", or "" if there's none, so that the words that start with
+  // "prefix" are GetRange(prefix, PrefixEnd(prefix), ...).
+  static std::string PrefixEnd(const std::string& prefix);
+
+ private:
+  // GetRange() for files without a term dictionary.
+  bool ScanWordTable(const std::string& first, const std::string& last,
+                     size_t max_terms, std::vector<Term>* const terms) const;
+
+  std::shared_ptr<const IndexFileSource> file_;
+  bool has_dictionary_;
+
+  // Where the term blocks start in the file, and how long they are.
+  IndexFileOffset_t blocks_pos_;
+  int32_t blocks_bytes_;
+
+  // The block index: block i starts block_offsets_[i] bytes into the term
+  // blocks, and its first word is first_words_[i].
+  std::vector<int32_t> block_offsets_;
+  std::vector<std::string> first_words_;
+
+  DISALLOW_COPY_AND_ASSIGN(TermDictView);
+};
+
+}  // namespace hw3
+
+#endif  // HW3_TERMDICTVIEW_H_
@@ -0,0 +1,74 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW2_WORDPOSITIONARRAY_H_
+#define HW2_WORDPOSITIONARRAY_H_
+
+#include <stddef.h>  // for size_t
+
+#include "libhw1/HashTable.h"
+#include "./Arena.h"
+#include "./DocTable.h"
+#include "./FileParser.h"
+#include "./MemIndex.h"
+
+// The crawlers parse each file into a table of WordPositionArrays rather
+// than WordPositions.  The table's values (the structs, the words, and
+// the position arrays) come from an Arena, so they cost no malloc()s and
+// are thrown away with an Arena_Reset().  The MemIndex copies out whatever
+// it keeps.
+//
+// The HashTable itself is still an ordinary libhw1 HashTable, though.
+// With the chained implementation (HT_IMPL=HashTable) that means a
+// malloc() for each of its buckets, and one for each distinct word's
+// element and list node, which are freed one at a time as the crawl
+// commits the file.  So an arena table saves the per-occurrence
+// allocations and most of the per-word ones, not all of them.
+
+// One word of a file, and the byte offsets it occurs at.
+typedef struct {
+  char*                word;           // the word, NUL-terminated
+  DocPositionOffset_t* positions;      // its offsets, in increasing order
+  int                  num_positions;  // the length of "positions"
+  int                  capacity;       // how many "positions" can hold
+} WordPositionArray;
+
+// Like ParseIntoWordPositionsTable(), but builds a HashTable of
+// WordPositionArrays, allocated from "arena".
+//
+// Arguments:
+// - file_contents: the file's contents, as returned by
+//   ReadFileToString().  Takes ownership of (and frees) it.
+// - arena: where to allocate the table's elements.
+//
+// Returns:
+// - NULL if the file is empty, isn't ASCII text, or has no words.
+// - otherwise, a HashTable of WordPositionArrays, keyed as StringKey.h
+//   describes.  The caller must free it with FreeWordPositionArrays()
+//   before resetting or freeing "arena".
+HashTable* ParseIntoWordPositionArrays(char* file_contents, Arena* arena);
+
+// Frees a table returned by ParseIntoWordPositionArrays().  Its elements
+// stay in the arena.
+void FreeWordPositionArrays(HashTable* table);
+
+// Adds "wpa", the positions of a word in the document "doc_id", to the
+// inverted index, as MemIndex_AddPostingList() does.  Unlike it, this
+// copies the word (if the index hasn't seen it before) and the
+// positions, so "wpa" may live in an Arena.
+//
+// Returns an estimate of how many bytes of memory the index grew by,
+// which callers can add up to keep the index within a budget.
+size_t MemIndex_AddWordPositionArray(MemIndex* index,
+                                     const WordPositionArray* wpa,
+                                     DocID_t doc_id);
+
+#endif  // HW2_WORDPOSITIONARRAY_H_
@@ -10,158 +10,453 @@
  */
 
 #include "./WriteIndex.h"
-
-#include <cstdio>    // for (FILE *).
-#include <cstring>   // for strlen(), etc.
-
-// We need to peek inside the implementation of a HashTable so
-// that we can iterate through its buckets and their chain elements.
+#include "./WriteIndexRuns.h"
+#include "./WriteIndexV1.h"
+
+#include <errno.h>     // for errno, EINTR.
+#include <fcntl.h>     // for open().
+#include <stdint.h>    // for int64_t, INT32_MAX, etc.
+#include <stdio.h>     // for FILE, fopen(), getc(), etc.
+#include <unistd.h>    // for write(), pwrite(), fsync(), etc.
+#include <algorithm>   // for std::sort(), std::max(), std::push_heap().
+#include <cstring>     // for strlen(), memcpy(), etc.
+#include <functional>  // for std::function.
+#include <memory>      // for std::unique_ptr.
+#include <string>      // for std::string.
+#include <utility>     // for std::pair, std::move().
+
+// We only use the HashTable's public API, so that libhw1 is free to
+// lay its tables out however it likes in memory (see FlatHashTable.c).
 extern "C" {
   #include "libhw1/CSE333.h"
-  #include "libhw1/HashTable_priv.h"
+  #include "libhw1/HashTable.h"
+  #include "libhw2/PositionList.h"
 }
+#include "./BM25.h"
+#include "./FastCRC32.h"
 #include "./LayoutStructs.h"
+#include "./LayoutStructsV2.h"
 #include "./Utils.h"
 #include <vector>
 #include <iostream>
 
-using std::cerr; 
-using std::endl; 
+using std::cerr;
+using std::endl;
+using std::function;
+using std::pair;
+using std::pop_heap;
+using std::push_heap;
+using std::sort;
+using std::string;
+using std::unique_ptr;
+using std::vector;
 
 namespace hw3 {
 //////////////////////////////////////////////////////////////////////////////
-// Helper function declarations and constants.
+// Helper classes, function declarations and constants.
+//
+// The index file is written in a single sequential pass.  Every offset
+// that the file format needs (BucketRecord and ElementPositionRecord
+// positions, WordPostingsHeader sizes) is computed up front from the
+// in-memory tables, so we never need to seek backwards, and we fold each
+// byte into the checksum as we produce it instead of re-reading the file.
+// The only out-of-order write is the IndexFileHeader, which goes in last.
+//
+// WriteIndex() writes the v2 format (see LayoutStructsV2.h), and
+// WriteIndexV1() the original one.  They differ only in how the MemIndex
+// is laid out.  WriteMergedIndex() writes the v2 format too, but from
+// sorted streams of postings (run files, or other index files) rather
+// than a MemIndex.
 
 static constexpr int kFailedWrite = -1;
 
-// Helper function to write the docid->filename mapping from the
-// DocTable "dt" into file "f", starting at byte offset "offset".
-// Returns the size of the written DocTable or a negative value on error.
-static int WriteDocTable(FILE* f, DocTable* dt, IndexFileOffset_t offset);
+// How much output IndexFileStream buffers before issuing a write().
+static constexpr size_t kStreamBufferBytes = 1 << 20;
+
+// An IndexFileStream appends bytes to an index file through a large
+// buffer, folding every byte that passes through it into a CRC32.
+class IndexFileStream {
+ public:
+  // Construct a stream that appends to the file "fd", starting at byte
+  // offset "start".  The stream doesn't take ownership of "fd".
+  IndexFileStream(int fd, IndexFileOffset_t start);
+
+  // Appends "len" bytes from "data" to the stream.  Returns false if a
+  // write() fails.
+  bool Write(const void* data, size_t len);
+
+  // Converts "record" to disk format and appends it to the stream.
+  template <typename T> bool WriteRecord(T record) {
+    record.ToDiskFormat();
+    return Write(&record, sizeof(T));
+  }
+
+  // Writes out anything that's still buffered.  Returns false if a
+  // write() fails.
+  bool Flush();
+
+  // The byte offset in the file at which the next byte will be written.
+  int64_t position() const { return position_; }
+
+  // The CRC of everything that's been written through the stream.  Only
+  // valid after a successful Flush().
+  uint32_t GetFinalCRC() { return crc_.GetFinalCRC(); }
 
-// Helper function to write the MemIndex "mi" into file "f", starting
-// at byte offset "offset".  Returns the size of the written MemIndex
-// or a negative value on error.
-static int WriteMemIndex(FILE* f, MemIndex* mi, IndexFileOffset_t offset);
+ private:
+  // Folds "len" bytes into the CRC and write()s them out, retrying on
+  // short writes and EINTR.
+  bool WriteOut(const uint8_t* data, size_t len);
 
-// Helper function to write the index file's header into file "f".
-// Will atomically write the kMagicNumber as its very last operation;
+  int fd_;
+  int64_t position_;
+  vector<uint8_t> buffer_;
+  size_t buffered_;
+  FastCRC32 crc_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexFileStream);
+};
+
+// Helper function to write the docid->filename mapping from the
+// DocTable "dt" at the current position of "out".
+// Returns false on error.
+static bool WriteDocTable(IndexFileStream* out, DocTable* dt);
+
+// Helper functions to write the MemIndex "mi" at the current position of
+// "out", in the v1 and v2 formats respectively.  The v2 format also
+// records statistics about the documents in the DocTable "dt".  Returns
+// false on error.
+static bool WriteMemIndex(IndexFileStream* out, MemIndex* mi);
+static bool WriteMemIndexV2(IndexFileStream* out, MemIndex* mi,
+                            DocTable* dt);
+
+// What we know about the documents' lengths, which goes into the v2 doc
+// stats section and the max_tf_score of each v2 posting list.
+typedef struct {
+  int32_t          num_docs;        // the number of documents
+  int64_t          total_words;     // the sum of their lengths
+  double           avg_doc_length;  // as computed by BM25AverageDocLength()
+  DocID_t          first_doc_id;    // the smallest docID
+  vector<uint32_t> lengths;         // indexed by docID - first_doc_id
+} DocStats;
+
+// Works out "stats" for the documents of the DocTable "dt", whose words
+// are in the MemIndex "mi".
+static void ComputeDocStats(DocTable* dt, MemIndex* mi, DocStats* stats);
+
+// The first half of ComputeDocStats(): sets up "stats" for the documents
+// of "dt", with all of their lengths 0.
+static void StartDocStats(DocTable* dt, DocStats* stats);
+
+// Writes "stats" as a doc stats section at the current position of "out".
+// Returns false on error.
+static bool WriteDocStats(IndexFileStream* out, const DocStats& stats);
+
+// Encodes "docs", which must be in increasing docID order, as a v2
+// posting list, replacing the contents of "out".  This is the heart of
+// EncodePostings(), which WriteMergedIndex() shares.
+static void EncodePostingsDocs(const vector<PostingsDoc>& docs,
+                               const DocStats& stats,
+                               vector<uint8_t>* const out);
+
+// Each element of a table, paired with the file offset WriteHashTable()
+// wrote it at.
+typedef vector<pair<HTKeyValue_t, IndexFileOffset_t>> ElementPositions;
+
+// A TermDictEncoder builds a term dictionary section (see
+// LayoutStructsV2.h) from words handed to it in sorted order.  The
+// section is built in memory, since its header needs the blocks' length;
+// it's a small fraction of the size of the word table.
+class TermDictEncoder {
+ public:
+  TermDictEncoder() : num_terms_(0) { }
+
+  // Adds the "len"-byte "word", whose word table element is at
+  // "element_pos".  It must sort after every word added before it.
+  void Add(const char* word, size_t len, IndexFileOffset_t element_pos);
+
+  // Writes the section at the current position of "out".  Returns false
+  // on error.
+  bool Write(IndexFileStream* out) const;
+
+ private:
+  vector<uint8_t> blocks_, block_index_;
+  string prev_word_;
+  int32_t num_terms_;
+
+  DISALLOW_COPY_AND_ASSIGN(TermDictEncoder);
+};
+
+// Adds the words of the v2 word table whose elements (WordPostings) and
+// their offsets are "words" to the term dictionary "dict".  Sorts "words"
+// by word.
+static void FillTermDict(ElementPositions* words, TermDictEncoder* dict);
+
+// Writes a v2 index region at the current position of "out": a word
+// table section, written by "write_word_table" (which also fills in the
+// term dictionary), then the term dictionary and doc stats sections, and
+// then the section directory.  Returns false on error.
+static bool WriteIndexRegionV2(
+    IndexFileStream* out, const DocStats& stats,
+    const function<bool(IndexFileStream*, TermDictEncoder*)>&
+        write_word_table);
+
+// How much of a run file RunReader buffers at a time.  The merge reads
+// every run at once, so this is per run.
+static constexpr size_t kRunBufferBytes = 1 << 16;
+
+// A RunReader streams the word records of a run file (see
+// WriteIndexRuns.h), one at a time.
+class RunReader : public PostingsStream {
+ public:
+  RunReader() : file_(nullptr), failed_(false), first_doc_id_(0),
+                num_docs_(0) { }
+  ~RunReader() {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  // Opens the run file "file_name" and reads its document lengths.
+  // Returns false on error.
+  bool Open(const char* file_name);
+
+  // PostingsStream methods.
+  bool Next() override;
+  const string& word() const override { return word_; }
+  bool GetDocs(vector<PostingsDoc>* docs) const override;
+  bool failed() const override { return failed_; }
+
+  // The run's first docID, and the lengths of the documents from there
+  // on.
+  DocID_t first_doc_id() const { return first_doc_id_; }
+  const vector<uint32_t>& lengths() const { return lengths_; }
+
+ private:
+  // Read a varint, or "len" bytes, from the file.  Return false at the
+  // end of the file or on error.
+  bool ReadFileVarint(uint64_t* value);
+  bool ReadFileBytes(size_t len, void* data);
+
+  FILE* file_;
+  bool failed_;
+  DocID_t first_doc_id_;
+  vector<uint32_t> lengths_;
+
+  // The current record.
+  string word_;
+  uint64_t num_docs_;
+  vector<uint8_t> docs_, positions_;
+
+  DISALLOW_COPY_AND_ASSIGN(RunReader);
+};
+
+// A PostingsMerger merges the words of a set of PostingsStreams, in
+// strcmp() order, combining the postings of a word that's in more than
+// one of them.
+class PostingsMerger {
+ public:
+  // Merges "streams", which the merger takes ownership of.  None of them
+  // may have been advanced yet.
+  explicit PostingsMerger(vector<unique_ptr<PostingsStream>>* streams);
+
+  // Moves on to the next word, setting "docs" to its documents from every
+  // stream, in stream order.  Returns false once there are no more words,
+  // or on error (in which case failed() is true).
+  bool Next(vector<PostingsDoc>* docs);
+
+  // The current word.
+  const string& word() const { return streams_[current_[0]]->word(); }
+  bool failed() const { return failed_; }
+
+ private:
+  // Orders the streams in heap_ so that the front is the one with the
+  // smallest word, and of those, the earliest stream.
+  bool HeapCompare(int a, int b) const;
+
+  vector<unique_ptr<PostingsStream>> streams_;
+  vector<int> heap_;     // the streams that have words left
+  vector<int> current_;  // the streams whose word is the current one
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostingsMerger);
+};
+
+// Opens each of "run_files" as a RunReader, appending them to "runs".
+// Returns false on error.
+static bool OpenRuns(const vector<string>& run_files,
+                     vector<unique_ptr<PostingsStream>>* runs);
+
+// Writes the MemIndex "mi" as a run file at the current position of
+// "out".  Returns false on error.
+static bool WriteRun(IndexFileStream* out, MemIndex* mi);
+
+// Writes the word table section of WriteMergedIndex()'s output at the
+// current position of "out", merging "streams".  "keys" and
+// "element_bytes" are each word's on-disk key and element size, in word
+// order, from an earlier pass over the same streams.  Adds the words to
+// "dict".  Returns false on error.
+static bool WriteMergedWordTable(IndexFileStream* out,
+                                 vector<unique_ptr<PostingsStream>>* streams,
+                                 const DocStats& stats,
+                                 const vector<HTKey_t>& keys,
+                                 const vector<int64_t>& element_bytes,
+                                 TermDictEncoder* dict);
+
+// Writes a complete index file: a header with "magic_number", the
+// DocTable "dt", and then an index region written by "write_region".
+// Returns the number of bytes written, or kFailedWrite.
+static int WriteIndexFile(
+    DocTable* dt, const char* file_name, uint32_t magic_number,
+    const function<bool(IndexFileStream*)>& write_region);
+
+// Helper function to write the index file's header into file "fd".
+// "doctable_bytes" and "memidx_bytes" must already be durably on disk;
 // as a result, if we crash part way through writing an index file,
 // it won't contain a valid kMagicNumber and the rest of HW3 will
 // know to report an error.  On success, returns the number of header
 // bytes written; on failure, a negative value.
-static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes);
+static int WriteHeader(int fd, uint32_t magic_number, uint32_t checksum,
+                       int doctable_bytes, int memidx_bytes);
+
+// Function pointer used by WriteHashTable() to determine how many bytes
+// a HashTable's HTKeyValue_t element will occupy in the index file.
+// "context" is whatever the caller of WriteHashTable() passed along.
+typedef int64_t (*ElementSizeFn)(const HTKeyValue_t& kv, const void* context);
 
 // Function pointer used by WriteHashTable() to write a HashTable's
-// HTKeyValue_t element into the index file at a specified byte offset.
+// HTKeyValue_t element at the current position of the stream.
 //
 // Arguments:
-//   - f: the file to write into.
-//   - offset: the byte offset into "f", at which we should
-//             write the element.
-//   - kv: a pointer to the key value pair to be interpreted and written.
+//   - out: the stream to write to.
+//   - kv: the key value pair to be interpreted and written.
+//   - element_bytes: the element's size, as returned by the matching
+//                    ElementSizeFn.
+//   - context: whatever the caller of WriteHashTable() passed along.
 //
 // Returns:
-//   - the number of bytes written, or a negative value on error.
-typedef int (*WriteElementFn)(FILE* f, IndexFileOffset_t offset,
-                              HTKeyValue_t* kv);
-
-// Writes a HashTable into the index file at a specified byte offset.
+//   - false on error.
+typedef bool (*WriteElementFn)(IndexFileStream* out, const HTKeyValue_t& kv,
+                               int64_t element_bytes, const void* context);
+
+// Function pointer used by WriteHashTable() to determine the on-disk key
+// of a HashTable's HTKeyValue_t element, when it isn't the element's key
+// in memory.
+typedef HTKey_t (*ElementKeyFn)(const HTKeyValue_t& kv);
+
+// The ElementKeyFn of a MemIndex's elements: the FNVHash64() of their
+// words, which the readers look them up by.  The MemIndex itself may key
+// a word differently, to step around another word with the same hash
+// (see StringKey.h).
+static HTKey_t WordKey(const HTKeyValue_t& kv);
+
+// Returns the number of bytes that WriteHashTable() will write for "ht".
+static int64_t HashTableSize(HashTable* ht, ElementSizeFn size_fn,
+                             const void* context = nullptr);
+
+// Writes a HashTable at the current position of the stream.
 //
 // Writes a header (BucketListHeader), a list of bucket records (BucketRecord),
-// then the bucket contents themselves (using a content-specific instance of
+// then the bucket contents themselves: each bucket's ElementPositionRecords,
+// followed by its elements (using a content-specific instance of
 // WriteElementFn).
 //
+// The on-disk bucket layout is computed here, from the elements' on-disk
+// keys, rather than copied from the in-memory table: an element with
+// on-disk key "k" goes in on-disk bucket (k % num_buckets), which is what
+// the readers expect.
+//
 // Since this function can write any HashTable, regardless of its contents,
 // it is the core functionality of the file.
 //
 // Arguments:
-//   - f: the file to write into.
-//   - offset: the byte offset into "f", at which we should write the
-//             hashtable.
+//   - out: the stream to write to.
 //   - ht: the hashtable to write.
-//   - fn: a function that serializes a single HTKeyValue_t.  Needs to be
-//         specific to the hashtable's contents.
-//
-// Returns:
-//   - the number of bytes written, or a negative value on error.
-static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
-                          WriteElementFn fn);
-
-// Helper function used by WriteHashTable() to write a BucketRecord (ie, a
-// "bucket_rec" within the hw3 diagrams).
-//
-// Arguments:
-//   - f: the file to write into.
-//   - offset: the byte offset into "f", at which we should
-//             write the BucketRecord.
-//   - numElts: the number of elements in the bucket.  Used to initialize
-//              the BucketRecord's contents.
-//   - bucketOffset: the offset at which the bucket (not the BucketRecord) is
-//                   located in "f".
-//
-// Returns:
-//   - the number of bytes written, or a negative value on error.
-static int WriteHTBucketRecord(FILE* f, IndexFileOffset_t offset,
-                               int32_t num_elts,
-                               IndexFileOffset_t bucket_offset);
-
-// Helper function used by WriteHashTable() to write out a bucket.
-//
-// Remember that a bucket consists of a LinkedList of elements.  Thus, this
-// function writes out a list of ElementPositionRecords, describing the
-// location (as a byte offset) of each element, followed by a series of
-// elements thesmelves (serialized using an element-specific WriteElementFn).
-//
-// Arguments:
-//   - f: the file to write into.
-//   - offset: the byte offset into "f", at which we should write the bucket.
-//   - li: the bucket's contents.
-//   - fn: a function that serializes a single HTKeyValue_t -- stored as
-//         the list's LLPayload_t -- within the LinkedList.
+//   - key_fn: a function that gives the on-disk key of a single
+//     HTKeyValue_t, or nullptr if it's the key in memory.
+//   - size_fn: a function that sizes a single HTKeyValue_t.
+//   - write_fn: a function that serializes a single HTKeyValue_t.
+//   - context: passed along to each call of size_fn and write_fn.
+//   - element_positions: if not nullptr, set to each element of the table
+//     along with the file offset it was written at (an output parameter).
 //
 // Returns:
-//   - the number of bytes written, or a negative value on error.
-static int WriteHTBucket(FILE* f, IndexFileOffset_t offset,
-                         LinkedList* li, WriteElementFn fn);
+//   - false on error, including if the table would extend past the
+//     largest offset an IndexFileOffset_t can hold.
+static bool WriteHashTable(IndexFileStream* out, HashTable* ht,
+                           ElementKeyFn key_fn, ElementSizeFn size_fn,
+                           WriteElementFn write_fn,
+                           const void* context = nullptr,
+                           ElementPositions* element_positions = nullptr);
 
 
 //////////////////////////////////////////////////////////////////////////////
-// "Writer" functions
+// "Size" and "writer" functions
 //
-// Functions that comply with the WriteElementFn signature, to be used when
-// writing hashtable elements to disk.
-
-// Writes an element of the IdToName table from a DocTable into
-// a specified file at a specified offset.
-static int WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv);
-
-
-// Writes an element of the MemIndex into a
-// a specified file at a specified offset.
-static int WriteWordToPostingsFn(FILE* f, IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv);
-
-// Writes an element of an inner postings table into
-// a specified file at a specified offset.
-static int WriteDocIDToPositionListFn(FILE* f, IndexFileOffset_t offset,
-                                      HTKeyValue_t* kv);
+// Pairs of functions that comply with the ElementSizeFn and WriteElementFn
+// signatures, to be used when writing hashtable elements to disk.
+
+// An element of the IdToName table from a DocTable.
+static int64_t DocidToDocnameSize(const HTKeyValue_t& kv,
+                                  const void* context);
+static bool WriteDocidToDocnameFn(IndexFileStream* out,
+                                  const HTKeyValue_t& kv,
+                                  int64_t element_bytes,
+                                  const void* context);
+
+// An element of the MemIndex.
+static int64_t WordToPostingsSize(const HTKeyValue_t& kv,
+                                  const void* context);
+static bool WriteWordToPostingsFn(IndexFileStream* out,
+                                  const HTKeyValue_t& kv,
+                                  int64_t element_bytes,
+                                  const void* context);
+
+// An element of the MemIndex, in the v2 format.
+static int64_t WordToPackedPostingsSize(const HTKeyValue_t& kv,
+                                        const void* context);
+static bool WriteWordToPackedPostingsFn(IndexFileStream* out,
+                                        const HTKeyValue_t& kv,
+                                        int64_t element_bytes,
+                                        const void* context);
+
+// An element of an inner postings table.
+static int64_t DocIDToPositionListSize(const HTKeyValue_t& kv,
+                                       const void* context);
+static bool WriteDocIDToPositionListFn(IndexFileStream* out,
+                                       const HTKeyValue_t& kv,
+                                       int64_t element_bytes,
+                                       const void* context);
 
 
 //////////////////////////////////////////////////////////////////////////////
 // WriteIndex
 
 int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
-  // Do some sanity checking on the arguments we were given.
   Verify333(mi != nullptr);
+  return WriteIndexFile(dt, file_name, kMagicNumberV2,
+                        [mi, dt](IndexFileStream* out) {
+                          return WriteMemIndexV2(out, mi, dt);
+                        });
+}
+
+int WriteIndexV1(MemIndex* mi, DocTable* dt, const char* file_name) {
+  Verify333(mi != nullptr);
+  return WriteIndexFile(dt, file_name, kMagicNumber,
+                        [mi](IndexFileStream* out) {
+                          return WriteMemIndex(out, mi);
+                        });
+}
+
+static int WriteIndexFile(
+    DocTable* dt, const char* file_name, uint32_t magic_number,
+    const function<bool(IndexFileStream*)>& write_region) {
+  // Do some sanity checking on the arguments we were given.
   Verify333(dt != nullptr);
   Verify333(file_name != nullptr);
 
-  // fopen() the file for writing; use mode "wb+" to indicate binary,
-  // write mode, and to create/truncate the file.
-  FILE* f = fopen(file_name, "wb+");
-  if (f == nullptr) {
+  // Open the file for writing, creating or truncating it.
+  int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1) {
     return kFailedWrite;
   }
 
@@ -169,119 +464,332 @@ int WriteIndex(MemIndex* mi, DocTable* dt, const char* file_name) {
   // doctable, and then lastly a memindex.
   //
   // We write out the doctable and memindex first, since we need to know
-  // their sizes before we can calculate the header.  So we'll skip over
+  // their checksum before we can write the header.  So we'll skip over
   // the header for now.
-  IndexFileOffset_t cur_pos = sizeof(IndexFileHeader);
+  IndexFileStream out(fd, sizeof(IndexFileHeader));
 
   // Write the document table.
-  int dt_bytes = WriteDocTable(f, dt, cur_pos);
-  if (dt_bytes == kFailedWrite) {
-    std::cerr << "Error: Failed to write document table." << std::endl;
-    fclose(f);
+  if (!WriteDocTable(&out, dt)) {
+    cerr << "Error: Failed to write document table." << endl;
+    close(fd);
     unlink(file_name);  // delete the file
     return kFailedWrite;
   }
-  cur_pos += dt_bytes;
+  int dt_bytes = out.position() - sizeof(IndexFileHeader);
 
-  // STEP 1.
   // Write the memindex.
-  // int mi_bytes = WriteMemIndex(f, mi, cur_pos);
-  // if (mi_bytes == kFailedWrite) {
-  //   std::cerr << "Error: Failed to write memindex." << std::endl;
-  //   fclose(f);
-  //   unlink(file_name);
-  //   return kFailedWrite;
-  // }
-  // cur_pos += mi_bytes;
-
-  int memindex_bytes = WriteMemIndex(f, mi, cur_pos);
-  if (memindex_bytes == kFailedWrite) {
-    std::cerr << "Error: Failed to write memindex." << std::endl;
-    fclose(f);
+  bool mi_ok = write_region(&out);
+  if (!mi_ok || !out.Flush() || out.position() > INT32_MAX) {
+    cerr << "Error: Failed to write memindex." << endl;
+    close(fd);
+    unlink(file_name);
+    return kFailedWrite;
+  }
+  int memindex_bytes = out.position() - sizeof(IndexFileHeader) - dt_bytes;
+
+  // Finally, backtrack to write the index header.
+  if (WriteHeader(fd, magic_number, out.GetFinalCRC(), dt_bytes,
+                  memindex_bytes) == kFailedWrite) {
+    close(fd);
     unlink(file_name);
     return kFailedWrite;
   }
-  cur_pos += memindex_bytes;
-
-  // STEP 2.
-  // Finally, backtrack to write the index header and write it.
-  // int header_bytes = WriteHeader(f, dt_bytes, mi_bytes);
-  // if (header_bytes == kFailedWrite) {
-  //   fclose(f);
-  //   unlink(file_name);
-  //   return kFailedWrite;
-  // }
-  int index_header_bytes = WriteHeader(f, dt_bytes, memindex_bytes);
-  if (index_header_bytes == kFailedWrite) {
-    fclose(f);
+
+  // Clean up and return the total amount written.
+  if (close(fd) != 0) {
     unlink(file_name);
     return kFailedWrite;
   }
+  return out.position();
+}
 
+//////////////////////////////////////////////////////////////////////////////
+// IndexFileStream
 
-  // Clean up and return the total amount written.
-  fclose(f);
-  return cur_pos;
+IndexFileStream::IndexFileStream(int fd, IndexFileOffset_t start)
+  : fd_(fd), position_(start), buffer_(kStreamBufferBytes), buffered_(0) {
+  // Leave a hole for the part of the file we're skipping over; it'll be
+  // filled in later with pwrite().
+  Verify333(lseek(fd_, start, SEEK_SET) == start);
+}
+
+bool IndexFileStream::Write(const void* data, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+  position_ += len;
+  if (len <= buffer_.size() - buffered_) {
+    // The common case: the bytes fit in the buffer.
+    memcpy(buffer_.data() + buffered_, bytes, len);
+    buffered_ += len;
+    return true;
+  }
+
+  // Otherwise, empty the buffer.  If what's left still doesn't fit, it's
+  // big enough to be worth handing to write() as-is.
+  if (!Flush()) {
+    return false;
+  }
+  if (len >= buffer_.size()) {
+    return WriteOut(bytes, len);
+  }
+  memcpy(buffer_.data(), bytes, len);
+  buffered_ = len;
+  return true;
+}
+
+bool IndexFileStream::Flush() {
+  bool ok = WriteOut(buffer_.data(), buffered_);
+  buffered_ = 0;
+  return ok;
+}
+
+bool IndexFileStream::WriteOut(const uint8_t* data, size_t len) {
+  crc_.FoldBytes(data, len);
+
+  while (len > 0) {
+    ssize_t num_written = write(fd_, data, len);
+    if (num_written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += num_written;
+    len -= num_written;
+  }
+  return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 // Helper function definitions
 
-static int WriteDocTable(FILE* f, DocTable* dt, IndexFileOffset_t offset) {
+static bool WriteDocTable(IndexFileStream* out, DocTable* dt) {
   // Break the DocTable abstraction in order to grab the docid->filename
   // hash table, then serialize it to disk.
-  return WriteHashTable(f, offset, DT_GetIDToNameTable(dt),
-                        &WriteDocidToDocnameFn);
+  return WriteHashTable(out, DT_GetIDToNameTable(dt), nullptr,
+                        &DocidToDocnameSize, &WriteDocidToDocnameFn);
 }
 
-static int WriteMemIndex(FILE* f, MemIndex* mi, IndexFileOffset_t offset) {
-  // Use WriteHashTable() to write the MemIndex into the file.  You'll
-  // need to pass in the WriteWordToPostingsFn helper function as the
-  // final argument.
-  return WriteHashTable(f, offset, mi, &WriteWordToPostingsFn);
+static bool WriteMemIndex(IndexFileStream* out, MemIndex* mi) {
+  return WriteHashTable(out, mi, &WordKey, &WordToPostingsSize,
+                        &WriteWordToPostingsFn);
 }
 
-static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes) {
-  // STEP 3.
-  // We need to calculate the checksum over the doctable and index
-  // table.  (Note that the checksum does not include the index file
-  // header, just these two tables.)
-  //
-  // Use fseek() to seek to the right location, and use a CRC32 object
-  // to do the CRC checksum calculation, feeding it characters that you
-  // read from the index file using fread().
-  // Seek to the start of the doctable.
-  if (fseek(f, sizeof(IndexFileHeader), SEEK_SET) != 0){
-    return kFailedWrite;
+static bool WriteMemIndexV2(IndexFileStream* out, MemIndex* mi,
+                            DocTable* dt) {
+  DocStats stats;
+  ComputeDocStats(dt, mi, &stats);
+
+  // Each posting list's max_tf_score depends on the document stats.
+  return WriteIndexRegionV2(
+      out, stats, [mi, &stats](IndexFileStream* out, TermDictEncoder* dict) {
+        ElementPositions words;
+        if (!WriteHashTable(out, mi, &WordKey, &WordToPackedPostingsSize,
+                            &WriteWordToPackedPostingsFn, &stats, &words)) {
+          return false;
+        }
+        FillTermDict(&words, dict);
+        return true;
+      });
+}
+
+static bool WriteIndexRegionV2(
+    IndexFileStream* out, const DocStats& stats,
+    const function<bool(IndexFileStream*, TermDictEncoder*)>&
+        write_word_table) {
+  vector<SectionRecord> sections;
+
+  // Write the word table section.
+  int64_t section_start = out->position();
+  TermDictEncoder dict;
+  if (!write_word_table(out, &dict)) {
+    return false;
+  }
+  sections.push_back(SectionRecord(kWordTableSection, section_start,
+                                   out->position() - section_start));
+
+  // Then the term dictionary section, which points back into the word
+  // table.
+  section_start = out->position();
+  if (!dict.Write(out)) {
+    return false;
   }
+  sections.push_back(SectionRecord(kTermDictSection, section_start,
+                                   out->position() - section_start));
 
-  CRC32 crc;
-  int total_byte = doctable_bytes + memidx_bytes;
-  uint8_t byte;
+  // Then the doc stats section.
+  section_start = out->position();
+  if (!WriteDocStats(out, stats)) {
+    return false;
+  }
+  sections.push_back(SectionRecord(kDocStatsSection, section_start,
+                                   out->position() - section_start));
 
-  for (int i = 0; i < total_byte; i++) {
-    if (fread(&byte, sizeof(byte), 1, f) != 1) {
-      return kFailedWrite;
+  // Then the section directory.
+  for (const SectionRecord& record : sections) {
+    if (!out->WriteRecord(record)) {
+      return false;
     }
-    crc.FoldByteIntoCRC(byte);
   }
- 
-  // Write the header fields.  Be sure to convert the fields to
-  // network order before writing them!
-  IndexFileHeader header(kMagicNumber, crc.GetFinalCRC(),
-                         doctable_bytes, memidx_bytes);
-  header.ToDiskFormat();
+  return out->WriteRecord(SectionDirectoryFooter(sections.size()));
+}
+
+static void ComputeDocStats(DocTable* dt, MemIndex* mi, DocStats* stats) {
+  StartDocStats(dt, stats);
+
+  // A document's length is the number of positions recorded for it,
+  // across every word.
+  HTIterator* it = HTIterator_Allocate(mi);
+  Verify333(it != nullptr);
+  while (HTIterator_IsValid(it)) {
+    HTKeyValue_t kv;
+    Verify333(HTIterator_Get(it, &kv));
+    WordPostings* wp = static_cast<WordPostings*>(kv.value);
+    HTIterator* doc_it = HTIterator_Allocate(wp->postings);
+    Verify333(doc_it != nullptr);
+    while (HTIterator_IsValid(doc_it)) {
+      HTKeyValue_t doc_kv;
+      Verify333(HTIterator_Get(doc_it, &doc_kv));
+      DocID_t doc_id = static_cast<DocID_t>(doc_kv.key);
+      Verify333(doc_id >= stats->first_doc_id
+                && doc_id - stats->first_doc_id < stats->lengths.size());
+      int num_positions = PositionList_NumPositions(
+          static_cast<PositionList*>(doc_kv.value));
+      stats->lengths[doc_id - stats->first_doc_id] += num_positions;
+      stats->total_words += num_positions;
+      HTIterator_Next(doc_it);
+    }
+    HTIterator_Free(doc_it);
+    HTIterator_Next(it);
+  }
+  HTIterator_Free(it);
+
+  stats->avg_doc_length =
+      BM25AverageDocLength(stats->num_docs, stats->total_words);
+}
+
+static void StartDocStats(DocTable* dt, DocStats* stats) {
+  // Find the range of docIDs.  The DocTable hands them out consecutively,
+  // so the lengths array has no gaps to speak of.
+  HashTable* id_to_name = DT_GetIDToNameTable(dt);
+  stats->num_docs = HashTable_NumElements(id_to_name);
+  stats->first_doc_id = 0;
+  DocID_t last_doc_id = 0;
+  HTIterator* it = HTIterator_Allocate(id_to_name);
+  Verify333(it != nullptr);
+  for (bool first = true; HTIterator_IsValid(it); first = false) {
+    HTKeyValue_t kv;
+    Verify333(HTIterator_Get(it, &kv));
+    DocID_t doc_id = static_cast<DocID_t>(kv.key);
+    if (first || doc_id < stats->first_doc_id) {
+      stats->first_doc_id = doc_id;
+    }
+    if (first || doc_id > last_doc_id) {
+      last_doc_id = doc_id;
+    }
+    HTIterator_Next(it);
+  }
+  HTIterator_Free(it);
+  stats->lengths.assign(
+      (stats->num_docs > 0) ? last_doc_id - stats->first_doc_id + 1 : 0, 0);
+  stats->total_words = 0;
+}
+
+static bool WriteDocStats(IndexFileStream* out, const DocStats& stats) {
+  if (!out->WriteRecord(DocStatsHeader(stats.num_docs, stats.total_words,
+                                       stats.first_doc_id,
+                                       stats.lengths.size()))) {
+    return false;
+  }
+  for (uint32_t length : stats.lengths) {
+    if (!out->WriteRecord(DocLengthRecord(length))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the word of the WordPostings element "kv".
+static const char* ElementWord(const HTKeyValue_t& kv) {
+  return static_cast<WordPostings*>(kv.value)->word;
+}
+
+static void FillTermDict(ElementPositions* words, TermDictEncoder* dict) {
+  // strcmp() compares bytes as unsigned chars, which is the order the
+  // readers expect.
+  sort(words->begin(), words->end(),
+       [](const pair<HTKeyValue_t, IndexFileOffset_t>& a,
+          const pair<HTKeyValue_t, IndexFileOffset_t>& b) {
+         return strcmp(ElementWord(a.first), ElementWord(b.first)) < 0;
+       });
+
+  for (const auto& word : *words) {
+    const char* w = ElementWord(word.first);
+    dict->Add(w, strlen(w), word.second);
+  }
+}
 
-  if (fseek(f, 0, SEEK_SET) != 0) {
+void TermDictEncoder::Add(const char* word, size_t len,
+                          IndexFileOffset_t element_pos) {
+  // Front code the words into blocks, and note where each block starts
+  // in the block index as we go.
+  size_t shared = 0;
+  if (num_terms_ % kTermDictBlockSize == 0) {
+    AppendVarint(blocks_.size(), &block_index_);
+    AppendVarint(len, &block_index_);
+    block_index_.insert(block_index_.end(), word, word + len);
+  } else {
+    while (shared < len && shared < prev_word_.size()
+           && word[shared] == prev_word_[shared]) {
+      shared++;
+    }
+  }
+  AppendVarint(shared, &blocks_);
+  AppendVarint(len - shared, &blocks_);
+  blocks_.insert(blocks_.end(), word + shared, word + len);
+  AppendVarint(element_pos, &blocks_);
+  prev_word_.assign(word, len);
+  num_terms_++;
+}
+
+bool TermDictEncoder::Write(IndexFileStream* out) const {
+  // Like the word table, the section has to end where an offset can
+  // still point.
+  int32_t num_blocks =
+      (num_terms_ + kTermDictBlockSize - 1) / kTermDictBlockSize;
+  if (out->position() + sizeof(TermDictHeader) + blocks_.size()
+      + block_index_.size() > INT32_MAX) {
+    cerr << "Error: index file would exceed " << INT32_MAX
+         << " bytes." << endl;
+    return false;
+  }
+  return out->WriteRecord(TermDictHeader(num_terms_, num_blocks,
+                                         blocks_.size()))
+    && out->Write(blocks_.data(), blocks_.size())
+    && out->Write(block_index_.data(), block_index_.size());
+}
+
+static int WriteHeader(int fd, uint32_t magic_number, uint32_t checksum,
+                       int doctable_bytes, int memidx_bytes) {
+  // Make sure the tables have hit the disk before the magic number does,
+  // so that a crash can never leave a valid header in front of
+  // incomplete tables.
+  if (fsync(fd) != 0) {
     return kFailedWrite;
   }
 
-  if (fwrite(&header, sizeof(IndexFileHeader), 1, f) != 1) {
+  // Write the header fields.  Be sure to convert the fields to
+  // network order before writing them!
+  IndexFileHeader header(magic_number, checksum,
+                         doctable_bytes, memidx_bytes);
+  header.ToDiskFormat();
+  if (pwrite(fd, &header, sizeof(IndexFileHeader), 0)
+      != static_cast<ssize_t>(sizeof(IndexFileHeader))) {
     return kFailedWrite;
   }
 
   // Use fsync to flush the header field to disk.
-  if (fsync(fileno(f)) != 0) {
+  if (fsync(fd) != 0) {
     return kFailedWrite;
   }
 
@@ -289,304 +797,848 @@ static int WriteHeader(FILE* f, int doctable_bytes, int memidx_bytes) {
   return sizeof(IndexFileHeader);
 }
 
-static int WriteHashTable(FILE* f, IndexFileOffset_t offset, HashTable* ht,
-                          WriteElementFn fn) {
-  // Write the HashTable's header, which consists simply of the number of
-  // buckets.
-  BucketListHeader header(ht->num_buckets);
-  header.ToDiskFormat();
-  if (fseek(f, offset, SEEK_SET) != 0) {
-    return kFailedWrite;
-  }
-  if (fwrite(&header, sizeof(BucketListHeader), 1, f) != 1) {
-    return kFailedWrite;
+// Pick the number of on-disk buckets for a table of "num_elements"
+// elements.  One bucket per element keeps the readers' chains short; even
+// an empty table gets one bucket.
+static int NumDiskBuckets(int num_elements) {
+  return (num_elements > 0) ? num_elements : 1;
+}
+
+static int64_t HashTableSize(HashTable* ht, ElementSizeFn size_fn,
+                             const void* context) {
+  int num_elements = HashTable_NumElements(ht);
+  int64_t size = sizeof(BucketListHeader)
+    + NumDiskBuckets(num_elements) * sizeof(BucketRecord)
+    + num_elements * sizeof(ElementPositionRecord);
+
+  HTIterator* it = HTIterator_Allocate(ht);
+  Verify333(it != nullptr);
+  while (HTIterator_IsValid(it)) {
+    HTKeyValue_t kv;
+    Verify333(HTIterator_Get(it, &kv));
+    size += size_fn(kv, context);
+    HTIterator_Next(it);
   }
+  HTIterator_Free(it);
+  return size;
+}
 
-  // The byte offset of the next BucketRecord we want to write.  Remember that
-  // the bucket records are located after the bucket header.
-  IndexFileOffset_t record_pos = offset + sizeof(BucketListHeader);
+static bool WriteHashTable(IndexFileStream* out, HashTable* ht,
+                           ElementKeyFn key_fn, ElementSizeFn size_fn,
+                           WriteElementFn write_fn, const void* context,
+                           ElementPositions* element_positions) {
+  int num_elements = HashTable_NumElements(ht);
+  int num_buckets = NumDiskBuckets(num_elements);
+
+  // Pull the elements out of the table, sizing them and counting how many
+  // land in each on-disk bucket as we go.
+  vector<HTKeyValue_t> unsorted;
+  vector<HTKey_t> unsorted_keys;
+  vector<int64_t> unsorted_bytes;
+  vector<int> bucket_start(num_buckets + 1, 0);
+  unsorted.reserve(num_elements);
+  unsorted_keys.reserve(num_elements);
+  unsorted_bytes.reserve(num_elements);
+  HTIterator* it = HTIterator_Allocate(ht);
+  Verify333(it != nullptr);
+  while (HTIterator_IsValid(it)) {
+    HTKeyValue_t kv;
+    Verify333(HTIterator_Get(it, &kv));
+    HTKey_t key = (key_fn != nullptr) ? key_fn(kv) : kv.key;
+    unsorted.push_back(kv);
+    unsorted_keys.push_back(key);
+    unsorted_bytes.push_back(size_fn(kv, context));
+    bucket_start[key % num_buckets + 1]++;
+    HTIterator_Next(it);
+  }
+  HTIterator_Free(it);
 
-  // The byte offset of the next bucket we want to write.  Reember that
-  // the buckets are placed after the bucket header and the entire list
-  // of BucketRecords.
-  IndexFileOffset_t bucket_pos = offset + sizeof(BucketListHeader)
-    + (ht->num_buckets) * sizeof(BucketRecord);
+  // Then group them by bucket (a counting sort on k % num_buckets), so
+  // that bucket i's elements are elements[bucket_start[i]] up to (but not
+  // including) elements[bucket_start[i + 1]].
+  for (int i = 0; i < num_buckets; i++) {
+    bucket_start[i + 1] += bucket_start[i];
+  }
+  vector<HTKeyValue_t> elements(num_elements);
+  vector<int64_t> element_bytes(num_elements);
+  vector<int> next_slot(bucket_start.begin(), bucket_start.end() - 1);
+  for (int i = 0; i < num_elements; i++) {
+    int slot = next_slot[unsorted_keys[i] % num_buckets]++;
+    elements[slot] = unsorted[i];
+    element_bytes[slot] = unsorted_bytes[i];
+  }
 
-  // Iterate through the hashtable contents, first writing each bucket record
-  // (ie, the BucketRecord) and then jumping forward in the file to write
-  // the bucket contents itself.
-  //
-  // Be sure to handle the corner case where the bucket's chain is
-  // empty.  For that case, you still have to write a record for the
-  // bucket, but you won't write a bucket.
-  // STEP 4: 
-  for (int i = 0; i < ht->num_buckets; i++) {
-    int num_numbers = LinkedList_NumElements(ht->buckets[i]);
-
-    int num_record = WriteHTBucketRecord(f, record_pos, num_numbers,  
-                                bucket_pos);
-    if (num_record == kFailedWrite) {
-      return kFailedWrite;
-    }  
+  // Lay out the table.  The buckets are placed after the bucket header and
+  // the entire list of BucketRecords, one after another; each bucket is its
+  // ElementPositionRecords followed by its elements.
+  int64_t offset = out->position();
+  vector<int64_t> bucket_pos(num_buckets + 1);
+  bucket_pos[0] = offset + sizeof(BucketListHeader)
+    + num_buckets * sizeof(BucketRecord);
+  for (int i = 0; i < num_buckets; i++) {
+    bucket_pos[i + 1] = bucket_pos[i]
+      + (bucket_start[i + 1] - bucket_start[i])
+        * sizeof(ElementPositionRecord);
+    for (int j = bucket_start[i]; j < bucket_start[i + 1]; j++) {
+      bucket_pos[i + 1] += element_bytes[j];
+    }
+  }
 
-    int num_bytes = WriteHTBucket(f, bucket_pos, ht->buckets[i], fn);
+  // Offsets within the file are 32 bits wide, so the table has to end
+  // where one can still point.
+  if (bucket_pos[num_buckets] > INT32_MAX) {
+    cerr << "Error: index file would exceed " << INT32_MAX
+         << " bytes." << endl;
+    return false;
+  }
 
-    if (num_bytes == kFailedWrite) {
-      return kFailedWrite;
+  // Write the HashTable's header, which consists simply of the number of
+  // buckets, and then the bucket records.
+  if (!out->WriteRecord(BucketListHeader(num_buckets))) {
+    return false;
+  }
+  for (int i = 0; i < num_buckets; i++) {
+    BucketRecord record(bucket_start[i + 1] - bucket_start[i],
+                        bucket_pos[i]);
+    if (!out->WriteRecord(record)) {
+      return false;
     }
+  }
 
-    if (num_numbers == 0) {
-      record_pos += sizeof(BucketRecord);
-      continue;
+  // Write each bucket: first its ElementPositionRecords, then the elements
+  // they point to.
+  if (element_positions != nullptr) {
+    element_positions->clear();
+    element_positions->reserve(num_elements);
+  }
+  for (int i = 0; i < num_buckets; i++) {
+    IndexFileOffset_t element_pos = bucket_pos[i]
+      + (bucket_start[i + 1] - bucket_start[i])
+        * sizeof(ElementPositionRecord);
+    for (int j = bucket_start[i]; j < bucket_start[i + 1]; j++) {
+      if (!out->WriteRecord(ElementPositionRecord(element_pos))) {
+        return false;
+      }
+      element_pos += element_bytes[j];
     }
 
-    bucket_pos += num_bytes;
-    record_pos += sizeof(BucketRecord);
+    for (int j = bucket_start[i]; j < bucket_start[i + 1]; j++) {
+      int64_t element_start = out->position();
+      if (!write_fn(out, elements[j], element_bytes[j], context)) {
+        return false;
+      }
+      if (element_positions != nullptr) {
+        element_positions->push_back({elements[j], element_start});
+      }
+      // The offsets we've already written are only right if the writer
+      // agreed with the sizer.
+      Verify333(out->position() - element_start == element_bytes[j]);
+    }
   }
-  return bucket_pos - offset;
+  return true;
 }
-                         
-static int WriteHTBucketRecord(FILE* f,
-                               IndexFileOffset_t offset,
-                               int32_t num_elts,
-                               IndexFileOffset_t bucket_offset) {
-  // STEP 5.
-  // Initialize a BucketRecord in network byte order.
-  BucketRecord record(num_elts, bucket_offset);
-  record.ToDiskFormat();
 
-  // fseek() to where we want to write this record.
-  if (fseek(f, offset, SEEK_SET) != 0) {
-    return kFailedWrite;
-  }
+//////////////////////////////////////////////////////////////////////////////
+// "Size" and "writer" functions
+
+// These are used to write a doc_id->doc_name mapping element, i.e., an
+// element of the "doctable" table.
+static int64_t DocidToDocnameSize(const HTKeyValue_t& kv,
+                                  const void* context) {
+  const char* filename = reinterpret_cast<const char*>(kv.value);
+  return sizeof(DoctableElementHeader) + strlen(filename);
+}
 
-  // STEP 6.
-  // Write the BucketRecord.
-  if (fwrite(&record, sizeof(BucketRecord), 1, f) != 1) {
-    return kFailedWrite;
-  }
+static bool WriteDocidToDocnameFn(IndexFileStream* out,
+                                  const HTKeyValue_t& kv,
+                                  int64_t element_bytes,
+                                  const void* context) {
+  const char* filename = reinterpret_cast<const char*>(kv.value);
+  int16_t file_name_bytes = element_bytes - sizeof(DoctableElementHeader);
+
+  // Write the header, then the file name.  We don't write the
+  // null-terminator from the string, just the characters, since we've
+  // already written a length field for the string.
+  return out->WriteRecord(DoctableElementHeader(kv.key, file_name_bytes))
+    && out->Write(filename, file_name_bytes);
+}
 
-  // Calculate and return how many bytes we wrote.
-  return sizeof(BucketRecord);
+// These are used to write a DocID + position list element (i.e., an
+// element of a nested docID table).
+static int64_t DocIDToPositionListSize(const HTKeyValue_t& kv,
+                                       const void* context) {
+  PositionList* positions = static_cast<PositionList*>(kv.value);
+  return sizeof(DocIDElementHeader)
+    + PositionList_NumPositions(positions) * sizeof(DocIDElementPosition);
 }
 
-static int WriteHTBucket(FILE* f, IndexFileOffset_t offset, LinkedList* li,
-                         WriteElementFn fn) {
-  int num_elts = LinkedList_NumElements(li);
-  if (num_elts == 0) {
-    // Not an error; nothing to write
-    return 0;
+static bool WriteDocIDToPositionListFn(IndexFileStream* out,
+                                       const HTKeyValue_t& kv,
+                                       int64_t element_bytes,
+                                       const void* context) {
+  DocID_t doc_id = static_cast<DocID_t>(kv.key);
+  PositionList* positions = static_cast<PositionList*>(kv.value);
+  int num_positions = PositionList_NumPositions(positions);
+
+  // Write the header, in disk format.
+  if (!out->WriteRecord(DocIDElementHeader(doc_id, num_positions))) {
+    return false;
   }
 
-  // The byte offset of the next ElementPositionRecord we want to write.
-  IndexFileOffset_t record_pos = offset;
+  // Decode the positions, writing each one out; WriteRecord() converts it
+  // to network order.
+  PLIterator it;
+  PLIterator_Init(&it, positions);
+  DocPositionOffset_t pos;
+  while (PLIterator_Next(&it, &pos)) {
+    DocIDElementPosition position;
+    position.position = pos;
+    if (!out->WriteRecord(position)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  // The byte offset of the next element we want to write.  Remember that
-  // the elements are placed after the entire list of ElementPositionRecords.
-  IndexFileOffset_t element_pos = offset
-    + sizeof(ElementPositionRecord) * num_elts;
+// This gives a WordPostings element's on-disk key, in either format.
+static HTKey_t WordKey(const HTKeyValue_t& kv) {
+  const char* word = static_cast<WordPostings*>(kv.value)->word;
+  return FNVHash64(reinterpret_cast<unsigned char*>(const_cast<char*>(word)),
+                   strlen(word));
+}
 
-  // Iterate through the list contents, first writing each entry's (ie, each
-  // payload's) ElementPositionRecord and then jumping forward in the file
-  // to write the element itself.
-  //
-  // Be sure to write in network order, and use the "fn" argument to write
-  // the element (ie, the list payload) itself.
-  LLIterator* it = LLIterator_Allocate(li);
-  Verify333(it != nullptr);
-  for (int i = 0; i < num_elts; i++) {
-    // STEP 7.
-    // fseek() to the where the ElementPositionRecord should be written,
-    // then fwrite() it in network order.
-    ElementPositionRecord elem_record(element_pos);
-    elem_record.ToDiskFormat();
-
-    if (fseek(f, record_pos, SEEK_SET) != 0) {
-      LLIterator_Free(it);
-      return kFailedWrite;
-    }
-    if (fwrite(&elem_record, sizeof(ElementPositionRecord), 1, f) != 1) {
-      LLIterator_Free(it);
-      return kFailedWrite;
-    }
+// These are used to write a WordPostings element.
+static int64_t WordToPostingsSize(const HTKeyValue_t& kv,
+                                  const void* context) {
+  WordPostings* wp = static_cast<WordPostings*>(kv.value);
+  Verify333(wp != nullptr);
+  return sizeof(WordPostingsHeader) + strlen(wp->word)
+    + HashTableSize(wp->postings, &DocIDToPositionListSize);
+}
 
-    // STEP 8.
-    // Write the element itself, using fn.
-    LLPayload_t payload;
-    LLIterator_Get(it, &payload);
-    HTKeyValue_t* key_value = reinterpret_cast<HTKeyValue_t*>(payload);
+static bool WriteWordToPostingsFn(IndexFileStream* out,
+                                  const HTKeyValue_t& kv,
+                                  int64_t element_bytes,
+                                  const void* context) {
+  WordPostings* wp = static_cast<WordPostings*>(kv.value);
+  int16_t word_bytes = strlen(wp->word);
 
-    int bytes_written = fn(f, element_pos, key_value);
+  // The nested DocID->positions hashtable (i.e., the "docID table" element
+  // in the diagrams) is whatever's left after the header and the word.
+  int32_t ht_bytes = element_bytes - sizeof(WordPostingsHeader) - word_bytes;
 
-    if (bytes_written <= kFailedWrite) {
-      LLIterator_Free(it);
-      return kFailedWrite;
+  // Write the header, then the word itself (excluding the null terminator),
+  // then the nested table.
+  return out->WriteRecord(WordPostingsHeader(word_bytes, ht_bytes))
+    && out->Write(wp->word, word_bytes)
+    && WriteHashTable(out, wp->postings, nullptr, &DocIDToPositionListSize,
+                      &WriteDocIDToPositionListFn);
+}
+
+// Encodes the docID->positions table "postings" as a v2 posting list
+// (see LayoutStructsV2.h), replacing the contents of "out".  Lists of
+// more than one block are encoded as kPostingsBlockMax, and the rest as
+// kPostingsScoredDeltaVarint.  "stats" supplies the document lengths for
+// the max_tf_scores.
+static void EncodePostings(HashTable* postings, const DocStats& stats,
+                           vector<uint8_t>* const out) {
+  // Gather the documents and sort them by docID.  A PositionList is
+  // already sorted and delta-encoded just as the position stream wants
+  // it.
+  vector<PostingsDoc> docs;
+  docs.reserve(HashTable_NumElements(postings));
+  HTIterator* it = HTIterator_Allocate(postings);
+  Verify333(it != nullptr);
+  while (HTIterator_IsValid(it)) {
+    HTKeyValue_t kv;
+    Verify333(HTIterator_Get(it, &kv));
+    PositionList* positions = static_cast<PositionList*>(kv.value);
+    PostingsDoc doc;
+    doc.doc_id = static_cast<DocID_t>(kv.key);
+    doc.num_positions = PositionList_NumPositions(positions);
+    doc.positions = PositionList_Bytes(positions, &doc.positions_bytes);
+    docs.push_back(doc);
+    HTIterator_Next(it);
+  }
+  HTIterator_Free(it);
+  sort(docs.begin(), docs.end(),
+       [](const PostingsDoc& a, const PostingsDoc& b) {
+         return a.doc_id < b.doc_id;
+       });
+  EncodePostingsDocs(docs, stats, out);
+}
+
+static void EncodePostingsDocs(const vector<PostingsDoc>& docs,
+                               const DocStats& stats,
+                               vector<uint8_t>* const out) {
+  // Build the doc and position streams side by side, and the block
+  // directory as each block fills up.
+  vector<uint8_t> doc_stream, position_stream, directory;
+  DocID_t prev_doc_id = 0, prev_block_last = 0;
+  size_t block_docs_start = 0, block_positions_start = 0;
+  double max_tf_score = 0, block_max_tf_score = 0;
+  for (size_t d = 0; d < docs.size(); d++) {
+    const PostingsDoc& doc = docs[d];
+
+    AppendVarint(doc.doc_id - prev_doc_id, &doc_stream);
+    AppendVarint(doc.num_positions, &doc_stream);
+    prev_doc_id = doc.doc_id;
+
+    block_max_tf_score = std::max(block_max_tf_score, BM25TermFrequencyScore(
+        doc.num_positions, stats.lengths[doc.doc_id - stats.first_doc_id],
+        stats.avg_doc_length));
+
+    position_stream.insert(position_stream.end(), doc.positions,
+                           doc.positions + doc.positions_bytes);
+
+    if ((d + 1) % kPostingsBlockSize == 0 || d + 1 == docs.size()) {
+      // That's the end of a block.
+      AppendVarint(doc.doc_id - prev_block_last, &directory);
+      AppendVarint(doc_stream.size() - block_docs_start, &directory);
+      AppendVarint(position_stream.size() - block_positions_start,
+                   &directory);
+      AppendMaxScore(block_max_tf_score, &directory);
+      prev_block_last = doc.doc_id;
+      block_docs_start = doc_stream.size();
+      block_positions_start = position_stream.size();
+      max_tf_score = std::max(max_tf_score, block_max_tf_score);
+      block_max_tf_score = 0;
     }
+  }
 
-    // Advance to the next element in the chain, updating our offsets.
-    record_pos += sizeof(ElementPositionRecord);
-    element_pos += bytes_written;  // you may need to change this logic
-    LLIterator_Next(it);
+  // Assemble the posting list.
+  const bool blocked = docs.size() > static_cast<size_t>(kPostingsBlockSize);
+  out->clear();
+  out->push_back(blocked ? kPostingsBlockMax : kPostingsScoredDeltaVarint);
+  AppendMaxScore(max_tf_score, out);
+  AppendVarint(docs.size(), out);
+  if (blocked) {
+    AppendVarint((docs.size() + kPostingsBlockSize - 1) / kPostingsBlockSize,
+                 out);
+    AppendVarint(directory.size(), out);
+    out->insert(out->end(), directory.begin(), directory.end());
   }
-  LLIterator_Free(it);
+  AppendVarint(doc_stream.size(), out);
+  out->insert(out->end(), doc_stream.begin(), doc_stream.end());
+  out->insert(out->end(), position_stream.begin(), position_stream.end());
+}
+
+// These are used to write a WordPostings element in the v2 format.  We
+// encode each posting list twice (once to size it, once to write it)
+// rather than hold every encoded list in memory until it's written.
+static int64_t WordToPackedPostingsSize(const HTKeyValue_t& kv,
+                                        const void* context) {
+  WordPostings* wp = static_cast<WordPostings*>(kv.value);
+  Verify333(wp != nullptr);
+  vector<uint8_t> encoded;
+  EncodePostings(wp->postings, *static_cast<const DocStats*>(context),
+                 &encoded);
+  return sizeof(WordPostingsHeader) + strlen(wp->word) + encoded.size();
+}
+
+static bool WriteWordToPackedPostingsFn(IndexFileStream* out,
+                                        const HTKeyValue_t& kv,
+                                        int64_t element_bytes,
+                                        const void* context) {
+  WordPostings* wp = static_cast<WordPostings*>(kv.value);
+  int16_t word_bytes = strlen(wp->word);
+  vector<uint8_t> encoded;
+  EncodePostings(wp->postings, *static_cast<const DocStats*>(context),
+                 &encoded);
 
-  // Return the total amount of data written.
-  return element_pos - offset;
+  return out->WriteRecord(WordPostingsHeader(word_bytes, encoded.size()))
+    && out->Write(wp->word, word_bytes)
+    && out->Write(encoded.data(), encoded.size());
 }
 
 //////////////////////////////////////////////////////////////////////////////
-// "Writer" functions
-
-// This write_element_fn is used to write a doc_id->doc_name mapping
-// element, i.e., an element of the "doctable" table.
-static int WriteDocidToDocnameFn(FILE* f, IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv) {
-  // STEP 9.
-  // Determine the file name length
-  char* filename = reinterpret_cast<char*>(kv->value);
-  int16_t file_name_bytes = strlen(filename);  
-   // you may need to change this logic
-
-
-  // fwrite() the docid from "kv".  Remember to convert to
-  // disk format before writing.
-  DoctableElementHeader header(kv->key, file_name_bytes);
-  header.ToDiskFormat();
+// Run files
+
+int WriteIndexRun(MemIndex* mi, const char* file_name) {
+  Verify333(mi != nullptr);
+  Verify333(file_name != nullptr);
 
-  // fseek() to the provided offset and then write the header.
-  if (fseek(f, offset, SEEK_SET) != 0) {
+  int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd == -1) {
     return kFailedWrite;
   }
-  if (fwrite(&header, sizeof(DoctableElementHeader), 1, f) != 1) {
+  IndexFileStream out(fd, 0);
+  bool ok = WriteRun(&out, mi) && out.Flush() && out.position() <= INT32_MAX;
+  if (close(fd) != 0 || !ok) {
+    cerr << "Error: Failed to write run file " << file_name << "." << endl;
+    unlink(file_name);
     return kFailedWrite;
   }
+  return out.position();
+}
+
+int MergeIndexRuns(const vector<string>& run_files, DocTable* dt,
+                   const char* file_name) {
+  Verify333(dt != nullptr);
 
-  // STEP 10.
-  // fwrite() the file name.  We don't write the null-terminator from the
-  // string, just the characters, since we've already written a length
-  // field for the string.
-  if (fwrite(filename, file_name_bytes, 1, f) != 1) {
+  // Gather the runs' document lengths.  The runs' docIDs ascend, so each
+  // one's lengths simply follow on from the last one's.
+  vector<unique_ptr<PostingsStream>> runs;
+  if (!OpenRuns(run_files, &runs)) {
     return kFailedWrite;
   }
-
-  // STEP 11.
-  // Calculate and return the total amount written.
-  return sizeof(DoctableElementHeader) + file_name_bytes;  
-  // you may need to change this return value
+  DocID_t first_doc_id = 0;
+  vector<uint32_t> lengths;
+  for (const auto& stream : runs) {
+    const RunReader* run = static_cast<const RunReader*>(stream.get());
+    if (run->lengths().empty()) {
+      continue;
+    }
+    if (lengths.empty()) {
+      first_doc_id = run->first_doc_id();
+    } else if (run->first_doc_id() < first_doc_id + lengths.size()) {
+      cerr << "Error: run files overlap." << endl;
+      return kFailedWrite;
+    }
+    lengths.resize(run->first_doc_id() - first_doc_id, 0);
+    lengths.insert(lengths.end(), run->lengths().begin(),
+                   run->lengths().end());
+  }
+  runs.clear();
+
+  return WriteMergedIndex(
+      dt, first_doc_id, lengths,
+      [&](vector<unique_ptr<PostingsStream>>* streams) {
+        return OpenRuns(run_files, streams);
+      },
+      file_name);
 }
 
-// This write_element_fn is used to write a DocID + position list
-// element (i.e., an element of a nested docID table) into the file at
-// offset 'offset'.
-static int WriteDocIDToPositionListFn(FILE* f,
-                                      IndexFileOffset_t offset,
-                                      HTKeyValue_t* kv) {
-  // Extract the docID from the HTKeyValue_t.
-  DocID_t doc_id = static_cast<DocID_t>(kv->key);
-
-  // Extract the positions LinkedList from the HTKeyValue_t and
-  // determine its size.
-  LinkedList* positions = static_cast<LinkedList*>(kv->value);
-  int num_positions = LinkedList_NumElements(positions);
-
-  // STEP 12.
-  // Write the header, in disk format.
-  // You'll need to fseek() to the right location in the file.
-  DocIDElementHeader header(doc_id, num_positions);
-  header.ToDiskFormat();
+int WriteMergedIndex(
+    DocTable* dt, DocID_t first_doc_id, const vector<uint32_t>& lengths,
+    const function<bool(vector<unique_ptr<PostingsStream>>*)>& open_streams,
+    const char* file_name) {
+  Verify333(dt != nullptr);
 
-  if (fseek(f, offset, SEEK_SET) != 0) {
+  // The doc stats are the DocTable's, with the lengths filled in.
+  DocStats stats;
+  StartDocStats(dt, &stats);
+  for (size_t i = 0; i < lengths.size(); i++) {
+    if (lengths[i] == 0) {
+      continue;
+    }
+    DocID_t doc_id = first_doc_id + i;
+    if (doc_id < stats.first_doc_id
+        || doc_id - stats.first_doc_id >= stats.lengths.size()) {
+      cerr << "Error: merge holds a document that isn't in the doctable."
+           << endl;
+      return kFailedWrite;
+    }
+    stats.lengths[doc_id - stats.first_doc_id] = lengths[i];
+    stats.total_words += lengths[i];
+  }
+  stats.avg_doc_length =
+      BM25AverageDocLength(stats.num_docs, stats.total_words);
+
+  // The word table has to be laid out before any of it is written, so
+  // take a first pass over the streams to find out each word's on-disk
+  // key and size.
+  vector<HTKey_t> keys;
+  vector<int64_t> element_bytes;
+  vector<unique_ptr<PostingsStream>> streams;
+  if (!open_streams(&streams)) {
     return kFailedWrite;
   }
-
-  // Loop through the positions list, writing each position out.
-  if (fwrite(&header, sizeof(DocIDElementHeader), 1, f) != 1) {
+  PostingsMerger merger(&streams);
+  vector<PostingsDoc> docs;
+  vector<uint8_t> encoded;
+  while (merger.Next(&docs)) {
+    const string& word = merger.word();
+    EncodePostingsDocs(docs, stats, &encoded);
+    keys.push_back(FNVHash64(reinterpret_cast<unsigned char*>(
+                                 const_cast<char*>(word.data())),
+                             word.size()));
+    element_bytes.push_back(sizeof(WordPostingsHeader) + word.size()
+                            + encoded.size());
+  }
+  if (merger.failed()) {
     return kFailedWrite;
   }
 
-  int total_bytes_written = sizeof(DocIDElementHeader);
+  return WriteIndexFile(
+      dt, file_name, kMagicNumberV2, [&](IndexFileStream* out) {
+        return WriteIndexRegionV2(
+            out, stats, [&](IndexFileStream* out, TermDictEncoder* dict) {
+              vector<unique_ptr<PostingsStream>> streams;
+              return open_streams(&streams)
+                  && WriteMergedWordTable(out, &streams, stats, keys,
+                                          element_bytes, dict);
+            });
+      });
+}
 
-  DocIDElementPosition position;
-  LLIterator* it = LLIterator_Allocate(positions);
+static bool WriteRun(IndexFileStream* out, MemIndex* mi) {
+  // Gather the words, in order, and find the range of docIDs they're in.
+  vector<WordPostings*> words;
+  words.reserve(MemIndex_NumWords(mi));
+  DocID_t first_doc_id = 0, last_doc_id = 0;
+  bool first = true;
+  HTIterator* it = HTIterator_Allocate(mi);
   Verify333(it != nullptr);
+  while (HTIterator_IsValid(it)) {
+    HTKeyValue_t kv;
+    Verify333(HTIterator_Get(it, &kv));
+    WordPostings* wp = static_cast<WordPostings*>(kv.value);
+    words.push_back(wp);
+    HTIterator* doc_it = HTIterator_Allocate(wp->postings);
+    Verify333(doc_it != nullptr);
+    for (; HTIterator_IsValid(doc_it); first = false) {
+      HTKeyValue_t doc_kv;
+      Verify333(HTIterator_Get(doc_it, &doc_kv));
+      DocID_t doc_id = static_cast<DocID_t>(doc_kv.key);
+      first_doc_id = (first || doc_id < first_doc_id) ? doc_id : first_doc_id;
+      last_doc_id = (first || doc_id > last_doc_id) ? doc_id : last_doc_id;
+      HTIterator_Next(doc_it);
+    }
+    HTIterator_Free(doc_it);
+    HTIterator_Next(it);
+  }
+  HTIterator_Free(it);
+  sort(words.begin(), words.end(),
+       [](const WordPostings* a, const WordPostings* b) {
+         return strcmp(a->word, b->word) < 0;
+       });
+
+  // Write the documents' lengths, adding them up as ComputeDocStats()
+  // does.
+  vector<uint32_t> lengths(first ? 0 : last_doc_id - first_doc_id + 1, 0);
+  vector<pair<DocID_t, PositionList*>> docs;
+  for (WordPostings* wp : words) {
+    it = HTIterator_Allocate(wp->postings);
+    Verify333(it != nullptr);
+    while (HTIterator_IsValid(it)) {
+      HTKeyValue_t kv;
+      Verify333(HTIterator_Get(it, &kv));
+      lengths[kv.key - first_doc_id] +=
+          PositionList_NumPositions(static_cast<PositionList*>(kv.value));
+      HTIterator_Next(it);
+    }
+    HTIterator_Free(it);
+  }
+  vector<uint8_t> buffer;
+  AppendVarint(first_doc_id, &buffer);
+  AppendVarint(lengths.size(), &buffer);
+  for (uint32_t length : lengths) {
+    AppendVarint(length, &buffer);
+  }
+  if (!out->Write(buffer.data(), buffer.size())) {
+    return false;
+  }
 
-  for (int i = 0; i < num_positions; i++) {
-    // STEP 13.
-    // Get the next position from the list.
-    LLPayload_t payload;
-    LLIterator_Get(it, &payload);
+  // Then each word's record.
+  for (WordPostings* wp : words) {
+    docs.clear();
+    it = HTIterator_Allocate(wp->postings);
+    Verify333(it != nullptr);
+    while (HTIterator_IsValid(it)) {
+      HTKeyValue_t kv;
+      Verify333(HTIterator_Get(it, &kv));
+      docs.push_back({static_cast<DocID_t>(kv.key),
+                      static_cast<PositionList*>(kv.value)});
+      HTIterator_Next(it);
+    }
+    HTIterator_Free(it);
+    sort(docs.begin(), docs.end());
+
+    vector<uint8_t> doc_stream;
+    int64_t positions_bytes = 0;
+    DocID_t prev_doc_id = 0;
+    for (const auto& doc : docs) {
+      int num_bytes;
+      PositionList_Bytes(doc.second, &num_bytes);
+      AppendVarint(doc.first - prev_doc_id, &doc_stream);
+      AppendVarint(PositionList_NumPositions(doc.second), &doc_stream);
+      AppendVarint(num_bytes, &doc_stream);
+      positions_bytes += num_bytes;
+      prev_doc_id = doc.first;
+    }
+
+    size_t word_bytes = strlen(wp->word);
+    buffer.clear();
+    AppendVarint(word_bytes, &buffer);
+    buffer.insert(buffer.end(), wp->word, wp->word + word_bytes);
+    AppendVarint(docs.size(), &buffer);
+    AppendVarint(doc_stream.size(), &buffer);
+    AppendVarint(positions_bytes, &buffer);
+    if (!out->Write(buffer.data(), buffer.size())
+        || !out->Write(doc_stream.data(), doc_stream.size())) {
+      return false;
+    }
+    for (const auto& doc : docs) {
+      int num_bytes;
+      const uint8_t* bytes = PositionList_Bytes(doc.second, &num_bytes);
+      if (!out->Write(bytes, num_bytes)) {
+        return false;
+      }
+    }
+  }
 
-  // STEP 14.
-  // Truncate to 32 bits, then convert it to network order and write it out.
-  position.position = *reinterpret_cast<DocPositionOffset_t*>(&payload);
-  position.ToDiskFormat();
+  // A zero word length marks the end.
+  buffer.clear();
+  AppendVarint(0, &buffer);
+  return out->Write(buffer.data(), buffer.size());
+}
 
-  if (fwrite(&position, sizeof(DocIDElementPosition), 1, f) != 1) {
-    return kFailedWrite;
+static bool WriteMergedWordTable(IndexFileStream* out,
+                                 vector<unique_ptr<PostingsStream>>* streams,
+                                 const DocStats& stats,
+                                 const vector<HTKey_t>& keys,
+                                 const vector<int64_t>& element_bytes,
+                                 TermDictEncoder* dict) {
+  // This is the same table that WriteHashTable() would write, except
+  // that the elements all come after all of the ElementPositionRecords,
+  // in word order (which is the order the merge produces them in), rather
+  // than each bucket's after its own records.  The readers only find
+  // elements through the records, so they can't tell the difference.
+  int num_elements = keys.size();
+  int num_buckets = NumDiskBuckets(num_elements);
+  vector<int> bucket_start(num_buckets + 1, 0);
+  for (HTKey_t key : keys) {
+    bucket_start[key % num_buckets + 1]++;
+  }
+  for (int i = 0; i < num_buckets; i++) {
+    bucket_start[i + 1] += bucket_start[i];
   }
 
-  total_bytes_written += sizeof(DocIDElementPosition);
+  // Lay out the elements, filling in each bucket's ElementPositionRecords
+  // as we go.
+  int64_t records_start = out->position() + sizeof(BucketListHeader)
+    + num_buckets * sizeof(BucketRecord);
+  int64_t element_pos = records_start
+    + num_elements * sizeof(ElementPositionRecord);
+  vector<IndexFileOffset_t> records(num_elements);
+  vector<int> next_slot(bucket_start.begin(), bucket_start.end() - 1);
+  for (int i = 0; i < num_elements; i++) {
+    records[next_slot[keys[i] % num_buckets]++] = element_pos;
+    element_pos += element_bytes[i];
+    if (element_pos > INT32_MAX) {
+      cerr << "Error: index file would exceed " << INT32_MAX
+           << " bytes." << endl;
+      return false;
+    }
+  }
 
-      // Advance to the next position.
-      LLIterator_Next(it);
+  // Write the table's header, its bucket records, and all of the
+  // ElementPositionRecords.
+  if (!out->WriteRecord(BucketListHeader(num_buckets))) {
+    return false;
+  }
+  for (int i = 0; i < num_buckets; i++) {
+    BucketRecord record(bucket_start[i + 1] - bucket_start[i],
+                        records_start + bucket_start[i]
+                        * sizeof(ElementPositionRecord));
+    if (!out->WriteRecord(record)) {
+      return false;
     }
-    LLIterator_Free(it);
+  }
+  for (IndexFileOffset_t record : records) {
+    if (!out->WriteRecord(ElementPositionRecord(record))) {
+      return false;
+    }
+  }
 
-  // STEP 15.
-  // Calculate and return the total amount of data written.
-  return total_bytes_written;
+  // Then merge the streams again, this time writing out the elements.
+  PostingsMerger merger(streams);
+  vector<PostingsDoc> docs;
+  vector<uint8_t> encoded;
+  int i = 0;
+  while (merger.Next(&docs)) {
+    const string& word = merger.word();
+    EncodePostingsDocs(docs, stats, &encoded);
+
+    // The offsets we've already written are only right if the streams
+    // haven't changed under us.
+    int64_t element_start = out->position();
+    Verify333(i < num_elements);
+    Verify333(static_cast<int64_t>(sizeof(WordPostingsHeader) + word.size()
+                                   + encoded.size()) == element_bytes[i]);
+    if (!out->WriteRecord(WordPostingsHeader(word.size(), encoded.size()))
+        || !out->Write(word.data(), word.size())
+        || !out->Write(encoded.data(), encoded.size())) {
+      return false;
+    }
+    dict->Add(word.data(), word.size(), element_start);
+    i++;
+  }
+  return !merger.failed() && i == num_elements;
 }
 
-// This write_element_fn is used to write a WordPostings
-// element into the file at position 'offset'.
-static int WriteWordToPostingsFn(FILE* f,
-                                 IndexFileOffset_t offset,
-                                 HTKeyValue_t* kv) {
-  // Extract the WordPostings from the HTKeyValue_t.
-  WordPostings* wp = static_cast<WordPostings*>(kv->value);
-  Verify333(wp != nullptr);
+bool RunReader::Open(const char* file_name) {
+  file_ = fopen(file_name, "rb");
+  if (file_ == nullptr) {
+    failed_ = true;
+    return false;
+  }
+  setvbuf(file_, nullptr, _IOFBF, kRunBufferBytes);
 
-  // STEP 16.
-  // Prepare the wordlen field.
-  int16_t word_bytes = strlen(wp->word);
-  // you may need to change this logic
-
-  // Write the nested DocID->positions hashtable (i.e., the "docID
-  // table" element in the diagrams).  Use WriteHashTable() to do it,
-  // passing it the wp->postings table and using the
-  // WriteDocIDToPositionListFn helper function as the final parameter.
-  int ht_bytes = WriteHashTable(f,
-                        offset + sizeof(WordPostingsHeader) + word_bytes,
-                        wp->postings,
-                        &WriteDocIDToPositionListFn);
-
-  if (ht_bytes == kFailedWrite) {
-    return kFailedWrite;
+  uint64_t first_doc_id, num_lengths;
+  if (!ReadFileVarint(&first_doc_id) || !ReadFileVarint(&num_lengths)) {
+    failed_ = true;
+    return false;
+  }
+  first_doc_id_ = first_doc_id;
+  lengths_.clear();
+  for (uint64_t i = 0; i < num_lengths; i++) {
+    uint64_t length;
+    if (!ReadFileVarint(&length) || length > UINT32_MAX) {
+      failed_ = true;
+      return false;
+    }
+    lengths_.push_back(length);
   }
+  return true;
+}
 
-  // STEP 17.
-  // Write the header, in network order, in the right place in the file.
-  WordPostingsHeader header(word_bytes, ht_bytes);
-  header.ToDiskFormat();
+bool RunReader::Next() {
+  uint64_t word_bytes, docs_bytes, positions_bytes;
+  if (!ReadFileVarint(&word_bytes)) {
+    failed_ = true;
+    return false;
+  }
+  if (word_bytes == 0) {
+    // That's the end of the run.
+    return false;
+  }
+  if (word_bytes > INT16_MAX) {
+    failed_ = true;
+    return false;
+  }
+  word_.resize(word_bytes);
+  if (!ReadFileBytes(word_bytes, &word_[0])
+      || !ReadFileVarint(&num_docs_)
+      || !ReadFileVarint(&docs_bytes) || docs_bytes > INT32_MAX
+      || !ReadFileVarint(&positions_bytes) || positions_bytes > INT32_MAX) {
+    failed_ = true;
+    return false;
+  }
+  docs_.resize(docs_bytes);
+  positions_.resize(positions_bytes);
+  if (!ReadFileBytes(docs_bytes, docs_.data())
+      || !ReadFileBytes(positions_bytes, positions_.data())) {
+    failed_ = true;
+    return false;
+  }
+  return true;
+}
 
-  if (fseek(f, offset, SEEK_SET) != 0) {
-    return kFailedWrite;
+bool RunReader::GetDocs(vector<PostingsDoc>* docs) const {
+  const uint8_t* cursor = docs_.data();
+  const uint8_t* end = cursor + docs_.size();
+  DocID_t doc_id = 0;
+  size_t positions_offset = 0;
+  for (uint64_t i = 0; i < num_docs_; i++) {
+    uint64_t delta, num_positions, positions_bytes;
+    if (!ReadVarint(&cursor, end, &delta)
+        || !ReadVarint(&cursor, end, &num_positions)
+        || num_positions > INT32_MAX
+        || !ReadVarint(&cursor, end, &positions_bytes)
+        || positions_bytes > positions_.size() - positions_offset) {
+      return false;
+    }
+    doc_id += delta;
+    PostingsDoc doc;
+    doc.doc_id = doc_id;
+    doc.num_positions = num_positions;
+    doc.positions = positions_.data() + positions_offset;
+    doc.positions_bytes = positions_bytes;
+    docs->push_back(doc);
+    positions_offset += positions_bytes;
   }
+  return cursor == end && positions_offset == positions_.size();
+}
 
-  if (fwrite(&header, sizeof(WordPostingsHeader), 1, f) != 1) {
-    return kFailedWrite;
+bool RunReader::ReadFileVarint(uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 7 * kMaxVarintBytes; shift += 7) {
+    int byte = getc(file_);
+    if (byte == EOF) {
+      return false;
+    }
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
   }
+  return false;
+}
 
-  // STEP 18.
-  // Write the word itself, excluding the null terminator, in the right
-  // place in the file.
-  if (fwrite(wp->word, word_bytes, 1, f) != 1) {
-    return kFailedWrite;
+bool RunReader::ReadFileBytes(size_t len, void* data) {
+  return fread(data, 1, len, file_) == len;
+}
+
+static bool OpenRuns(const vector<string>& run_files,
+                     vector<unique_ptr<PostingsStream>>* runs) {
+  for (const string& run_file : run_files) {
+    RunReader* run = new RunReader();
+    runs->emplace_back(run);
+    if (!run->Open(run_file.c_str())) {
+      cerr << "Error: Failed to open run file " << run_file << "." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+PostingsMerger::PostingsMerger(vector<unique_ptr<PostingsStream>>* streams)
+  : streams_(std::move(*streams)), failed_(false) {
+  // Let Next() read each stream's first word.
+  for (size_t i = 0; i < streams_.size(); i++) {
+    current_.push_back(i);
+  }
+}
+
+bool PostingsMerger::Next(vector<PostingsDoc>* docs) {
+  auto compare = [this](int a, int b) { return HeapCompare(a, b); };
+
+  // Move the streams we returned last time on to their next words.
+  for (int stream : current_) {
+    if (streams_[stream]->Next()) {
+      heap_.push_back(stream);
+      push_heap(heap_.begin(), heap_.end(), compare);
+    } else if (streams_[stream]->failed()) {
+      failed_ = true;
+    }
+  }
+  current_.clear();
+  if (failed_ || heap_.empty()) {
+    return false;
+  }
+
+  // Then take every stream whose word is the smallest.  They come off the
+  // heap in stream order.
+  do {
+    pop_heap(heap_.begin(), heap_.end(), compare);
+    current_.push_back(heap_.back());
+    heap_.pop_back();
+  } while (!heap_.empty()
+           && streams_[heap_.front()]->word()
+              == streams_[current_[0]]->word());
+
+  docs->clear();
+  for (int stream : current_) {
+    size_t first = docs->size();
+    if (!streams_[stream]->GetDocs(docs)
+        || (first > 0 && docs->size() > first
+            && (*docs)[first].doc_id <= (*docs)[first - 1].doc_id)) {
+      cerr << "Error: malformed postings for \"" << word() << "\"." << endl;
+      failed_ = true;
+      return false;
+    }
   }
+  return true;
+}
 
-  // STEP 19.
-  // Calculate and return the total amount of data written.
-  int total_bytes_written = sizeof(WordPostingsHeader) + word_bytes + ht_bytes;
-  return total_bytes_written;  // you may need to change this return value
+bool PostingsMerger::HeapCompare(int a, int b) const {
+  // The standard heap functions keep the largest element at the front,
+  // so this is backwards.
+  int order = streams_[a]->word().compare(streams_[b]->word());
+  return order > 0 || (order == 0 && a > b);
 }
-} // namespace hw3
+
+}  // namespace hw3
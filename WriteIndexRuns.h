@@ -0,0 +1,132 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_WRITEINDEXRUNS_H_
+#define HW3_WRITEINDEXRUNS_H_
+
+#include <stdint.h>    // for uint8_t, uint32_t.
+#include <functional>  // for std::function.
+#include <memory>      // for std::unique_ptr.
+#include <string>      // for std::string.
+#include <vector>      // for std::vector.
+
+extern "C" {
+  #include "libhw2/DocTable.h"
+  #include "libhw2/MemIndex.h"
+}
+#include "./Utils.h"  // for DISALLOW_COPY_AND_ASSIGN().
+
+namespace hw3 {
+
+// An index too big to hold in memory can be built a piece at a time: each
+// piece's MemIndex is written out as a "run" file, and then all of the
+// runs are merged into a single index file (see BuildIndex()).
+//
+// A run file is private to the build, so it's laid out for streaming
+// rather than lookups.  It starts with the lengths of the run's
+// documents:
+//
+//   varint  the run's first docID
+//   varint  the number of lengths that follow
+//   varint  the length of each docID from the first on, in order
+//
+// and then has one record per word, in strcmp() order:
+//
+//   varint  the length of the word, then the word's bytes
+//   varint  num_docs
+//   varint  docs_bytes       (the length of the doc stream)
+//   varint  positions_bytes  (the length of the position stream)
+//   doc stream:      for each doc, in increasing docID order:
+//                      varint  docID - previous docID (or docID itself)
+//                      varint  num_positions
+//                      varint  its share of the position stream, in bytes
+//   position stream: exactly as in a v2 posting list.
+//
+// The last record is followed by a zero word length.
+
+// Writes the MemIndex "mi" to the run file "file_name", creating or
+// truncating it.  Returns the number of bytes written, or a negative
+// value on failure (in which case the file is removed).
+int WriteIndexRun(MemIndex* mi, const char* file_name);
+
+// Merges "run_files" into a v2 index file, "file_name", whose documents
+// are those of "dt".  The runs must hold disjoint ranges of docIDs, in
+// increasing order, as they do when they're written as a crawl goes
+// along.  The result holds the same words, postings, and doc stats as
+// WriteIndex() would have written for a single MemIndex holding all of
+// the runs.  See WriteMergedIndex() for what the merge costs.
+//
+// Returns the number of bytes written, or a negative value on failure (in
+// which case "file_name" is removed).  The run files are left alone.
+int MergeIndexRuns(const std::vector<std::string>& run_files, DocTable* dt,
+                   const char* file_name);
+
+// One document of a posting list that's being merged.
+struct PostingsDoc {
+  DocID_t        doc_id;
+  int            num_positions;
+  const uint8_t* positions;        // delta-encoded, as in a position stream
+  int            positions_bytes;  // the length of "positions"
+};
+
+// A PostingsStream reads the words of one input to a merge, each with its
+// postings, in strcmp() order.  RunReader reads run files this way, and
+// IndexMerger.cc reads index files.
+class PostingsStream {
+ public:
+  PostingsStream() { }
+  virtual ~PostingsStream() { }
+
+  // Moves on to the next word, starting with the first.  Returns false
+  // once there are no more, or on error (in which case failed() is true).
+  virtual bool Next() = 0;
+
+  // The current word.
+  virtual const std::string& word() const = 0;
+
+  // Appends the current word's documents to "docs", in increasing docID
+  // order.  Their positions belong to the stream, and are only good
+  // until the next Next().  Returns false if the postings are malformed.
+  virtual bool GetDocs(std::vector<PostingsDoc>* docs) const = 0;
+
+  // Returns true if Next() stopped because of an error.
+  virtual bool failed() const = 0;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PostingsStream);
+};
+
+// Writes a v2 index file, "file_name", whose documents are those of "dt"
+// and whose words are those of a set of PostingsStreams, merged: a word's
+// posting list holds its documents from every stream, in stream order.
+// So for every word, each stream's docIDs must be greater than those of
+// the streams before it.  lengths[i] is the length of document
+// first_doc_id + i, for the doc stats section; any others are taken to
+// be 0.
+//
+// The streams are read twice, once to lay the word table out and once to
+// write it, and "open_streams" is called to open them each time.  It must
+// append the same streams to its argument both times, or return false on
+// error.  Besides the DocTable, the merge holds a few dozen bytes per
+// distinct word in memory, plus one word's postings from each stream at
+// a time.
+//
+// Returns the number of bytes written, or a negative value on failure (in
+// which case "file_name" is removed).
+int WriteMergedIndex(
+    DocTable* dt, DocID_t first_doc_id, const std::vector<uint32_t>& lengths,
+    const std::function<bool(std::vector<std::unique_ptr<PostingsStream>>*)>&
+        open_streams,
+    const char* file_name);
+
+}  // namespace hw3
+
+#endif  // HW3_WRITEINDEXRUNS_H_
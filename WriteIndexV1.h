@@ -0,0 +1,33 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW3_WRITEINDEXV1_H_
+#define HW3_WRITEINDEXV1_H_
+
+extern "C" {
+  #include "libhw2/DocTable.h"
+  #include "libhw2/MemIndex.h"
+}
+
+namespace hw3 {
+
+// Like WriteIndex(), but writes the index in the original (v1) file
+// format, with a nested docid->positions hash table per word, rather than
+// the compact v2 format (see LayoutStructsV2.h).  Use this to produce
+// files for readers that predate v2, such as FileIndexReader's
+// IndexTableReader.
+//
+// Arguments and return value are as for WriteIndex().
+int WriteIndexV1(MemIndex* mi, DocTable* dt, const char* file_name);
+
+}  // namespace hw3
+
+#endif  // HW3_WRITEINDEXV1_H_
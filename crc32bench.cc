@@ -0,0 +1,176 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>   // for uint8_t, uint32_t.
+#include <algorithm>  // for std::min().
+#include <chrono>     // for std::chrono::steady_clock, etc.
+#include <cstdlib>    // for EXIT_SUCCESS, EXIT_FAILURE, atoi().
+#include <iostream>   // for std::cout, std::cerr, etc.
+#include <random>     // for std::mt19937, etc.
+#include <vector>     // for std::vector.
+
+#include "./FastCRC32.h"
+#include "./Utils.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::vector;
+
+// The longest buffer checked, and the furthest it's offset from an
+// aligned address.
+static const int kMaxLength = 64 * 1024;
+static const int kMaxMisalignment = 15;
+
+// How many bytes each throughput measurement folds.
+static const size_t kBenchBytes = 64 << 20;
+
+// Error usage message for the client to see
+// Arguments:
+// - prog_name: Name of the program
+static void Usage(char* prog_name);
+
+// Returns the CRC32 of "len" bytes at "buf", one byte at a time through
+// the reference implementation in Utils.h.
+static uint32_t ReferenceCRC(const uint8_t* buf, int len);
+
+// Returns the throughput of "fold", which folds "len" bytes at "buf", in
+// MB/s, repeating it until it's folded kBenchBytes.
+template <typename Fold>
+static double Throughput(const uint8_t* buf, size_t len, Fold fold);
+
+// Checks that FastCRC32 computes exactly the checksum that Utils.h's
+// CRC32 does, and measures how much faster it is:
+//
+//   ./crc32bench [num_trials]
+//
+// Each trial checksums a random buffer of 0 to 64 KiB, starting up to 15
+// bytes past an aligned address, four ways: with the reference CRC32,
+// with FastCRC32's FoldByteIntoCRC() and FoldBytes(), and with a random
+// mix of the two, which exercises the bulk paths' handling of a
+// checksum that's already under way.  Exits with EXIT_FAILURE if any of
+// them disagree.
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    Usage(argv[0]);
+  }
+  int num_trials = (argc == 2) ? atoi(argv[1]) : 3000;
+  if (num_trials <= 0) {
+    Usage(argv[0]);
+  }
+
+  mt19937 rng(333);
+  uniform_int_distribution<int> byte_dist(0, 255);
+  uniform_int_distribution<int> length_dist(0, kMaxLength);
+  uniform_int_distribution<int> offset_dist(0, kMaxMisalignment);
+  vector<uint8_t> data(kMaxLength + kMaxMisalignment);
+  for (uint8_t& b : data) {
+    b = byte_dist(rng);
+  }
+
+  int num_failures = 0;
+  for (int i = 0; i < num_trials; i++) {
+    int len = length_dist(rng);
+    const uint8_t* buf = data.data() + offset_dist(rng);
+    uint32_t expected = ReferenceCRC(buf, len);
+
+    hw3::FastCRC32 per_byte;
+    for (int j = 0; j < len; j++) {
+      per_byte.FoldByteIntoCRC(buf[j]);
+    }
+    hw3::FastCRC32 bulk;
+    bulk.FoldBytes(buf, len);
+
+    // Fold a random prefix in bulk, a few bytes singly, and then the
+    // rest in bulk.
+    int prefix = uniform_int_distribution<int>(0, len)(rng);
+    int singles = std::min(len - prefix,
+                           uniform_int_distribution<int>(0, 9)(rng));
+    hw3::FastCRC32 mixed;
+    mixed.FoldBytes(buf, prefix);
+    for (int j = prefix; j < prefix + singles; j++) {
+      mixed.FoldByteIntoCRC(buf[j]);
+    }
+    mixed.FoldBytes(buf + prefix + singles, len - prefix - singles);
+
+    uint32_t got[] = {per_byte.GetFinalCRC(), bulk.GetFinalCRC(),
+                      mixed.GetFinalCRC()};
+    for (uint32_t crc : got) {
+      if (crc != expected) {
+        if (num_failures++ < 10) {
+          cerr << "Mismatch: length " << len << ", misaligned by "
+               << (buf - data.data()) << ": expected " << std::hex
+               << expected << ", got " << crc << std::dec << endl;
+        }
+      }
+    }
+  }
+  cout << num_trials << " trials, " << num_failures << " mismatches."
+       << endl;
+
+  const uint8_t* buf = data.data() + 1;
+  const size_t len = kMaxLength;
+  cout << "CRC32::FoldByteIntoCRC():     "
+       << Throughput(buf, len, [](const uint8_t* b, size_t n) {
+            hw3::CRC32 crc;
+            for (size_t i = 0; i < n; i++) {
+              crc.FoldByteIntoCRC(b[i]);
+            }
+            return crc.GetFinalCRC();
+          })
+       << " MB/s" << endl;
+  cout << "FastCRC32::FoldByteIntoCRC(): "
+       << Throughput(buf, len, [](const uint8_t* b, size_t n) {
+            hw3::FastCRC32 crc;
+            for (size_t i = 0; i < n; i++) {
+              crc.FoldByteIntoCRC(b[i]);
+            }
+            return crc.GetFinalCRC();
+          })
+       << " MB/s" << endl;
+  cout << "FastCRC32::FoldBytes():       "
+       << Throughput(buf, len, [](const uint8_t* b, size_t n) {
+            hw3::FastCRC32 crc;
+            crc.FoldBytes(b, n);
+            return crc.GetFinalCRC();
+          })
+       << " MB/s" << endl;
+
+  return (num_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void Usage(char* prog_name) {
+  cerr << "Usage: " << prog_name << " [num_trials]" << endl;
+  exit(EXIT_FAILURE);
+}
+
+static uint32_t ReferenceCRC(const uint8_t* buf, int len) {
+  hw3::CRC32 crc;
+  for (int i = 0; i < len; i++) {
+    crc.FoldByteIntoCRC(buf[i]);
+  }
+  return crc.GetFinalCRC();
+}
+
+template <typename Fold>
+static double Throughput(const uint8_t* buf, size_t len, Fold fold) {
+  // Accumulate the checksums, so that the folds can't be optimized away.
+  volatile uint32_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t done = 0; done < kBenchBytes; done += len) {
+    sink = sink ^ fold(buf, len);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return kBenchBytes / elapsed.count() / (1 << 20);
+}
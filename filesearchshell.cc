@@ -9,7 +9,8 @@
  * author.
  */
 
-#include <cstdlib>   // for EXIT_SUCCESS, EXIT_FAILURE
+#include <climits>   // for INT_MAX
+#include <cstdlib>   // for EXIT_SUCCESS, EXIT_FAILURE, atoi()
 #include <iostream>  // for std::cout, std::cerr, etc.
 #include <cctype>  
 #include <sstream>  
@@ -17,6 +18,7 @@
 #include <string>
 #include <list>    
 
+#include "./IncrementalIndex.h"
 #include "./QueryProcessor.h"
 
 using std::cerr;
@@ -99,9 +101,23 @@ int main(int argc, char** argv) {
   // Implement filesearchshell!
   // Probably want to write some helper methods ...
 
+  // "-n num_results" shows only the best num_results results of each
+  // query, which lets the QueryProcessor skip ranking the rest (see
+  // QueryProcessor.h).  By default, every result is shown.
+  int max_results = INT_MAX;
+  int first_index = 1;
+  if (string(argv[1]) == "-n") {
+    if (argc < 4 || (max_results = atoi(argv[2])) <= 0) {
+      Usage(argv[0]);
+    }
+    first_index = 3;
+  }
+
   list<string> index_files;
-  for (int i = 1; i < argc; i++) {
-    index_files.push_back(argv[i]);
+  for (int i = first_index; i < argc; i++) {
+    // An index kept up to date by updateindex may have a delta, which
+    // has to be searched first.
+    index_files.splice(index_files.end(), hw3::IndexSegments(argv[i]));
   }
 
   QueryProcessor qp(index_files, true);
@@ -113,10 +129,8 @@ int main(int argc, char** argv) {
 
     if (!cin.good()) break;
 
-    for (char& ch : query) {
-      ch = tolower(ch);
-    }
-
+    // Words are lowercased by the query parser, which needs to see the
+    // case of the AND, OR, and NOT operators.
     std::stringstream ss(query);
     vector<string> query_words;
     string word;
@@ -126,7 +140,7 @@ int main(int argc, char** argv) {
 
     if (query_words.empty()) continue;
 
-    auto results = qp.ProcessQuery(query_words);
+    auto results = qp.ProcessQuery(query_words, max_results, 0);
     if (results.empty()) {
       cout << " [no result] " << endl;
       continue;
@@ -141,6 +155,6 @@ int main(int argc, char** argv) {
 }
 
 static void Usage(char* prog_name) {
-  cerr << "Usage: " << prog_name << " [index files+]" << endl;
+  cerr << "Usage: " << prog_name << " [-n num_results] [index files+]" << endl;
   exit(EXIT_FAILURE);
 }
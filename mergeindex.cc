@@ -0,0 +1,65 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <cstdlib>   // for EXIT_SUCCESS, EXIT_FAILURE
+#include <iostream>  // for std::cout, std::cerr, etc.
+#include <string>
+#include <vector>
+
+#include "./IndexMerger.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Error usage message for the client to see
+// Arguments:
+// - prog_name: Name of the program
+static void Usage(char* prog_name);
+
+// Merges a set of index files into one, so that there are fewer files
+// for a query to fan out to:
+//
+//   ./mergeindex merged.idx ./foo.idx ./bar/baz.idx /tmp/blah.idx [etc]
+//
+// A document that's in more than one of the input files is kept from the
+// first one, so list the newest files first.  The output file mustn't be
+// one of the inputs.
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    Usage(argv[0]);
+  }
+
+  string output = argv[1];
+  vector<string> index_files;
+  for (int i = 2; i < argc; i++) {
+    if (output == argv[i]) {
+      cerr << "The output file can't also be an input file." << endl;
+      Usage(argv[0]);
+    }
+    index_files.push_back(argv[i]);
+  }
+
+  int bytes = hw3::MergeIndexFiles(index_files, output.c_str());
+  if (bytes < 0) {
+    cerr << "Failed to merge the index files into " << output << "." << endl;
+    return EXIT_FAILURE;
+  }
+  cout << "Wrote " << bytes << " bytes to " << output << "." << endl;
+  return EXIT_SUCCESS;
+}
+
+static void Usage(char* prog_name) {
+  cerr << "Usage: " << prog_name << " output_file [index files+]" << endl;
+  exit(EXIT_FAILURE);
+}
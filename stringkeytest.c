@@ -0,0 +1,343 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// A stress test of the string-keyed tables' collision handling (see
+// StringKey.h).  It's only meaningful when libhw2 is built with a small
+// STRINGKEY_HASH_BITS, which makes many of its words share a hash, e.g.:
+//
+//   gcc -DSTRINGKEY_HASH_BITS=16 -I.. -o stringkeytest stringkeytest.c
+//       StringKey.c MemIndex.c DocTable.c FileParser.c Arena.c
+//       PositionList.c ../libhw1/libhw1.a
+//   ./stringkeytest [num_words]
+//
+// It checks that the MemIndex, the DocTable, and both of FileParser's
+// word tables return the right entry for every word, colliding or not,
+// and exits with EXIT_FAILURE if any of them doesn't.  It also fails if
+// none of the words collide, since then it has tested nothing.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhw1/CSE333.h"
+#include "libhw1/HashTable.h"
+#include "libhw1/LinkedList.h"
+#include "./Arena.h"
+#include "./DocTable.h"
+#include "./FileParser.h"
+#include "./MemIndex.h"
+#include "./StringKey.h"
+#include "./WordPositionArray.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Helper function declarations, constants, etc
+
+// Each word is "w" plus this many letters, so every word is the same
+// length and the parser finds them all.
+#define WORD_LETTERS 4
+
+// Sets "word" to the i'th test word.
+static void MakeWord(int i, char word[WORD_LETTERS + 2]);
+
+// Returns how many of the "num_words" words share their hash with an
+// earlier one.
+static int CountCollisions(char** words, int num_words);
+
+// Builds a file of every word, twice over, sets "first_pos" and
+// "second_pos" to each word's two offsets in it, and returns it.
+static char* MakeFileContents(char** words, int num_words,
+                              DocPositionOffset_t* first_pos,
+                              DocPositionOffset_t* second_pos);
+
+// The checks.  Each returns how many words it got the wrong entry for.
+static int CheckMemIndex(char** words, int num_words);
+static int CheckDocTable(char** words, int num_words);
+static int CheckWordPositions(char** words, int num_words);
+static int CheckWordPositionArrays(char** words, int num_words);
+
+// Frees a HashTable value that needs no freeing.
+static void NoOpFree(HTValue_t payload);
+
+// StringKeyFns for FileParser's two kinds of table.
+static const char* WordPositionsWord(HTValue_t payload, void* arg);
+static const char* WordPositionArrayWord(HTValue_t payload, void* arg);
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Main
+int main(int argc, char** argv) {
+  int num_words = (argc > 1) ? atoi(argv[1]) : 20000;
+  int num_collisions, num_failures, i;
+  char** words;
+
+  if (argc > 2 || num_words <= 0 || num_words > 26 * 26 * 26 * 26) {
+    fprintf(stderr, "Usage: %s [num_words]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  words = (char**) malloc(num_words * sizeof(char*));
+  Verify333(words != NULL);
+  for (i = 0; i < num_words; i++) {
+    words[i] = (char*) malloc(WORD_LETTERS + 2);
+    Verify333(words[i] != NULL);
+    MakeWord(i, words[i]);
+  }
+
+  num_collisions = CountCollisions(words, num_words);
+  printf("%d words, %d of them colliding with an earlier one.\n",
+         num_words, num_collisions);
+  if (num_collisions == 0) {
+    // Nothing would exercise the collision handling, so passing would
+    // prove nothing.
+    fprintf(stderr, "No collisions: rebuild StringKey.c with a small "
+            "STRINGKEY_HASH_BITS, such as 16.\n");
+    num_failures = 1;
+  } else {
+    num_failures = CheckMemIndex(words, num_words);
+    num_failures += CheckDocTable(words, num_words);
+    num_failures += CheckWordPositions(words, num_words);
+    num_failures += CheckWordPositionArrays(words, num_words);
+    printf("%d failures.\n", num_failures);
+  }
+
+  for (i = 0; i < num_words; i++) {
+    free(words[i]);
+  }
+  free(words);
+  return (num_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Helper function definitions
+
+static void MakeWord(int i, char word[WORD_LETTERS + 2]) {
+  int j;
+  word[0] = 'w';
+  for (j = WORD_LETTERS; j > 0; j--) {
+    word[j] = 'a' + i % 26;
+    i /= 26;
+  }
+  word[WORD_LETTERS + 1] = '\0';
+}
+
+static int CountCollisions(char** words, int num_words) {
+  HashTable* hashes = HashTable_Allocate(num_words);
+  HTKeyValue_t kv, old_kv;
+  int num_collisions = 0, i;
+
+  for (i = 0; i < num_words; i++) {
+    kv.key = StringKey_Hash(words[i]);
+    kv.value = NULL;
+    if (HashTable_Insert(hashes, kv, &old_kv)) {
+      num_collisions++;
+    }
+  }
+  HashTable_Free(hashes, &NoOpFree);
+  return num_collisions;
+}
+
+static char* MakeFileContents(char** words, int num_words,
+                              DocPositionOffset_t* first_pos,
+                              DocPositionOffset_t* second_pos) {
+  int len = 2 * num_words * (WORD_LETTERS + 2);
+  char* contents = (char*) malloc(len + 1);
+  char* next = contents;
+  int pass, i;
+
+  Verify333(contents != NULL);
+  for (pass = 0; pass < 2; pass++) {
+    for (i = 0; i < num_words; i++) {
+      DocPositionOffset_t* pos = (pass == 0) ? first_pos : second_pos;
+      pos[i] = next - contents;
+      memcpy(next, words[i], WORD_LETTERS + 1);
+      next += WORD_LETTERS + 1;
+      *next++ = ' ';
+    }
+  }
+  *next = '\0';
+  return contents;
+}
+
+static int CheckMemIndex(char** words, int num_words) {
+  MemIndex* index = MemIndex_Allocate();
+  int num_failures = 0, i;
+
+  // Give each word its own document, so that finding the wrong word's
+  // postings gives the wrong docID.
+  for (i = 0; i < num_words; i++) {
+    DocPositionOffset_t position = i;
+    WordPositionArray wpa = {words[i], &position, 1, 1};
+    MemIndex_AddWordPositionArray(index, &wpa, i + 1);
+  }
+  if (MemIndex_NumWords(index) != num_words) {
+    printf("MemIndex: %d words, expected %d\n", MemIndex_NumWords(index),
+           num_words);
+    num_failures++;
+  }
+
+  for (i = 0; i < num_words; i++) {
+    LinkedList* results = MemIndex_Search(index, &words[i], 1);
+    SearchResult* result;
+    if (results == NULL || LinkedList_NumElements(results) != 1) {
+      printf("MemIndex: wrong number of results for \"%s\"\n", words[i]);
+      num_failures++;
+    } else {
+      LinkedList_Pop(results, (LLPayload_t*) &result);
+      if (result->doc_id != (DocID_t) i + 1 || result->rank != 1) {
+        printf("MemIndex: \"%s\" found docID %" PRIu64 "\n", words[i],
+               result->doc_id);
+        num_failures++;
+      }
+      free(result);
+    }
+    if (results != NULL) {
+      LinkedList_Free(results, &free);
+    }
+  }
+  MemIndex_Free(index);
+  return num_failures;
+}
+
+static int CheckDocTable(char** words, int num_words) {
+  DocTable* table = DocTable_Allocate();
+  DocID_t* doc_ids = (DocID_t*) malloc(num_words * sizeof(DocID_t));
+  int num_failures = 0, i;
+
+  Verify333(doc_ids != NULL);
+  for (i = 0; i < num_words; i++) {
+    doc_ids[i] = DocTable_Add(table, words[i]);
+  }
+  if (DocTable_NumDocs(table) != num_words) {
+    printf("DocTable: %d documents, expected %d\n", DocTable_NumDocs(table),
+           num_words);
+    num_failures++;
+  }
+
+  for (i = 0; i < num_words; i++) {
+    if (DocTable_GetDocID(table, words[i]) != doc_ids[i]
+        || strcmp(DocTable_GetDocName(table, doc_ids[i]), words[i]) != 0) {
+      printf("DocTable: wrong docID for \"%s\"\n", words[i]);
+      num_failures++;
+    }
+  }
+  free(doc_ids);
+  DocTable_Free(table);
+  return num_failures;
+}
+
+static int CheckWordPositions(char** words, int num_words) {
+  DocPositionOffset_t* first_pos = (DocPositionOffset_t*)
+      malloc(2 * num_words * sizeof(DocPositionOffset_t));
+  DocPositionOffset_t* second_pos = first_pos + num_words;
+  HashTable* table;
+  int num_failures = 0, i;
+
+  Verify333(first_pos != NULL);
+  table = ParseIntoWordPositionsTable(
+      MakeFileContents(words, num_words, first_pos, second_pos));
+  Verify333(table != NULL);
+  if (HashTable_NumElements(table) != num_words) {
+    printf("WordPositions: %d words, expected %d\n",
+           HashTable_NumElements(table), num_words);
+    num_failures++;
+  }
+
+  for (i = 0; i < num_words; i++) {
+    HTKeyValue_t kv;
+    HTKey_t unused;
+    WordPositions* wp;
+    LLPayload_t pos[2];
+    LLIterator* it;
+
+    if (!StringKey_Find(table, words[i], &WordPositionsWord, NULL, &kv,
+                        &unused)) {
+      printf("WordPositions: \"%s\" is missing\n", words[i]);
+      num_failures++;
+      continue;
+    }
+    wp = (WordPositions*) kv.value;
+    if (LinkedList_NumElements(wp->positions) != 2) {
+      printf("WordPositions: \"%s\" has the wrong positions\n", words[i]);
+      num_failures++;
+      continue;
+    }
+    it = LLIterator_Allocate(wp->positions);
+    Verify333(it != NULL);
+    LLIterator_Get(it, &pos[0]);
+    LLIterator_Next(it);
+    LLIterator_Get(it, &pos[1]);
+    LLIterator_Free(it);
+    if ((DocPositionOffset_t) (intptr_t) pos[0] != first_pos[i]
+        || (DocPositionOffset_t) (intptr_t) pos[1] != second_pos[i]) {
+      printf("WordPositions: \"%s\" has the wrong positions\n", words[i]);
+      num_failures++;
+    }
+  }
+  FreeWordPositionsTable(table);
+  free(first_pos);
+  return num_failures;
+}
+
+static int CheckWordPositionArrays(char** words, int num_words) {
+  DocPositionOffset_t* first_pos = (DocPositionOffset_t*)
+      malloc(2 * num_words * sizeof(DocPositionOffset_t));
+  DocPositionOffset_t* second_pos = first_pos + num_words;
+  Arena* arena = Arena_Allocate();
+  HashTable* table;
+  int num_failures = 0, i;
+
+  Verify333(first_pos != NULL);
+  table = ParseIntoWordPositionArrays(
+      MakeFileContents(words, num_words, first_pos, second_pos), arena);
+  Verify333(table != NULL);
+  if (HashTable_NumElements(table) != num_words) {
+    printf("WordPositionArrays: %d words, expected %d\n",
+           HashTable_NumElements(table), num_words);
+    num_failures++;
+  }
+
+  for (i = 0; i < num_words; i++) {
+    HTKeyValue_t kv;
+    HTKey_t unused;
+    WordPositionArray* wpa;
+
+    if (!StringKey_Find(table, words[i], &WordPositionArrayWord, NULL, &kv,
+                        &unused)) {
+      printf("WordPositionArrays: \"%s\" is missing\n", words[i]);
+      num_failures++;
+      continue;
+    }
+    wpa = (WordPositionArray*) kv.value;
+    if (wpa->num_positions != 2 || wpa->positions[0] != first_pos[i]
+        || wpa->positions[1] != second_pos[i]) {
+      printf("WordPositionArrays: \"%s\" has the wrong positions\n",
+             words[i]);
+      num_failures++;
+    }
+  }
+  FreeWordPositionArrays(table);
+  Arena_Free(arena);
+  free(first_pos);
+  return num_failures;
+}
+
+static void NoOpFree(HTValue_t payload) { }
+
+static const char* WordPositionsWord(HTValue_t payload, void* arg) {
+  return ((WordPositions*) payload)->word;
+}
+
+static const char* WordPositionArrayWord(HTValue_t payload, void* arg) {
+  return ((WordPositionArray*) payload)->word;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>   // for int64_t.
+#include <algorithm>  // for std::sort(), std::min().
+#include <chrono>     // for std::chrono::steady_clock, etc.
+#include <cstdlib>    // for EXIT_SUCCESS, EXIT_FAILURE.
+#include <iostream>   // for std::cout, std::cerr, etc.
+#include <list>       // for std::list.
+#include <memory>     // for std::unique_ptr.
+#include <random>     // for std::mt19937, etc.
+#include <string>     // for std::string.
+#include <utility>    // for std::pair.
+#include <vector>     // for std::vector.
+
+#include "./IndexFileSource.h"
+#include "./IndexTableView.h"
+#include "./PostingsView.h"
+#include "./QueryProcessor.h"
+#include "./TermDictView.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::list;
+using std::mt19937;
+using std::pair;
+using std::string;
+using std::uniform_int_distribution;
+using std::unique_ptr;
+using std::vector;
+using hw3::QueryProcessor;
+
+// The page size that the checked requests use, which is http333d's: it
+// asks for one page plus one more result, to tell whether there's a
+// next page.
+static const int kResultsPerPage = 20;
+
+// How many pages of each query are checked.
+static const int kPagesPerQuery = 3;
+
+// How many of the first index file's most common words the queries are
+// made of.  Common words have the most documents to prune.
+static const int kNumCommonWords = 100;
+
+// How many queries are checked.
+static const int kNumQueries = 300;
+
+// Error usage message for the client to see
+// Arguments:
+// - prog_name: Name of the program
+static void Usage(char* prog_name);
+
+// Returns up to kNumCommonWords of the words of "index_file" that are
+// in the most documents.
+static vector<string> CommonWords(const string& index_file);
+
+// Returns a random query of "words": a single word, an AND, an OR, a
+// NOT, a prefix, or an AND of an OR.
+static vector<string> MakeQuery(const vector<string>& words, mt19937* rng);
+
+// Returns "query"'s words joined by spaces, for messages.
+static string QueryString(const vector<string>& query);
+
+// Returns true if "got" is exactly "expected", in order and by rank.
+static bool SameResults(const vector<QueryProcessor::QueryResult>& got,
+                        const vector<QueryProcessor::QueryResult>& expected);
+
+// Checks that the top-K pruning done by ProcessQuery(query, k, offset),
+// without a total, gives exactly the results of ranking every match:
+//
+//   ./topktest index_files+
+//
+// Each query is made of the first index file's most common words, and
+// for each of its first few pages, the test asks for a page plus one
+// more result, just as http333d's /query does.  It compares that with
+// the same slice of ProcessQuery(query)'s full ranking, and with the
+// same request with an exact count, which can't prune.  The counts
+// must match the full ranking's size, too.  Exits with EXIT_FAILURE if
+// anything differs, and reports how long the pruned and the counted
+// requests took.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    Usage(argv[0]);
+  }
+  list<string> index_files;
+  for (int i = 1; i < argc; i++) {
+    index_files.push_back(argv[i]);
+  }
+  QueryProcessor qp(index_files, true);
+
+  vector<string> words = CommonWords(index_files.front());
+  if (words.empty()) {
+    cerr << index_files.front() << " has no words." << endl;
+    return EXIT_FAILURE;
+  }
+
+  mt19937 rng(333);
+  std::chrono::duration<double> pruned_time(0), counted_time(0);
+  int num_failures = 0, num_pages = 0;
+  for (int i = 0; i < kNumQueries; i++) {
+    vector<string> query = MakeQuery(words, &rng);
+    vector<QueryProcessor::QueryResult> all = qp.ProcessQuery(query);
+
+    for (int page = 0; page < kPagesPerQuery; page++) {
+      const int offset = page * kResultsPerPage;
+      vector<QueryProcessor::QueryResult> expected(
+          all.begin() + std::min<size_t>(offset, all.size()),
+          all.begin() + std::min<size_t>(offset + kResultsPerPage + 1,
+                                         all.size()));
+
+      auto start = std::chrono::steady_clock::now();
+      vector<QueryProcessor::QueryResult> pruned =
+          qp.ProcessQuery(query, kResultsPerPage + 1, offset);
+      auto middle = std::chrono::steady_clock::now();
+      int num_results = -1;
+      vector<QueryProcessor::QueryResult> counted =
+          qp.ProcessQuery(query, kResultsPerPage + 1, offset, &num_results);
+      auto end = std::chrono::steady_clock::now();
+      pruned_time += middle - start;
+      counted_time += end - middle;
+      num_pages++;
+
+      const char* problem = nullptr;
+      if (!SameResults(pruned, expected)) {
+        problem = "pruned results differ";
+      } else if (!SameResults(counted, expected)) {
+        problem = "counted results differ";
+      } else if (num_results != static_cast<int>(all.size())) {
+        problem = "wrong count";
+      }
+      if (problem != nullptr && num_failures++ < 10) {
+        cerr << "\"" << QueryString(query) << "\", offset " << offset
+             << ": " << problem << endl;
+      }
+    }
+  }
+  cout << kNumQueries << " queries, " << num_pages << " pages, "
+       << num_failures << " mismatches." << endl;
+  cout << "Pruned:  " << pruned_time.count() * 1000 << " ms" << endl;
+  cout << "Counted: " << counted_time.count() * 1000 << " ms" << endl;
+
+  return (num_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void Usage(char* prog_name) {
+  cerr << "Usage: " << prog_name << " index_files+" << endl;
+  exit(EXIT_FAILURE);
+}
+
+static vector<string> CommonWords(const string& index_file) {
+  auto source = hw3::OpenIndexFileSource(index_file, true, true);
+  hw3::TermDictView dict(source);
+  hw3::IndexTableView index(source);
+
+  vector<hw3::TermDictView::Term> terms;
+  dict.GetRange("", "", SIZE_MAX, &terms);
+  vector<pair<int64_t, string>> counted;
+  for (const hw3::TermDictView::Term& term : terms) {
+    unique_ptr<hw3::PostingsView> postings(index.LookupElement(term.second));
+    if (postings != nullptr) {
+      counted.emplace_back(-postings->num_docs(), term.first);
+    }
+  }
+  std::sort(counted.begin(), counted.end());
+
+  vector<string> words;
+  for (size_t i = 0; i < counted.size()
+       && i < static_cast<size_t>(kNumCommonWords); i++) {
+    words.push_back(counted[i].second);
+  }
+  return words;
+}
+
+static vector<string> MakeQuery(const vector<string>& words, mt19937* rng) {
+  uniform_int_distribution<size_t> word_dist(0, words.size() - 1);
+  const string a = words[word_dist(*rng)];
+  const string b = words[word_dist(*rng)];
+  const string c = words[word_dist(*rng)];
+  switch (uniform_int_distribution<int>(0, 5)(*rng)) {
+    case 0:
+      return {a};
+    case 1:
+      return {a, b};
+    case 2:
+      return {a, "OR", b, "OR", c};
+    case 3:
+      return {a, "NOT", b};
+    case 4:
+      return {a.substr(0, 1) + "*"};
+    default:
+      return {"(" + a, "OR", b + ")", c};
+  }
+}
+
+static string QueryString(const vector<string>& query) {
+  string result;
+  for (const string& word : query) {
+    result += (result.empty() ? "" : " ") + word;
+  }
+  return result;
+}
+
+static bool SameResults(const vector<QueryProcessor::QueryResult>& got,
+                        const vector<QueryProcessor::QueryResult>& expected) {
+  if (got.size() != expected.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < got.size(); i++) {
+    if (got[i].document_name != expected[i].document_name
+        || got[i].rank != expected[i].rank) {
+      return false;
+    }
+  }
+  return true;
+}
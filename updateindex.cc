@@ -0,0 +1,91 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Spring Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <unistd.h>  // for sysconf()
+#include <cstdlib>   // for EXIT_SUCCESS, EXIT_FAILURE, atoi()
+#include <cstring>   // for strcmp()
+#include <iostream>  // for std::cout, std::cerr, etc.
+
+#include "./IncrementalIndex.h"
+#include "./IndexWatcher.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+// Error usage message for the client to see
+// Arguments:
+// - prog_name: Name of the program
+static void Usage(char* prog_name);
+
+// How long --watch waits for changes to die down before updating.
+static const int kSettleMs = 500;
+
+// Brings an index of a directory tree up to date, re-indexing only the
+// files that have changed since the last run (see IncrementalIndex.h):
+//
+//   ./updateindex [--full | --watch] [-j workers] [-m budget_mb]
+//                 root_dir foo.idx
+//
+// The first run, or one given --full, builds foo.idx from scratch.  Later
+// runs write foo.delta.idx, which is searched together with foo.idx.
+// Given --watch, it keeps running, updating the index whenever files
+// under root_dir change (see IndexWatcher.h).
+int main(int argc, char** argv) {
+  bool full_rebuild = false, watch = false;
+  int num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t memory_budget = 0;
+
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "--full") == 0) {
+      full_rebuild = true;
+    } else if (strcmp(argv[i], "--watch") == 0) {
+      watch = true;
+    } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      num_workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+      memory_budget = static_cast<size_t>(atoi(argv[++i])) << 20;
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  if (argc - i != 2 || num_workers <= 0 || (full_rebuild && watch)) {
+    Usage(argv[0]);
+  }
+
+  if (watch) {
+    hw3::WatchIndex(argv[i], num_workers, memory_budget, kSettleMs,
+                    argv[i + 1]);
+    cerr << "Stopped watching " << argv[i] << "." << endl;
+    return EXIT_FAILURE;
+  }
+
+  int bytes = hw3::UpdateIndex(argv[i], num_workers, memory_budget,
+                               full_rebuild, argv[i + 1]);
+  if (bytes < 0) {
+    cerr << "Failed to update " << argv[i + 1] << "." << endl;
+    return EXIT_FAILURE;
+  }
+  if (bytes == 0) {
+    cout << argv[i + 1] << " is up to date." << endl;
+  } else {
+    cout << "Wrote " << bytes << " bytes." << endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+static void Usage(char* prog_name) {
+  cerr << "Usage: " << prog_name
+       << " [--full | --watch] [-j workers] [-m budget_mb]"
+       << " root_dir index_file" << endl;
+  exit(EXIT_FAILURE);
+}